@@ -0,0 +1,494 @@
+#include "Parser.h"
+#include "AST/ASTArena.h"
+#include "SourceManager.h"
+#include "Sema/Sema.h"
+#include "Sema/ModuleGraph.h"
+#include "MIR/MIRBuilder.h"
+#include "MIR/Passes.h"
+#include "Backend/CodeGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Compile-time benchmark: generates synthetic programs whose size grows with --scale,
+// runs them through every pipeline stage and reports lines/sec per stage plus the
+// process peak resident set. --baseline compares against an earlier --csv run.
+
+using namespace chtholly;
+
+namespace {
+
+const char* const stageNames[] = {"lex/parse", "sema", "mir", "irgen", "optimize", "emit"};
+constexpr size_t stageCount = sizeof(stageNames) / sizeof(stageNames[0]);
+
+struct Program {
+    std::string source;
+    // Imported modules are parsed and analyzed inside the sema stage, so their lines count too
+    size_t lines = 0;
+};
+
+struct Result {
+    std::string scenario;
+    size_t lines = 0;
+    double seconds[stageCount] = {};
+    size_t peakKiB = 0;
+    std::string error;
+};
+
+size_t countLines(const std::string& text) {
+    return std::count(text.begin(), text.end(), '\n');
+}
+
+// High-water mark of the whole process, not of one scenario; use --scenario to isolate one
+size_t peakResidentKiB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Thousands of non-generic functions with loops, branches and calls to earlier functions
+Program genFunctions(unsigned scale) {
+    unsigned count = 500 * scale;
+    std::ostringstream out;
+    out << "fn work0(x: i32): i32 { return x; }\n";
+    for (unsigned i = 1; i < count; ++i) {
+        out << "fn work" << i << "(x: i32): i32 {\n"
+            << "    let mut r: i32 = x;\n"
+            << "    for (let mut k: i32 = 0; k < " << (i % 7 + 2) << "; k = k + 1) {\n"
+            << "        r = r + k * " << (i % 5 + 1) << ";\n"
+            << "    }\n"
+            << "    if (r > 1000) {\n"
+            << "        r = r - 1000;\n"
+            << "    } else {\n"
+            << "        r = r + work" << (i / 2) << "(x);\n"
+            << "    }\n"
+            << "    return r + work" << (i - 1) << "(x);\n"
+            << "}\n";
+    }
+    out << "fn main(): i32 { return work" << (count - 1) << "(1); }\n";
+    return {out.str(), 0};
+}
+
+// Deep chains of generic functions, each instantiation pulling in the next one down
+Program genGenerics(unsigned scale) {
+    unsigned depth = 50 * scale;
+    unsigned chains = 4;
+    std::ostringstream out;
+    for (unsigned c = 0; c < chains; ++c) {
+        out << "fn c" << c << "g0[T](x: T): T { return x + x; }\n";
+        for (unsigned i = 1; i < depth; ++i) {
+            out << "fn c" << c << "g" << i << "[T](x: T): T { return c" << c << "g" << (i - 1)
+                << "[T](x) + x; }\n";
+        }
+    }
+    out << "fn main(): i32 {\n    let mut r: i32 = 0;\n";
+    for (unsigned c = 0; c < chains; ++c) {
+        out << "    r = r + c" << c << "g" << (depth - 1) << "[i32](" << (c + 1) << ");\n";
+    }
+    out << "    return r;\n}\n";
+    return {out.str(), 0};
+}
+
+// A handful of functions dominated by one very large integer switch each
+Program genSwitch(unsigned scale) {
+    unsigned cases = 500 * scale;
+    unsigned functions = 4;
+    std::ostringstream out;
+    for (unsigned f = 0; f < functions; ++f) {
+        out << "fn pick" << f << "(x: i32): i32 {\n    let mut r: i32 = 0;\n    switch (x) {\n";
+        for (unsigned i = 0; i < cases; ++i) {
+            out << "        case " << i << ": { r = " << ((i * 7 + f) % 97) << "; }\n";
+        }
+        out << "        default: { r = -1; }\n    }\n    return r;\n}\n";
+    }
+    out << "fn main(): i32 { return pick0(3) + pick" << (functions - 1) << "(5); }\n";
+    return {out.str(), 0};
+}
+
+// Many structs and payload-carrying enums, each consumed by a function matching every variant
+Program genStructs(unsigned scale) {
+    unsigned count = 100 * scale;
+    std::ostringstream out;
+    for (unsigned i = 0; i < count; ++i) {
+        out << "struct S" << i << " { let a: i32; let b: i32; let c: i32; }\n"
+            << "enum E" << i << " { A, B(i32), C(i32, i32) }\n"
+            << "fn use" << i << "(v: i32): i32 {\n"
+            << "    let s = S" << i << " { a: v, b: " << i << ", c: 2 };\n"
+            << "    let e = E" << i << "::C(s.a, s.b);\n"
+            << "    let mut r: i32 = s.c;\n"
+            << "    switch (e) {\n"
+            << "        case E" << i << "::A: { r = r + 1; }\n"
+            << "        case E" << i << "::B(x): { r = r + x; }\n"
+            << "        case E" << i << "::C(x, y): { r = r + x + y; }\n"
+            << "    }\n"
+            << "    return r;\n"
+            << "}\n";
+    }
+    out << "fn main(): i32 {\n    let mut r: i32 = 0;\n";
+    for (unsigned i = 0; i < count; i += std::max(1u, count / 16)) {
+        out << "    r = r + use" << i << "(" << i << ");\n";
+    }
+    out << "    return r;\n}\n";
+    return {out.str(), 0};
+}
+
+// A wide import graph written to disk: main imports every module, each module imports its
+// predecessor and a shared base, so loading also exercises the already-loaded check.
+// The modules are only analyzed and lowered, not called: main never names them.
+Program genImports(unsigned scale, const std::filesystem::path& dir) {
+    unsigned modules = 20 * scale;
+    unsigned functionsPerModule = 10;
+    std::filesystem::create_directories(dir);
+    auto modulePath = [&](const std::string& name) {
+        return (dir / (name + ".cns")).generic_string();
+    };
+
+    Program program;
+    auto writeModule = [&](const std::string& name, const std::string& text) {
+        std::ofstream file(modulePath(name), std::ios::binary);
+        file << text;
+        program.lines += countLines(text);
+    };
+
+    std::ostringstream base;
+    base << "pub fn base_f(x: i32): i32 { return x + 1; }\n";
+    writeModule("base", base.str());
+
+    for (unsigned m = 0; m < modules; ++m) {
+        std::ostringstream out;
+        out << "import \"" << modulePath("base") << "\";\n";
+        if (m > 0) out << "import \"" << modulePath("m" + std::to_string(m - 1)) << "\";\n";
+        for (unsigned i = 0; i < functionsPerModule; ++i) {
+            out << "pub fn m" << m << "_f" << i << "(x: i32): i32 {\n"
+                << "    let mut r: i32 = x;\n"
+                << "    for (let mut k: i32 = 0; k < " << (i + 2) << "; k = k + 1) {\n"
+                << "        r = r + k;\n"
+                << "    }\n"
+                << "    return r;\n"
+                << "}\n";
+        }
+        writeModule("m" + std::to_string(m), out.str());
+    }
+
+    std::ostringstream out;
+    for (unsigned m = modules; m-- > 0;) {
+        out << "import \"" << modulePath("m" + std::to_string(m)) << "\";\n";
+    }
+    out << "fn main(): i32 { return 0; }\n";
+    program.source = out.str();
+    return program;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// The front end logs progress to std::cout; that output would swamp the report and the timings
+class DiscardStdout : private std::streambuf {
+public:
+    DiscardStdout() : saved(std::cout.rdbuf(this)) {}
+    ~DiscardStdout() { std::cout.rdbuf(saved); }
+
+private:
+    int overflow(int c) override { return c; }
+
+    std::streambuf* saved;
+};
+
+double elapsed(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+}
+
+// Runs one program through the pipeline, recording the time of each stage
+void compileOnce(const Program& program, OptLevel optLevel, unsigned jobs, double (&seconds)[stageCount]) {
+    ASTArena astArena;
+    ASTArena::Scope astArenaScope(astArena);
+    TypeContext typeContext;
+    TypeContext::Scope typeContextScope(typeContext);
+    SourceManager sourceManager;
+    SourceManager::Scope sourceManagerScope(sourceManager);
+
+    auto start = Clock::now();
+    Parser parser(program.source);
+    auto nodes = parser.parseProgram();
+    seconds[0] = elapsed(start);
+
+    start = Clock::now();
+    ModuleGraph moduleGraph(jobs);
+    moduleGraph.build(nodes);
+    Sema sema;
+    sema.adoptModules(moduleGraph);
+    for (auto const& node : nodes) {
+        sema.analyze(node.get());
+    }
+    seconds[1] = elapsed(start);
+
+    start = Clock::now();
+    MIRModule module;
+    MIRBuilder mirBuilder(module);
+    for (auto const& [name, table] : sema.getModules()) {
+        mirBuilder.addModuleName(name);
+    }
+    for (ASTNode* node : sema.getModuleNodes()) {
+        mirBuilder.lower(node);
+    }
+    for (auto const& node : sema.getAnalyzedNodes()) {
+        mirBuilder.lower(node.get());
+    }
+    for (auto const& node : nodes) {
+        mirBuilder.lower(node.get());
+    }
+    PassManager passManager;
+    addDefaultPasses(passManager);
+    passManager.run(module);
+    seconds[2] = elapsed(start);
+
+    CodeGenerator codegen(module);
+    codegen.setOptLevel(optLevel);
+    start = Clock::now();
+    codegen.generate();
+    seconds[3] = elapsed(start);
+
+    start = Clock::now();
+    if (!codegen.prepareModule()) throw std::runtime_error("module failed verification");
+    seconds[4] = elapsed(start);
+
+    start = Clock::now();
+    llvm::SmallVector<char, 0> object;
+    if (!codegen.emitObjectToBuffer(object)) throw std::runtime_error("object emission failed");
+    seconds[5] = elapsed(start);
+}
+
+Result runScenario(const std::string& name, const Program& program, OptLevel optLevel, unsigned jobs, unsigned repeat) {
+    Result result;
+    result.scenario = name;
+    result.lines = program.lines + countLines(program.source);
+    std::fill(std::begin(result.seconds), std::end(result.seconds), -1.0);
+
+    try {
+        DiscardStdout quiet;
+        for (unsigned r = 0; r < repeat; ++r) {
+            double seconds[stageCount] = {};
+            compileOnce(program, optLevel, jobs, seconds);
+            // Best of the repeats is the least noisy estimate of each stage
+            for (size_t s = 0; s < stageCount; ++s) {
+                if (result.seconds[s] < 0 || seconds[s] < result.seconds[s]) result.seconds[s] = seconds[s];
+            }
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    result.peakKiB = peakResidentKiB();
+    return result;
+}
+
+double linesPerSecond(const Result& result, size_t stage) {
+    double seconds = result.seconds[stage];
+    return seconds > 0 ? result.lines / seconds : 0;
+}
+
+void printResult(const Result& result) {
+    if (!result.error.empty()) {
+        std::cout << std::left << std::setw(10) << result.scenario << " FAILED: " << result.error << "\n";
+        return;
+    }
+    for (size_t s = 0; s < stageCount; ++s) {
+        std::cout << std::left << std::setw(10) << (s == 0 ? result.scenario : "")
+                  << std::right << std::setw(9) << (s == 0 ? std::to_string(result.lines) : "")
+                  << "  " << std::left << std::setw(10) << stageNames[s]
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(11) << result.seconds[s] * 1000.0
+                  << std::setw(14) << std::setprecision(0) << linesPerSecond(result, s);
+        if (s == 0) std::cout << std::setw(12) << std::setprecision(1) << result.peakKiB / 1024.0;
+        std::cout << "\n";
+    }
+}
+
+void writeCsv(const std::vector<Result>& results, const std::string& path) {
+    std::ofstream out(path);
+    out << "scenario,stage,lines,seconds,lines_per_sec,peak_kib\n";
+    for (const auto& result : results) {
+        if (!result.error.empty()) continue;
+        for (size_t s = 0; s < stageCount; ++s) {
+            out << result.scenario << "," << stageNames[s] << "," << result.lines << ","
+                << result.seconds[s] << "," << linesPerSecond(result, s) << "," << result.peakKiB << "\n";
+        }
+    }
+}
+
+// Reads a --csv file back as "scenario/stage" -> {lines/sec, seconds}
+std::map<std::string, std::pair<double, double>> readBaseline(const std::string& path) {
+    std::map<std::string, std::pair<double, double>> baseline;
+    std::ifstream in(path);
+    if (!in.is_open()) throw std::runtime_error("Could not open baseline: " + path);
+
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::stringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ',')) fields.push_back(field);
+        if (fields.size() < 5) continue;
+        baseline[fields[0] + "/" + fields[1]] = {std::strtod(fields[4].c_str(), nullptr),
+                                                 std::strtod(fields[3].c_str(), nullptr)};
+    }
+    return baseline;
+}
+
+// Reports every stage whose throughput fell by more than the tolerance; returns the count
+int checkBaseline(const std::vector<Result>& results, const std::string& path, double tolerance) {
+    auto baseline = readBaseline(path);
+    int regressions = 0;
+    for (const auto& result : results) {
+        if (!result.error.empty()) {
+            std::cout << "REGRESSION " << result.scenario << ": compilation failed\n";
+            regressions++;
+            continue;
+        }
+        for (size_t s = 0; s < stageCount; ++s) {
+            auto it = baseline.find(result.scenario + "/" + stageNames[s]);
+            if (it == baseline.end()) continue;
+            auto [oldRate, oldSeconds] = it->second;
+            // Stages this short are dominated by timer and scheduler noise
+            if (oldSeconds < 0.005 && result.seconds[s] < 0.005) continue;
+            double rate = linesPerSecond(result, s);
+            if (rate < oldRate * (1.0 - tolerance / 100.0)) {
+                std::cout << "REGRESSION " << result.scenario << "/" << stageNames[s] << ": "
+                          << std::fixed << std::setprecision(0) << rate << " lines/s, baseline "
+                          << oldRate << " lines/s\n";
+                regressions++;
+            }
+        }
+    }
+    return regressions;
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--scale=<N>] [--scenario=<name>[,<name>...]] [--repeat=<N>] [-O0|-O1|-O2|-O3] [-j<N>]"
+              << " [--csv=<file>] [--baseline=<file>] [--tolerance=<percent>] [--dump=<dir>]\n"
+              << "Scenarios: functions, generics, switch, structs, imports\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned scale = 1;
+    unsigned repeat = 3;
+    OptLevel optLevel = OptLevel::O0;
+    unsigned jobs = 1;
+    std::vector<std::string> selected;
+    std::string csvPath;
+    std::string baselinePath;
+    double tolerance = 10.0;
+    std::string dumpDir;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.starts_with("--scale=")) {
+            scale = std::max(1ul, std::strtoul(arg.c_str() + 8, nullptr, 10));
+        } else if (arg.starts_with("--repeat=")) {
+            repeat = std::max(1ul, std::strtoul(arg.c_str() + 9, nullptr, 10));
+        } else if (arg.starts_with("--scenario=")) {
+            std::stringstream names(arg.substr(11));
+            std::string name;
+            while (std::getline(names, name, ',')) selected.push_back(name);
+        } else if (arg.starts_with("-j")) {
+            jobs = std::max(1ul, std::strtoul(arg.c_str() + 2, nullptr, 10));
+        } else if (arg == "-O0") {
+            optLevel = OptLevel::O0;
+        } else if (arg == "-O1") {
+            optLevel = OptLevel::O1;
+        } else if (arg == "-O2") {
+            optLevel = OptLevel::O2;
+        } else if (arg == "-O3") {
+            optLevel = OptLevel::O3;
+        } else if (arg.starts_with("--csv=")) {
+            csvPath = arg.substr(6);
+        } else if (arg.starts_with("--baseline=")) {
+            baselinePath = arg.substr(11);
+        } else if (arg.starts_with("--tolerance=")) {
+            tolerance = std::strtod(arg.c_str() + 12, nullptr);
+        } else if (arg.starts_with("--dump=")) {
+            dumpDir = arg.substr(7);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto importDir = std::filesystem::temp_directory_path() / ("chtholly_bench_imports_" + std::to_string(scale));
+    std::vector<std::pair<std::string, std::function<Program()>>> scenarios = {
+        {"functions", [&] { return genFunctions(scale); }},
+        {"generics", [&] { return genGenerics(scale); }},
+        {"switch", [&] { return genSwitch(scale); }},
+        {"structs", [&] { return genStructs(scale); }},
+        {"imports", [&] { return genImports(scale, dumpDir.empty() ? importDir : std::filesystem::path(dumpDir)); }},
+    };
+
+    for (const auto& name : selected) {
+        bool known = std::any_of(scenarios.begin(), scenarios.end(), [&](const auto& s) { return s.first == name; });
+        if (!known) {
+            std::cerr << "Unknown scenario: " << name << "\n";
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "scale " << scale << ", best of " << repeat << "\n";
+    std::cout << "scenario       lines  stage       time (ms)   lines/sec  peak (MiB)\n";
+
+    std::vector<Result> results;
+    for (const auto& [name, generate] : scenarios) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), name) == selected.end()) continue;
+
+        Program program = generate();
+        if (!dumpDir.empty()) {
+            std::filesystem::create_directories(dumpDir);
+            std::ofstream(std::filesystem::path(dumpDir) / (name + ".cns"), std::ios::binary) << program.source;
+        }
+        results.push_back(runScenario(name, program, optLevel, jobs, repeat));
+        printResult(results.back());
+    }
+
+    if (!csvPath.empty()) writeCsv(results, csvPath);
+
+    bool failed = std::any_of(results.begin(), results.end(), [](const Result& r) { return !r.error.empty(); });
+    if (!baselinePath.empty()) {
+        try {
+            int regressions = checkBaseline(results, baselinePath, tolerance);
+            if (regressions > 0) {
+                std::cout << regressions << " stage(s) regressed by more than " << tolerance << "%\n";
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return failed ? 1 : 0;
+}
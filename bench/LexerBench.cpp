@@ -0,0 +1,82 @@
+#include "Lexer/TokenStream.h"
+#include "Lexer/CharScan.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Lexer microbenchmark: tokenizes a synthetic source of --size MiB with each character-scan
+// implementation the CPU supports and reports MB/s. "scalar" is the per-character baseline.
+
+using namespace chtholly;
+
+namespace {
+
+// Deep indentation, long identifiers, comments and string literals: the runs the kernels skip in bulk
+std::string genSource(size_t bytes) {
+    std::ostringstream out;
+    for (unsigned i = 0; static_cast<size_t>(out.tellp()) < bytes; ++i) {
+        out << "/* function " << i << " of the generated lexer workload */\n"
+            << "fn generated_function_number_" << i << "(first_argument: i32, second_argument: i32): i32 {\n"
+            << "        // accumulate both arguments into a local before returning it\n"
+            << "        let mut accumulated_value: i32 = first_argument + second_argument * " << (i % 97) << ";\n"
+            << "        let message = \"generated function " << i << " says hello, \\\"world\\\"\\n\";\n"
+            << "        if (accumulated_value > 1000) {\n"
+            << "                accumulated_value = accumulated_value - 1000;\n"
+            << "        }\n"
+            << "        return accumulated_value;\n"
+            << "}\n\n";
+    }
+    return out.str();
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--size=<MiB>] [--repeat=<N>]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t sizeMiB = 16;
+    unsigned repeat = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.starts_with("--size=")) {
+            sizeMiB = std::max(1ul, std::strtoul(arg.c_str() + 7, nullptr, 10));
+        } else if (arg.starts_with("--repeat=")) {
+            repeat = std::max(1ul, std::strtoul(arg.c_str() + 9, nullptr, 10));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::string source = genSource(sizeMiB << 20);
+    std::cout << "source " << std::fixed << std::setprecision(1) << source.size() / 1048576.0
+              << " MiB, best of " << repeat << "\n";
+    std::cout << "impl        tokens   time (ms)      MB/s  speedup\n";
+
+    const charscan::ScanImpl impls[] = {charscan::ScanImpl::Scalar, charscan::ScanImpl::SSE2, charscan::ScanImpl::AVX2};
+    double scalarSeconds = 0;
+    for (auto impl : impls) {
+        if (!charscan::setImpl(impl)) continue;
+        double best = 1e30;
+        size_t tokens = 0;
+        for (unsigned r = 0; r < repeat; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            TokenStream stream(source);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            tokens = stream.size();
+        }
+        if (impl == charscan::ScanImpl::Scalar) scalarSeconds = best;
+        std::cout << std::left << std::setw(8) << charscan::implName(impl) << std::right
+                  << std::setw(10) << tokens
+                  << std::setw(12) << std::setprecision(2) << best * 1000.0
+                  << std::setw(10) << std::setprecision(1) << source.size() / best / 1e6
+                  << std::setw(8) << std::setprecision(2) << scalarSeconds / best << "x\n";
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef CHTHOLLY_ASTARENA_H
+#define CHTHOLLY_ASTARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace chtholly {
+
+// Bump allocator for AST nodes. While a Scope is active on a thread, every
+// ASTNode created there is carved out of the arena; deleting such a node only
+// runs its destructor, and the memory is released in bulk with the arena.
+// The arena must outlive every node allocated from it.
+class ASTArena {
+public:
+    ASTArena() = default;
+    ~ASTArena();
+
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t align);
+
+    std::size_t getBytesAllocated() const { return bytesAllocated; }
+    std::size_t getBytesReserved() const { return bytesReserved; }
+
+    static ASTArena* current();
+
+    class Scope {
+    public:
+        explicit Scope(ASTArena& arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ASTArena* previous;
+    };
+
+private:
+    static constexpr std::size_t SlabSize = 64 * 1024;
+
+    std::vector<char*> slabs;
+    char* cursor = nullptr;
+    char* end = nullptr;
+    std::size_t bytesAllocated = 0;
+    std::size_t bytesReserved = 0;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_ASTARENA_H
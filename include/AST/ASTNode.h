@@ -4,10 +4,18 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstddef>
 #include "AST/Types.h"
 
 namespace chtholly {
 
+// What an `inline` or `noinline` modifier asks of the MIR inliner
+enum class InlineHint {
+    None,
+    Always,
+    Never
+};
+
 enum class ASTNodeKind {
     VarDecl,
     StructDecl,
@@ -63,6 +71,10 @@ public:
 
     virtual const std::string& getName() const { static std::string empty = ""; return empty; }
     virtual std::shared_ptr<Type> getType() const { return nullptr; }
+
+    // Nodes come from the thread's active ASTArena when there is one, see AST/ASTArena.h
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr);
 };
 
 } // namespace chtholly
@@ -51,6 +51,13 @@ public:
         return result;
     }
 
+    // Struct and enum fields are public by definition, so they print in the form the parser reads back
+    std::string toFieldString() const {
+        std::string result = m_isMutable ? "let mut " : "let ";
+        result += name + ": " + (type ? type->toString() : "unknown");
+        return result;
+    }
+
 private:
     std::string name;
     std::shared_ptr<Type> type;
@@ -102,6 +109,14 @@ struct GenericParam {
     }
 };
 
+inline const char* inlineHintPrefix(InlineHint hint) {
+    switch (hint) {
+        case InlineHint::Always: return "inline ";
+        case InlineHint::Never: return "noinline ";
+        default: return "";
+    }
+}
+
 class FunctionDecl : public Decl {
 public:
     FunctionDecl(std::string name, std::shared_ptr<Type> returnType, std::vector<std::unique_ptr<Param>> params, std::unique_ptr<Block> body, bool isExtern = false, bool isPublic = false, std::vector<GenericParam> genericParams = {}) 
@@ -117,11 +132,13 @@ public:
         for (const auto& gp : genericParams) newGParams.push_back(gp);
         auto res = std::make_unique<FunctionDecl>(name, returnType, std::move(newParams), std::move(newBody), isExtern, isPublic, std::move(newGParams));
         res->setVarArg(isVarArg);
+        res->setInlineHint(inlineHint);
         return std::unique_ptr<Decl>(res.release());
     }
 
     std::string toString() const override {
         std::string res = isPublic ? "pub " : "";
+        res += inlineHintPrefix(inlineHint);
         res += isExtern ? "extern fn " : "fn ";
         res += name;
         if (!genericParams.empty()) {
@@ -162,10 +179,13 @@ public:
     void setVarArg(bool v) { isVarArg = v; }
     bool getVarArg() const { return isVarArg; }
 
+    void setInlineHint(InlineHint hint) { inlineHint = hint; }
+    InlineHint getInlineHint() const { return inlineHint; }
+
     std::shared_ptr<Type> getType() const override {
         std::vector<std::shared_ptr<Type>> paramTypes;
         for (const auto& p : params) paramTypes.push_back(p->getType());
-        return std::make_shared<FunctionType>(std::move(paramTypes), returnType, isVarArg);
+        return FunctionType::get(std::move(paramTypes), returnType, isVarArg);
     }
 
 private:
@@ -176,6 +196,7 @@ private:
     bool isExtern;
     bool isPublic;
     bool isVarArg;
+    InlineHint inlineHint = InlineHint::None;
     std::vector<GenericParam> genericParams;
 };
 
@@ -192,11 +213,15 @@ public:
         auto newBody = body ? std::unique_ptr<Block>(static_cast<Block*>(body->cloneStmt().release())) : nullptr;
         std::vector<GenericParam> newGParams;
         for (const auto& gp : genericParams) newGParams.push_back(gp);
-        return std::unique_ptr<Stmt>(std::make_unique<MethodDecl>(name, returnType, std::move(newParams), std::move(newBody), m_isPublic, std::move(newGParams)).release());
+        auto res = std::make_unique<MethodDecl>(name, returnType, std::move(newParams), std::move(newBody), m_isPublic, std::move(newGParams));
+        res->setInlineHint(inlineHint);
+        return std::unique_ptr<Stmt>(res.release());
     }
 
     std::string toString() const override {
-        std::string res = m_isPublic ? "pub fn " : "fn ";
+        std::string res = m_isPublic ? "pub " : "";
+        res += inlineHintPrefix(inlineHint);
+        res += "fn ";
         res += name;
         if (!genericParams.empty()) {
             res += "[";
@@ -227,12 +252,16 @@ public:
     const std::vector<GenericParam>& getGenericParams() const { return genericParams; }
     void clearGenericParams() { genericParams.clear(); }
 
+    void setInlineHint(InlineHint hint) { inlineHint = hint; }
+    InlineHint getInlineHint() const { return inlineHint; }
+
 private:
     std::string name;
     std::shared_ptr<Type> returnType;
     std::vector<std::unique_ptr<Param>> params;
     std::unique_ptr<Block> body;
     bool m_isPublic;
+    InlineHint inlineHint = InlineHint::None;
     std::vector<GenericParam> genericParams;
 };
 
@@ -309,7 +338,7 @@ public:
         }
         res += " {\n";
         for (const auto& member : members) {
-            res += "  " + member->toString() + ";\n";
+            res += "  " + member->toFieldString() + ";\n";
         }
         res += "}";
         return res;
@@ -424,7 +453,7 @@ public:
         } else if (m_variantKind == VariantKind::Struct) {
             res += " { ";
             for (size_t i = 0; i < structFields.size(); ++i) {
-                res += structFields[i]->toString();
+                res += structFields[i]->toFieldString();
                 if (i < structFields.size() - 1) res += ", ";
             }
             res += " }";
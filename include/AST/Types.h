@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 namespace chtholly {
 
@@ -38,6 +39,7 @@ public:
     virtual std::shared_ptr<Type> substitute(const std::map<std::string, std::shared_ptr<Type>>& mapping) const = 0;
 
     virtual bool equals(const Type& other) const {
+        if (this == &other) return true;
         if (getKind() != other.getKind()) return false;
         return toString() == other.toString(); // Fallback for complex types
     }
@@ -66,6 +68,7 @@ public:
     bool isBoolean() const { return getKind() == TypeKind::Bool; }
     bool isBool() const { return isBoolean(); }
     bool isVoid() const { return getKind() == TypeKind::Void; }
+    bool isPrimitive() const { return isInteger() || isFloatingPoint() || isBoolean() || isVoid(); }
     bool isFunction() const { return getKind() == TypeKind::Function; }
     bool isPointer() const { return getKind() == TypeKind::Pointer; }
     bool isArray() const { return getKind() == TypeKind::Array; }
@@ -147,15 +150,20 @@ class PointerType : public Type {
 public:
     PointerType(std::shared_ptr<Type> baseType) : baseType(baseType) {}
 
+    static std::shared_ptr<PointerType> get(const std::shared_ptr<Type>& baseType);
+
     TypeKind getKind() const override { return TypeKind::Pointer; }
     std::string toString() const override {
         return baseType->toString() + "*";
     }
     std::shared_ptr<Type> substitute(const std::map<std::string, std::shared_ptr<Type>>& mapping) const override {
-        return std::make_shared<PointerType>(baseType->substitute(mapping));
+        auto newBase = baseType->substitute(mapping);
+        if (newBase == baseType) return std::const_pointer_cast<Type>(shared_from_this());
+        return get(newBase);
     }
 
     bool equals(const Type& other) const override {
+        if (this == &other) return true;
         if (other.getKind() != TypeKind::Pointer) return false;
         return baseType->equals(*static_cast<const PointerType&>(other).baseType);
     }
@@ -171,15 +179,20 @@ public:
     ArrayType(std::shared_ptr<Type> baseType, int size)
         : baseType(baseType), size(size) {}
 
+    static std::shared_ptr<ArrayType> get(const std::shared_ptr<Type>& baseType, int size);
+
     TypeKind getKind() const override { return TypeKind::Array; }
     std::string toString() const override {
         return baseType->toString() + "[" + std::to_string(size) + "]";
     }
     std::shared_ptr<Type> substitute(const std::map<std::string, std::shared_ptr<Type>>& mapping) const override {
-        return std::make_shared<ArrayType>(baseType->substitute(mapping), size);
+        auto newBase = baseType->substitute(mapping);
+        if (newBase == baseType) return std::const_pointer_cast<Type>(shared_from_this());
+        return get(newBase, size);
     }
 
     bool equals(const Type& other) const override {
+        if (this == &other) return true;
         if (other.getKind() != TypeKind::Array) return false;
         auto& o = static_cast<const ArrayType&>(other);
         return size == o.size && baseType->equals(*o.baseType);
@@ -198,6 +211,8 @@ public:
     FunctionType(std::vector<std::shared_ptr<Type>> params, std::shared_ptr<Type> returnType, bool isVariadic = false)
         : params(std::move(params)), returnType(returnType), isVariadic(isVariadic) {}
 
+    static std::shared_ptr<FunctionType> get(const std::vector<std::shared_ptr<Type>>& params, const std::shared_ptr<Type>& returnType, bool isVariadic = false);
+
     TypeKind getKind() const override { return TypeKind::Function; }
     std::string toString() const override {
         std::string result = "(";
@@ -213,12 +228,19 @@ public:
         return result;
     }
     std::shared_ptr<Type> substitute(const std::map<std::string, std::shared_ptr<Type>>& mapping) const override {
+        bool changed = false;
         std::vector<std::shared_ptr<Type>> newParams;
-        for (const auto& p : params) newParams.push_back(p->substitute(mapping));
-        return std::make_shared<FunctionType>(std::move(newParams), returnType->substitute(mapping), isVariadic);
+        for (const auto& p : params) {
+            newParams.push_back(p->substitute(mapping));
+            changed |= newParams.back() != p;
+        }
+        auto newReturn = returnType->substitute(mapping);
+        if (!changed && newReturn == returnType) return std::const_pointer_cast<Type>(shared_from_this());
+        return get(newParams, newReturn, isVariadic);
     }
 
     bool equals(const Type& other) const override {
+        if (this == &other) return true;
         if (other.getKind() != TypeKind::Function) return false;
         auto& o = static_cast<const FunctionType&>(other);
         if (isVariadic != o.isVariadic || params.size() != o.params.size()) return false;
@@ -261,6 +283,10 @@ public:
 
     TypeKind getKind() const override { return TypeKind::Struct; }
     std::string toString() const override { return name; }
+    bool equals(const Type& other) const override {
+        if (this == &other) return true;
+        return other.getKind() == TypeKind::Struct && name == static_cast<const StructType&>(other).name;
+    }
     std::shared_ptr<Type> substitute(const std::map<std::string, std::shared_ptr<Type>>& mapping) const override {
         if (mapping.count(name)) return mapping.at(name);
         // Struct monomorphization is complex because it creates a new StructType
@@ -310,6 +336,10 @@ public:
 
     TypeKind getKind() const override { return TypeKind::Enum; }
     std::string toString() const override { return name; }
+    bool equals(const Type& other) const override {
+        if (this == &other) return true;
+        return other.getKind() == TypeKind::Enum && name == static_cast<const EnumType&>(other).name;
+    }
     std::shared_ptr<Type> substitute(const std::map<std::string, std::shared_ptr<Type>>&) const override {
         return std::const_pointer_cast<Type>(shared_from_this());
     }
@@ -356,6 +386,65 @@ private:
     std::string constraintName;
 };
 
+// Uniques structural types for one compilation, so building the same pointer,
+// array or function type twice yields the same node. While a Scope is active on
+// a thread, PointerType::get, ArrayType::get and FunctionType::get intern through
+// that context; without one they allocate a fresh node, so codegen workers never
+// share it and it needs no lock.
+//
+// Uniqueness is by component identity. Structs and enums are nominal and are not
+// interned (parser placeholders must stay distinct from the resolved declaration),
+// so two Point nodes give two distinct Point* nodes. equals() therefore stays
+// structural; pointer identity is only a fast path for "equal".
+class TypeContext {
+public:
+    TypeContext();
+
+    TypeContext(const TypeContext&) = delete;
+    TypeContext& operator=(const TypeContext&) = delete;
+
+    std::shared_ptr<PointerType> getPointerType(const std::shared_ptr<Type>& baseType);
+    std::shared_ptr<ArrayType> getArrayType(const std::shared_ptr<Type>& baseType, int size);
+    std::shared_ptr<FunctionType> getFunctionType(const std::vector<std::shared_ptr<Type>>& params, const std::shared_ptr<Type>& returnType, bool isVariadic);
+
+    static TypeContext* current();
+
+    class Scope {
+    public:
+        explicit Scope(TypeContext& context);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TypeContext* previous;
+    };
+
+private:
+    struct ArrayKey {
+        const Type* base;
+        int size;
+        bool operator==(const ArrayKey& o) const { return base == o.base && size == o.size; }
+    };
+    struct FunctionKey {
+        std::vector<const Type*> params;
+        const Type* returnType;
+        bool isVariadic;
+        bool operator==(const FunctionKey& o) const {
+            return params == o.params && returnType == o.returnType && isVariadic == o.isVariadic;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const ArrayKey& key) const;
+        size_t operator()(const FunctionKey& key) const;
+    };
+
+    std::unordered_map<const Type*, std::shared_ptr<PointerType>> pointerTypes;
+    std::unordered_map<ArrayKey, std::shared_ptr<ArrayType>, KeyHash> arrayTypes;
+    std::unordered_map<FunctionKey, std::shared_ptr<FunctionType>, KeyHash> functionTypes;
+};
+
 } // namespace chtholly
 
 #endif // CHTHOLLY_TYPES_H
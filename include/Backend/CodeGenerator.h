@@ -6,31 +6,82 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
 #include <map>
+#include <set>
+
+namespace llvm {
+class TargetMachine;
+class raw_pwrite_stream;
+}
 
 namespace chtholly {
 
+enum class OptLevel {
+    O0,
+    O1,
+    O2,
+    O3
+};
+
 class CodeGenerator {
 public:
     CodeGenerator(MIRModule& mirModule);
+    ~CodeGenerator();
 
     void generate();
-    void emitObjectFile(const std::string& filename);
-    
+    // Restricts generate() to these function bodies; the rest are only declared and resolved at link time
+    void setPartition(std::set<const MIRFunction*> functions) { partition = std::move(functions); }
+    // Sets the target, verifies and optimizes the module; idempotent
+    bool prepareModule();
+    bool emitObjectFile(const std::string& filename);
+    // Emits the object into memory, e.g. for handing straight to the Linker
+    bool emitObjectToBuffer(llvm::SmallVectorImpl<char>& buffer);
+
+    void setOptLevel(OptLevel level) { optLevel = level; }
+    OptLevel getOptLevel() const { return optLevel; }
+
+    // "native" selects the host CPU and its detected features
+    void setTargetCPU(const std::string& cpu) { targetCPU = cpu; }
+    // Comma-separated feature list, e.g. "+avx2,-avx512f"
+    void setTargetFeatures(const std::string& features) { targetFeatures = features; }
+    std::string resolveTargetCPU() const;
+    std::string resolveTargetFeatures() const;
+
     llvm::Value* getOrCreateGlobalString(const std::string& str);
 
     llvm::Module& getLLVMModule() { return *llvmModule; }
+    llvm::TargetMachine* getTargetMachine() { return targetMachine.get(); }
+    // Reuses a target machine created for the same CPU, features and optimization level,
+    // e.g. one a --serve process keeps between builds; must be set before prepareModule
+    void setTargetMachine(std::shared_ptr<llvm::TargetMachine> machine) { targetMachine = std::move(machine); }
+    std::shared_ptr<llvm::TargetMachine> shareTargetMachine() const { return targetMachine; }
+
+    // Hands the module and its context over, e.g. to the JIT; the generator is unusable afterwards
+    std::unique_ptr<llvm::Module> takeLLVMModule() { return std::move(llvmModule); }
+    std::unique_ptr<llvm::LLVMContext> takeLLVMContext() { return std::move(context); }
 
 private:
     void generateFunction(MIRFunction* mirFunc);
     llvm::Type* getLLVMType(Type* chthollyType);
+    llvm::AllocaInst* createEntryBlockAlloca(llvm::Function* func, llvm::Type* type, const std::string& name);
+    void runOptimizationPipeline(llvm::TargetMachine* targetMachine);
+    bool emitObject(llvm::raw_pwrite_stream& dest);
 
     MIRModule& mirModule;
+    OptLevel optLevel = OptLevel::O0;
+    std::string targetCPU;
+    std::string targetFeatures;
+    std::set<const MIRFunction*> partition;
     std::unique_ptr<llvm::LLVMContext> context;
     std::unique_ptr<llvm::Module> llvmModule;
     std::unique_ptr<llvm::IRBuilder<>> builder;
+    std::shared_ptr<llvm::TargetMachine> targetMachine;
+    bool prepared = false;
     
-    std::map<std::string, llvm::Value*> valueMap;
-    std::map<std::string, std::shared_ptr<Type>> mirTypeMap;
+    // Indexed by the current function's ValueIDs
+    std::vector<llvm::Value*> values;
+    std::vector<std::shared_ptr<Type>> valueTypes;
+    // Declaration for each of the MIR module's function IDs, so calls need no name lookup
+    std::vector<llvm::Function*> functionsByID;
     std::map<std::string, llvm::StructType*> structMap;
     std::map<std::string, std::shared_ptr<StructType>> structDefMap;
     std::map<std::string, llvm::StructType*> enumMap;
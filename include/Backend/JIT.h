@@ -0,0 +1,35 @@
+#ifndef CHTHOLLY_JIT_H
+#define CHTHOLLY_JIT_H
+
+#include "Backend/CodeGenerator.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm::orc {
+class LLJIT;
+}
+
+namespace chtholly {
+
+class JIT {
+public:
+    JIT();
+    ~JIT();
+
+    // Compiles the generated module in-process with ORC LLJIT and calls its main.
+    // Takes ownership of the module; returns main's exit code.
+    int runMain(CodeGenerator& codegen, const std::string& programName, const std::vector<std::string>& args = {});
+
+private:
+    using MainFn = int (*)(int, char*[]);
+    // Builds the LLJIT and materializes main; timed as the "JIT compile" phase
+    MainFn compileMain(CodeGenerator& codegen, const std::string& programName);
+
+    // Keeps the compiled code alive while main runs
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_JIT_H
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
 
 namespace chtholly {
 
@@ -11,12 +13,20 @@ class Linker {
 public:
     Linker();
     bool invoke(const std::string& objFile, const std::string& exeFile);
+    bool invoke(const std::vector<std::string>& objFiles, const std::string& exeFile);
+    // Links an object held in memory; it only touches disk as a temporary handed to the driver
+    bool invoke(llvm::ArrayRef<char> object, const std::string& exeFile);
+    // One object per codegen partition, all handed to a single link
+    bool invoke(const std::vector<llvm::SmallVector<char, 0>>& objects, const std::string& exeFile);
 
 private:
     bool loadToolPaths();
+    bool findDriver();
+    bool writeTemporaryObject(llvm::ArrayRef<char> object, std::string& objPath);
     std::string findFile(const std::string& filename);
 
     std::string m_linkerPath;
+    std::string m_driverPath;
     std::vector<std::string> m_libPaths;
 };
 
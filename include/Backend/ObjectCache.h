@@ -0,0 +1,54 @@
+#ifndef CHTHOLLY_OBJECTCACHE_H
+#define CHTHOLLY_OBJECTCACHE_H
+
+#include "MIR/MIR.h"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace chtholly {
+
+// Computes content keys for the functions of one module. A key covers everything
+// that decides a function's machine code: its MIR with every operand, the layout
+// of each struct and enum it reaches (resolved by name the way CodeGenerator does,
+// signatures first), the signatures of the functions it calls, and `settings`
+// (target, optimization level, compiler build).
+class FunctionFingerprinter {
+public:
+    FunctionFingerprinter(const MIRModule& mirModule, std::string settings);
+
+    uint64_t fingerprint(const MIRFunction& func) const;
+
+private:
+    std::unordered_map<std::string, const MIRFunction*> functions;
+    // First struct or enum node per name met while declaring every function, as codegen declares them
+    std::unordered_map<std::string, const Type*> signatureTypes;
+    std::string settings;
+};
+
+// On-disk store of per-function objects, one "<fingerprint>.o" file each. A lookup
+// that misses or cannot read the file is just a miss; a failed store costs only
+// the reuse, since the object in memory is still good for the current link.
+class ObjectCache {
+public:
+    explicit ObjectCache(std::string dir);
+
+    bool lookup(uint64_t key, llvm::SmallVectorImpl<char>& object) const;
+    bool store(uint64_t key, llvm::ArrayRef<char> object) const;
+
+    const std::string& getDirectory() const { return dir; }
+
+    // Identifies the running compiler binary, so objects built by another one are never reused
+    static std::string compilerStamp();
+
+private:
+    std::string pathFor(uint64_t key) const;
+
+    std::string dir;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_OBJECTCACHE_H
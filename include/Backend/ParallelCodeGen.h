@@ -0,0 +1,55 @@
+#ifndef CHTHOLLY_PARALLELCODEGEN_H
+#define CHTHOLLY_PARALLELCODEGEN_H
+
+#include "Backend/CodeGenerator.h"
+#include <llvm/ADT/SmallVector.h>
+#include <string>
+#include <vector>
+
+namespace chtholly {
+
+class ObjectCache;
+
+// Splits a MIR module into partitions and lowers, optimizes and emits each one
+// on its own thread with a private LLVMContext. Calls across partitions are left
+// as external declarations for the linker to resolve.
+//
+// With an ObjectCache, every function body becomes its own object keyed by its
+// fingerprint: cached objects are reused as they are and only functions whose
+// fingerprint changed are compiled, still up to `jobs` at a time. Functions are
+// then optimized one at a time, so nothing is inlined across them.
+class ParallelCodeGen {
+public:
+    ParallelCodeGen(MIRModule& mirModule, unsigned jobs);
+
+    void setOptLevel(OptLevel level) { optLevel = level; }
+    void setTargetCPU(const std::string& cpu) { targetCPU = cpu; }
+    void setTargetFeatures(const std::string& features) { targetFeatures = features; }
+    void setObjectCache(const ObjectCache* cache) { objectCache = cache; }
+
+    // Groups function bodies into at most `jobs` partitions of roughly equal instruction count
+    std::vector<std::set<const MIRFunction*>> partition() const;
+
+    // Fills one object per partition, in partition order, or one per function body with an object cache
+    bool emitObjects(std::vector<llvm::SmallVector<char, 0>>& objects);
+
+    // Bodies taken from the object cache by the last emitObjects, out of getNumFunctions()
+    size_t getNumReused() const { return numReused; }
+    size_t getNumFunctions() const { return numFunctions; }
+
+private:
+    bool emitIncremental(std::vector<llvm::SmallVector<char, 0>>& objects);
+
+    MIRModule& mirModule;
+    unsigned jobs;
+    OptLevel optLevel = OptLevel::O0;
+    std::string targetCPU;
+    std::string targetFeatures;
+    const ObjectCache* objectCache = nullptr;
+    size_t numReused = 0;
+    size_t numFunctions = 0;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_PARALLELCODEGEN_H
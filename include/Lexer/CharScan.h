@@ -0,0 +1,32 @@
+#ifndef CHTHOLLY_CHAR_SCAN_H
+#define CHTHOLLY_CHAR_SCAN_H
+
+#include <cstddef>
+
+namespace chtholly::charscan
+{
+
+	// 词法分析热点的批量字符分类内核
+	// 每个函数返回从 p 开始、直到 end 之前连续满足条件的字节数，且都不会越过换行符
+	enum class ScanImpl
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	size_t identifierRun(const char* p, const char* end);   // [A-Za-z0-9_]
+	size_t blankRun(const char* p, const char* end);        // ' ' '\t' '\r'
+	size_t lineCommentRun(const char* p, const char* end);  // 直到 '\n'
+	size_t blockCommentRun(const char* p, const char* end); // 直到 '*' '/' '\n'
+	size_t stringBodyRun(const char* p, const char* end);   // 直到 '"' '\\' '\n'
+
+	// 默认使用当前 CPU 支持的最快实现；切换仅供测试和基准测试使用，不是线程安全的
+	ScanImpl activeImpl();
+	bool isSupported(ScanImpl impl);
+	bool setImpl(ScanImpl impl); // 不支持时返回 false 且保持不变
+	const char* implName(ScanImpl impl);
+
+} // namespace chtholly::charscan
+
+#endif // CHTHOLLY_CHAR_SCAN_H
@@ -21,6 +21,9 @@ namespace chtholly
 
 	private:
 		char advance();            // 消耗并获取下一个字符
+		void advanceRun(size_t count); // 一次消耗 count 个不含换行的字符
+		const char* cursor() const;    // 当前位置的指针
+		const char* sourceEnd() const; // 源码末尾的指针
 		bool match(char expected); // 是否是预期的字符
 		void skipWhitespace();     // 跳过空白与换行
 		bool isAtEnd() const;
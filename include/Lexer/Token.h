@@ -58,6 +58,8 @@ namespace chtholly
 		Offsetof,
 		Align,
 		Packed,
+		Inline,
+		Noinline,
 
 		I8,
 		I16,
@@ -124,6 +126,71 @@ namespace chtholly
 		Underscore // _
 	};
 
+	// 关键字与基础类型名的唯一来源，Lexer 在编译期由它生成完美哈希表
+	struct KeywordSpelling
+	{
+		std::string_view spelling;
+		TokenType type;
+	};
+
+	inline constexpr KeywordSpelling KEYWORDS[] = {
+		{"fn", TokenType::Fn},
+		{"let", TokenType::Let},
+		{"mut", TokenType::Mut},
+		{"class", TokenType::Class},
+		{"struct", TokenType::Struct},
+		{"enum", TokenType::Enum},
+		{"if", TokenType::If},
+		{"else", TokenType::Else},
+		{"switch", TokenType::Switch},
+		{"case", TokenType::Case},
+		{"while", TokenType::While},
+		{"for", TokenType::For},
+		{"do", TokenType::Do},
+		{"return", TokenType::Return},
+		{"import", TokenType::Import},
+		{"package", TokenType::Package},
+		{"use", TokenType::Use},
+		{"pub", TokenType::Pub},
+		{"as", TokenType::As},
+		{"break", TokenType::Break},
+		{"continue", TokenType::Continue},
+		{"fallthrough", TokenType::Fallthrough},
+		{"default", TokenType::Default},
+		{"void", TokenType::Void},
+		{"char", TokenType::Char},
+		{"bool", TokenType::Bool},
+		{"self", TokenType::Self},
+		{"Self", TokenType::CapitalSelf},
+		{"extern", TokenType::Extern},
+		{"true", TokenType::True},
+		{"false", TokenType::False},
+		{"nullptr", TokenType::Nullptr},
+		{"unsafe", TokenType::Unsafe},
+		{"malloc", TokenType::Malloc},
+		{"alloca", TokenType::Alloca},
+		{"free", TokenType::Free},
+		{"sizeof", TokenType::Sizeof},
+		{"alignof", TokenType::Alignof},
+		{"offsetof", TokenType::Offsetof},
+		{"align", TokenType::Align},
+		{"packed", TokenType::Packed},
+		{"inline", TokenType::Inline},
+		{"noinline", TokenType::Noinline},
+		{"_", TokenType::Underscore},
+		// 基础类型关键字
+		{"i8", TokenType::I8},
+		{"i16", TokenType::I16},
+		{"i32", TokenType::I32},
+		{"i64", TokenType::I64},
+		{"u8", TokenType::U8},
+		{"u16", TokenType::U16},
+		{"u32", TokenType::U32},
+		{"u64", TokenType::U64},
+		{"f32", TokenType::F32},
+		{"f64", TokenType::F64},
+	};
+
 	struct Token
 	{
 		TokenType type;
@@ -232,6 +299,10 @@ namespace chtholly
 			return "align";
 		case TokenType::Packed:
 			return "packed";
+		case TokenType::Inline:
+			return "inline";
+		case TokenType::Noinline:
+			return "noinline";
 
 			// 内置类型关键字
 		case TokenType::I8:
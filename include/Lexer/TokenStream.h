@@ -0,0 +1,49 @@
+#ifndef CHTHOLLY_TOKEN_STREAM_H
+#define CHTHOLLY_TOKEN_STREAM_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Token.h"
+
+namespace chtholly
+{
+
+	// 一次性把整个文件词法分析为连续的 Token 数组（结构体数组拆分为数组结构体）
+	// 行号/列号不随 Token 存储，而是按需从行首偏移表中恢复
+	class TokenStream
+	{
+	public:
+		explicit TokenStream(std::string_view source);
+
+		size_t size() const { return m_kinds.size(); } // 包含末尾的 EndOfFile
+
+		// 越界下标返回末尾的 EndOfFile，因此任意前瞻都是安全的
+		TokenType kind(size_t index) const { return m_kinds[clamp(index)]; }
+		std::string_view text(size_t index) const;
+		uint32_t offset(size_t index) const { return m_offsets[clamp(index)]; }
+
+		int line(size_t index) const;   // 从 1 开始
+		int column(size_t index) const; // 从 1 开始
+		Token token(size_t index) const; // 组装带位置的完整 Token
+
+	private:
+		size_t clamp(size_t index) const { return index < m_kinds.size() ? index : m_kinds.size() - 1; }
+		size_t lineIndexOf(uint32_t offset) const;
+
+		std::string_view m_source;
+		std::vector<TokenType> m_kinds;
+		std::vector<uint32_t> m_offsets;
+		std::vector<uint32_t> m_lengths;
+
+		// 行首偏移表，首次查询位置时才构建
+		mutable std::vector<uint32_t> m_lineStarts;
+		// 顺序访问时上一次命中的行，命中则无需二分
+		mutable size_t m_lineHint = 0;
+	};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_TOKEN_STREAM_H
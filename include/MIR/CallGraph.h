@@ -0,0 +1,39 @@
+#ifndef CHTHOLLY_CALLGRAPH_H
+#define CHTHOLLY_CALLGRAPH_H
+
+#include "MIR/MIR.h"
+#include <vector>
+
+namespace chtholly {
+
+// The function a call runs: by its ID when it has one, else by name. Null for externals
+MIRFunction* resolveCallee(const MIRModule& module, const CallInst& call);
+
+// Direct calls between the functions of a module, split into strongly connected
+// components with Tarjan's algorithm. Nodes are FunctionIDs; IDs with no function
+// behind them (externals) have no edges.
+class CallGraph {
+public:
+    explicit CallGraph(const MIRModule& module);
+
+    // Functions `caller` calls, each once
+    const std::vector<FunctionID>& getCallees(FunctionID caller) const { return callees[caller]; }
+
+    // Components callees first: a component only calls into itself and earlier ones
+    const std::vector<std::vector<FunctionID>>& getSCCs() const { return sccs; }
+
+    // Whether a call from `caller` to `callee` may come back to `caller`
+    bool inSameSCC(FunctionID caller, FunctionID callee) const;
+    // Whether the function can reach itself, directly or through other calls
+    bool isRecursive(FunctionID id) const;
+
+private:
+    std::vector<std::vector<FunctionID>> callees;
+    std::vector<std::vector<FunctionID>> sccs;
+    std::vector<size_t> sccOf;
+    std::vector<bool> selfCalls;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_CALLGRAPH_H
@@ -0,0 +1,53 @@
+#ifndef CHTHOLLY_DOMINATORS_H
+#define CHTHOLLY_DOMINATORS_H
+
+#include "MIR/MIR.h"
+#include <unordered_map>
+#include <vector>
+
+namespace chtholly {
+
+// Dominator tree and dominance frontiers of one function's control-flow graph.
+// Only blocks reachable from the entry (the first block) are numbered, in reverse
+// post-order, so the entry is 0 and every block comes after its immediate
+// dominator. Immediate dominators use Cooper, Harvey and Kennedy's iterative
+// algorithm. Edges are kept one per branch target, so a conditional branch with
+// the same block on both sides contributes two.
+class DominatorTree {
+public:
+    static constexpr size_t Unreachable = SIZE_MAX;
+
+    explicit DominatorTree(const MIRFunction& func);
+
+    size_t getNumBlocks() const { return blocks.size(); }
+    BasicBlock* getBlock(size_t index) const { return blocks[index]; }
+    // Unreachable for blocks the entry never reaches
+    size_t indexOf(const BasicBlock* block) const;
+
+    const std::vector<size_t>& getSuccessors(size_t index) const { return successors[index]; }
+    const std::vector<size_t>& getPredecessors(size_t index) const { return predecessors[index]; }
+
+    // The entry is its own immediate dominator
+    size_t getIdom(size_t index) const { return idoms[index]; }
+    const std::vector<size_t>& getChildren(size_t index) const { return children[index]; }
+    const std::vector<size_t>& getFrontier(size_t index) const { return frontiers[index]; }
+
+    bool dominates(size_t a, size_t b) const;
+
+private:
+    std::vector<BasicBlock*> blocks;
+    std::unordered_map<const BasicBlock*, size_t> indices;
+    std::vector<std::vector<size_t>> successors;
+    std::vector<std::vector<size_t>> predecessors;
+    std::vector<size_t> idoms;
+    std::vector<std::vector<size_t>> children;
+    std::vector<std::vector<size_t>> frontiers;
+};
+
+// The order CodeGenerator emits blocks in: reachable blocks in reverse post-order, so a
+// value is always emitted before its uses, then unreachable ones in layout order
+std::vector<BasicBlock*> emissionOrder(const MIRFunction& func, const DominatorTree& domTree);
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_DOMINATORS_H
@@ -0,0 +1,31 @@
+#ifndef CHTHOLLY_ESCAPEANALYSIS_H
+#define CHTHOLLY_ESCAPEANALYSIS_H
+
+#include "MIR/MIR.h"
+
+namespace chtholly {
+
+// One call to the malloc intrinsic and what becomes of its pointer
+struct HeapAllocation {
+    CallInst* call;
+    // What the memory can be typed as on the stack: the type of a sizeof size,
+    // u8[N] for a constant N; null when the size is only known at run time
+    std::shared_ptr<Type> stackType;
+    // The free calls releasing it
+    std::vector<CallInst*> frees;
+    // Why the pointer may outlive the function or reach code that is not looked
+    // at, e.g. "returned"; empty when it provably does not
+    std::string escape;
+};
+
+// Follows the pointer each malloc call returns through copies, field and element
+// addresses, and local pointer variables (allocas only loaded from and stored to,
+// every store putting this allocation's pointer in them). Using the memory is
+// fine, as is comparing the pointer for equality or freeing it. The pointer
+// escapes when it is returned, stored anywhere else, merged by a phi, passed to
+// any call but free, or used in arithmetic.
+std::vector<HeapAllocation> analyzeHeapAllocations(MIRFunction& func);
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_ESCAPEANALYSIS_H
@@ -0,0 +1,29 @@
+#ifndef CHTHOLLY_INLINER_H
+#define CHTHOLLY_INLINER_H
+
+#include "MIR/MIR.h"
+
+namespace chtholly {
+
+// Size of a function body as the inliner weighs it: constants, allocas, phis and
+// branches are free, calls cost CallCost and every other instruction costs one.
+unsigned inlineCost(const MIRFunction& func);
+inline constexpr unsigned CallCost = 5;
+
+// Whether calls to `callee` can be replaced by its body: it has blocks, takes no
+// varargs, every non-empty block ends in a terminator, at least one block returns,
+// and nothing branches back to its entry.
+bool isInlinable(const MIRFunction& callee);
+
+// Replaces `call`, which must sit in `caller` and have an argument per parameter of
+// `callee`, with a copy of the callee's blocks. The callee's entry continues the
+// call's block. With one return, the code after the call follows it in place and
+// the call's result becomes a copy of the returned value; with several, each
+// return branches to a new exit block holding that code, where a phi merges the
+// returned values into the call's result. Callee values get fresh caller IDs and
+// parameters become the arguments. `call` is destroyed.
+void inlineCall(MIRFunction& caller, CallInst& call, const MIRFunction& callee);
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_INLINER_H
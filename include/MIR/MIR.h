@@ -1,14 +1,32 @@
 #ifndef CHTHOLLY_MIR_H
 #define CHTHOLLY_MIR_H
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <unordered_map>
+#include "AST/ASTNode.h"
 #include "AST/Types.h"
 #include "Lexer/Token.h"
 
 namespace chtholly {
 
+// MIR values are dense per-function indices into MIRFunction's value table
+using ValueID = uint32_t;
+inline constexpr ValueID NoValue = UINT32_MAX;
+
+// Functions are numbered by their module, so a call can name its callee without a string lookup
+using FunctionID = uint32_t;
+inline constexpr FunctionID NoFunction = UINT32_MAX;
+
+class BasicBlock;
+class MIRFunction;
+
 enum class MIRInstructionKind {
     Alloca,
     ConstInt,
@@ -21,6 +39,7 @@ enum class MIRInstructionKind {
     Load,
     StructElementPtr,
     ArrayElementPtr,
+    BoundsCheck,
     Sizeof,
     Alignof,
     Offsetof,
@@ -30,7 +49,8 @@ enum class MIRInstructionKind {
     Ret,
     Call,
     Br,
-    CondBr
+    CondBr,
+    Phi
 };
 
 class MIRInstruction {
@@ -38,341 +58,431 @@ public:
     virtual ~MIRInstruction() = default;
     virtual std::string toString() const = 0;
     virtual MIRInstructionKind getKind() const = 0;
+
+    BasicBlock* getParent() const { return parent; }
+
+    // Value this instruction defines, or NoValue
+    virtual ValueID getResult() const { return NoValue; }
+    // Calls fn on every value the instruction reads; fn may rewrite the operand in place
+    virtual void forEachOperand(const std::function<void(ValueID&)>& fn) { (void)fn; }
+
+protected:
+    // Name from the owning function's value table, or "%<id>" while detached
+    std::string valueName(ValueID id) const;
+
+private:
+    friend class BasicBlock;
+    BasicBlock* parent = nullptr;
 };
 
 class AllocaInst : public MIRInstruction {
 public:
-    AllocaInst(std::string name, std::shared_ptr<Type> type)
-        : name(std::move(name)), type(type) {}
+    AllocaInst(ValueID dest, std::shared_ptr<Type> type)
+        : dest(dest), type(type) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Alloca; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return name + " = alloca " + type->toString();
+        return valueName(dest) + " = alloca " + type->toString();
     }
 
-    const std::string& getName() const { return name; }
+    ValueID getDest() const { return dest; }
     std::shared_ptr<Type> getType() const { return type; }
 
 private:
-    std::string name;
+    ValueID dest;
     std::shared_ptr<Type> type;
 };
 
 class ConstIntInst : public MIRInstruction {
 public:
-    ConstIntInst(std::string dest, int64_t value)
-        : dest(std::move(dest)), value(value) {}
+    ConstIntInst(ValueID dest, int64_t value)
+        : dest(dest), value(value) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::ConstInt; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = const " + std::to_string(value);
+        return valueName(dest) + " = const " + std::to_string(value);
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     int64_t getValue() const { return value; }
 
 private:
-    std::string dest;
+    ValueID dest;
     int64_t value;
 };
 
 class ConstBoolInst : public MIRInstruction {
 public:
-    ConstBoolInst(std::string dest, bool value)
-        : dest(std::move(dest)), value(value) {}
+    ConstBoolInst(ValueID dest, bool value)
+        : dest(dest), value(value) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::ConstBool; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = const " + (value ? "true" : "false");
+        return valueName(dest) + " = const " + (value ? "true" : "false");
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     bool getValue() const { return value; }
 
 private:
-    std::string dest;
+    ValueID dest;
     bool value;
 };
 
 class ConstStringInst : public MIRInstruction {
 public:
-    ConstStringInst(std::string dest, std::string value)
-        : dest(std::move(dest)), value(std::move(value)) {}
+    ConstStringInst(ValueID dest, std::string value)
+        : dest(dest), value(std::move(value)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::ConstString; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = const \"" + value + "\"";
+        return valueName(dest) + " = const \"" + value + "\"";
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     const std::string& getValue() const { return value; }
 
 private:
-    std::string dest;
+    ValueID dest;
     std::string value;
 };
 
 class ConstDoubleInst : public MIRInstruction {
 public:
-    ConstDoubleInst(std::string dest, double value)
-        : dest(std::move(dest)), value(value) {}
+    ConstDoubleInst(ValueID dest, double value)
+        : dest(dest), value(value) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::ConstDouble; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = const " + std::to_string(value);
+        return valueName(dest) + " = const " + std::to_string(value);
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     double getValue() const { return value; }
 
 private:
-    std::string dest;
+    ValueID dest;
     double value;
 };
 
 class UnaryOpInst : public MIRInstruction {
 public:
-    UnaryOpInst(std::string dest, std::string operand, TokenType op)
-        : dest(std::move(dest)), operand(std::move(operand)), op(op) {}
+    UnaryOpInst(ValueID dest, ValueID operand, TokenType op)
+        : dest(dest), operand(operand), op(op) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::UnaryOp; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(operand);
+    }
     std::string toString() const override {
-        return dest + " = unaryop " + std::to_string((int)op) + " " + operand;
+        return valueName(dest) + " = unaryop " + std::to_string((int)op) + " " + valueName(operand);
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getOperand() const { return operand; }
+    ValueID getDest() const { return dest; }
+    ValueID getOperand() const { return operand; }
     TokenType getOp() const { return op; }
 
 private:
-    std::string dest;
-    std::string operand;
+    ValueID dest;
+    ValueID operand;
     TokenType op;
 };
 
 class BinOpInst : public MIRInstruction {
 public:
-    BinOpInst(std::string dest, std::string left, std::string right, TokenType op)
-        : dest(std::move(dest)), left(std::move(left)), right(std::move(right)), op(op) {}
+    BinOpInst(ValueID dest, ValueID left, ValueID right, TokenType op)
+        : dest(dest), left(left), right(right), op(op) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::BinOp; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(left);
+        fn(right);
+    }
     std::string toString() const override {
-        return dest + " = binop " + std::to_string((int)op) + " " + left + ", " + right;
+        return valueName(dest) + " = binop " + std::to_string((int)op) + " " + valueName(left) + ", " + valueName(right);
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getLeft() const { return left; }
-    const std::string& getRight() const { return right; }
+    ValueID getDest() const { return dest; }
+    ValueID getLeft() const { return left; }
+    ValueID getRight() const { return right; }
     TokenType getOp() const { return op; }
 
 private:
-    std::string dest;
-    std::string left;
-    std::string right;
+    ValueID dest;
+    ValueID left;
+    ValueID right;
     TokenType op;
 };
 
 class StoreInst : public MIRInstruction {
 public:
-    StoreInst(std::string src, std::string dest)
-        : src(std::move(src)), dest(std::move(dest)) {}
+    StoreInst(ValueID src, ValueID dest)
+        : src(src), dest(dest) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Store; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(src);
+        fn(dest);
+    }
     std::string toString() const override {
-        return "store " + src + ", " + dest;
+        return "store " + valueName(src) + ", " + valueName(dest);
     }
 
-    const std::string& getSrc() const { return src; }
-    const std::string& getDest() const { return dest; }
+    ValueID getSrc() const { return src; }
+    ValueID getDest() const { return dest; }
 
 private:
-    std::string src;
-    std::string dest;
+    ValueID src;
+    ValueID dest;
 };
 
 class LoadInst : public MIRInstruction {
 public:
-    LoadInst(std::string dest, std::string src)
-        : dest(std::move(dest)), src(std::move(src)) {}
+    LoadInst(ValueID dest, ValueID src)
+        : dest(dest), src(src) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Load; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(src);
+    }
     std::string toString() const override {
-        return dest + " = load " + src;
+        return valueName(dest) + " = load " + valueName(src);
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getSrc() const { return src; }
+    ValueID getDest() const { return dest; }
+    ValueID getSrc() const { return src; }
 
 private:
-    std::string dest;
-    std::string src;
+    ValueID dest;
+    ValueID src;
 };
 
 class StructElementPtrInst : public MIRInstruction {
 public:
-    StructElementPtrInst(std::string dest, std::string ptr, std::string structName, std::string fieldName)
-        : dest(std::move(dest)), ptr(std::move(ptr)), structName(std::move(structName)), fieldName(std::move(fieldName)) {}
+    StructElementPtrInst(ValueID dest, ValueID ptr, std::string structName, std::string fieldName)
+        : dest(dest), ptr(ptr), structName(std::move(structName)), fieldName(std::move(fieldName)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::StructElementPtr; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(ptr);
+    }
     std::string toString() const override {
-        return dest + " = struct_gep " + ptr + " (" + structName + "), " + fieldName;
+        return valueName(dest) + " = struct_gep " + valueName(ptr) + " (" + structName + "), " + fieldName;
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getPtr() const { return ptr; }
+    ValueID getDest() const { return dest; }
+    ValueID getPtr() const { return ptr; }
     const std::string& getStructName() const { return structName; }
     const std::string& getFieldName() const { return fieldName; }
 
 private:
-    std::string dest;
-    std::string ptr;
+    ValueID dest;
+    ValueID ptr;
     std::string structName;
     std::string fieldName;
 };
 
 class ArrayElementPtrInst : public MIRInstruction {
 public:
-    ArrayElementPtrInst(std::string dest, std::string ptr, std::string index, std::shared_ptr<Type> elementType)
-        : dest(std::move(dest)), ptr(std::move(ptr)), index(std::move(index)), elementType(std::move(elementType)) {}
+    ArrayElementPtrInst(ValueID dest, ValueID ptr, ValueID index, std::shared_ptr<Type> elementType)
+        : dest(dest), ptr(ptr), index(index), elementType(std::move(elementType)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::ArrayElementPtr; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(ptr);
+        fn(index);
+    }
     std::string toString() const override {
-        return dest + " = array_gep " + ptr + ", " + index + " (" + elementType->toString() + ")";
+        return valueName(dest) + " = array_gep " + valueName(ptr) + ", " + valueName(index) + " (" + elementType->toString() + ")";
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getPtr() const { return ptr; }
-    const std::string& getIndex() const { return index; }
+    ValueID getDest() const { return dest; }
+    ValueID getPtr() const { return ptr; }
+    ValueID getIndex() const { return index; }
     std::shared_ptr<Type> getElementType() const { return elementType; }
 
 private:
-    std::string dest;
-    std::string ptr;
-    std::string index;
+    ValueID dest;
+    ValueID ptr;
+    ValueID index;
     std::shared_ptr<Type> elementType;
 };
 
+// Traps unless 0 <= index < length. With an end value it checks every index in
+// [index, end) at once, as a check hoisted out of a loop does; an empty range passes.
+class BoundsCheckInst : public MIRInstruction {
+public:
+    BoundsCheckInst(ValueID index, int64_t length, ValueID end = NoValue)
+        : index(index), end(end), length(length) {}
+
+    MIRInstructionKind getKind() const override { return MIRInstructionKind::BoundsCheck; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(index);
+        if (end != NoValue) fn(end);
+    }
+    std::string toString() const override {
+        std::string checked = end == NoValue ? valueName(index) : "[" + valueName(index) + ", " + valueName(end) + ")";
+        return "bounds_check " + checked + ", " + std::to_string(length);
+    }
+
+    ValueID getIndex() const { return index; }
+    // NoValue for a single index
+    ValueID getEnd() const { return end; }
+    int64_t getLength() const { return length; }
+
+private:
+    ValueID index;
+    ValueID end;
+    int64_t length;
+};
+
 class SizeofInst : public MIRInstruction {
 public:
-    SizeofInst(std::string dest, std::shared_ptr<Type> type)
-        : dest(std::move(dest)), type(type) {}
+    SizeofInst(ValueID dest, std::shared_ptr<Type> type)
+        : dest(dest), type(type) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Sizeof; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = sizeof " + type->toString();
+        return valueName(dest) + " = sizeof " + type->toString();
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     std::shared_ptr<Type> getType() const { return type; }
 
 private:
-    std::string dest;
+    ValueID dest;
     std::shared_ptr<Type> type;
 };
 
 class AlignofInst : public MIRInstruction {
 public:
-    AlignofInst(std::string dest, std::shared_ptr<Type> type)
-        : dest(std::move(dest)), type(type) {}
+    AlignofInst(ValueID dest, std::shared_ptr<Type> type)
+        : dest(dest), type(type) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Alignof; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = alignof " + type->toString();
+        return valueName(dest) + " = alignof " + type->toString();
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     std::shared_ptr<Type> getType() const { return type; }
 
 private:
-    std::string dest;
+    ValueID dest;
     std::shared_ptr<Type> type;
 };
 
 class OffsetofInst : public MIRInstruction {
 public:
-    OffsetofInst(std::string dest, std::shared_ptr<Type> type, std::string memberName)
-        : dest(std::move(dest)), type(type), memberName(std::move(memberName)) {}
+    OffsetofInst(ValueID dest, std::shared_ptr<Type> type, std::string memberName)
+        : dest(dest), type(type), memberName(std::move(memberName)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Offsetof; }
+    ValueID getResult() const override { return dest; }
     std::string toString() const override {
-        return dest + " = offsetof " + type->toString() + ", " + memberName;
+        return valueName(dest) + " = offsetof " + type->toString() + ", " + memberName;
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     std::shared_ptr<Type> getType() const { return type; }
     const std::string& getMemberName() const { return memberName; }
 
 private:
-    std::string dest;
+    ValueID dest;
     std::shared_ptr<Type> type;
     std::string memberName;
 };
 
 class VariantTagInst : public MIRInstruction {
 public:
-    VariantTagInst(std::string dest, std::string enumPtr)
-        : dest(std::move(dest)), enumPtr(std::move(enumPtr)) {}
+    VariantTagInst(ValueID dest, ValueID enumPtr)
+        : dest(dest), enumPtr(enumPtr) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::VariantTag; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(enumPtr);
+    }
     std::string toString() const override {
-        return dest + " = variant_tag " + enumPtr;
+        return valueName(dest) + " = variant_tag " + valueName(enumPtr);
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getEnumPtr() const { return enumPtr; }
+    ValueID getDest() const { return dest; }
+    ValueID getEnumPtr() const { return enumPtr; }
 
 private:
-    std::string dest;
-    std::string enumPtr;
+    ValueID dest;
+    ValueID enumPtr;
 };
 
 class VariantDataInst : public MIRInstruction {
 public:
-    VariantDataInst(std::string dest, std::string enumPtr, int tag, std::vector<std::string> args)
-        : dest(std::move(dest)), enumPtr(std::move(enumPtr)), tag(tag), args(std::move(args)) {}
+    VariantDataInst(ValueID dest, ValueID enumPtr, int tag, std::vector<ValueID> args)
+        : dest(dest), enumPtr(enumPtr), tag(tag), args(std::move(args)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::VariantData; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(enumPtr);
+        for (ValueID& arg : args) fn(arg);
+    }
     std::string toString() const override {
-        std::string res = dest + " = variant_data " + enumPtr + ", tag " + std::to_string(tag) + "(";
+        std::string res = valueName(dest) + " = variant_data " + valueName(enumPtr) + ", tag " + std::to_string(tag) + "(";
         for (size_t i = 0; i < args.size(); ++i) {
-            res += args[i];
+            res += valueName(args[i]);
             if (i < args.size() - 1) res += ", ";
         }
         res += ")";
         return res;
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getEnumPtr() const { return enumPtr; }
+    ValueID getDest() const { return dest; }
+    ValueID getEnumPtr() const { return enumPtr; }
     int getTag() const { return tag; }
-    const std::vector<std::string>& getArgs() const { return args; }
+    const std::vector<ValueID>& getArgs() const { return args; }
 
 private:
-    std::string dest;
-    std::string enumPtr;
+    ValueID dest;
+    ValueID enumPtr;
     int tag;
-    std::vector<std::string> args;
+    std::vector<ValueID> args;
 };
 
 class VariantExtractInst : public MIRInstruction {
 public:
-    VariantExtractInst(std::string dest, std::string enumPtr, int tag, int fieldIndex, std::shared_ptr<Type> fieldType)
-        : dest(std::move(dest)), enumPtr(std::move(enumPtr)), tag(tag), fieldIndex(fieldIndex), fieldType(std::move(fieldType)) {}
+    VariantExtractInst(ValueID dest, ValueID enumPtr, int tag, int fieldIndex, std::shared_ptr<Type> fieldType)
+        : dest(dest), enumPtr(enumPtr), tag(tag), fieldIndex(fieldIndex), fieldType(std::move(fieldType)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::VariantExtract; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(enumPtr);
+    }
     std::string toString() const override {
-        return dest + " = variant_extract " + enumPtr + ", tag " + std::to_string(tag) + ", index " + std::to_string(fieldIndex);
+        return valueName(dest) + " = variant_extract " + valueName(enumPtr) + ", tag " + std::to_string(tag) + ", index " + std::to_string(fieldIndex);
     }
 
-    const std::string& getDest() const { return dest; }
-    const std::string& getEnumPtr() const { return enumPtr; }
+    ValueID getDest() const { return dest; }
+    ValueID getEnumPtr() const { return enumPtr; }
     int getTag() const { return tag; }
     int getFieldIndex() const { return fieldIndex; }
     std::shared_ptr<Type> getFieldType() const { return fieldType; }
 
 private:
-    std::string dest;
-    std::string enumPtr;
+    ValueID dest;
+    ValueID enumPtr;
     int tag;
     int fieldIndex;
     std::shared_ptr<Type> fieldType;
@@ -380,37 +490,48 @@ private:
 
 class ReturnInst : public MIRInstruction {
 public:
-    ReturnInst(std::string val = "") : val(std::move(val)) {}
+    ReturnInst(ValueID val = NoValue) : val(val) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Ret; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        if (val != NoValue) fn(val);
+    }
     std::string toString() const override {
-        return "ret " + val;
+        return val == NoValue ? "ret " : "ret " + valueName(val);
     }
 
-    const std::string& getVal() const { return val; }
+    ValueID getVal() const { return val; }
 
 private:
-    std::string val;
+    ValueID val;
 };
 
 class CallInst : public MIRInstruction {
 public:
-    CallInst(std::string dest, std::string callee, std::vector<std::string> args)
-        : dest(std::move(dest)), callee(std::move(callee)), args(std::move(args)) {}
+    // Without a callee ID the call is resolved by name
+    CallInst(ValueID dest, std::string callee, std::vector<ValueID> args, FunctionID calleeID = NoFunction)
+        : dest(dest), callee(std::move(callee)), args(std::move(args)), calleeID(calleeID) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::Call; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        for (ValueID& arg : args) fn(arg);
+    }
     std::string toString() const override {
-        return dest + " = call " + callee;
+        std::string res = "call " + callee;
+        return dest == NoValue ? res : valueName(dest) + " = " + res;
     }
 
-    const std::string& getDest() const { return dest; }
+    ValueID getDest() const { return dest; }
     const std::string& getCallee() const { return callee; }
-    const std::vector<std::string>& getArgs() const { return args; }
+    const std::vector<ValueID>& getArgs() const { return args; }
+    FunctionID getCalleeID() const { return calleeID; }
 
 private:
-    std::string dest;
+    ValueID dest;
     std::string callee;
-    std::vector<std::string> args;
+    std::vector<ValueID> args;
+    FunctionID calleeID;
 };
 
 class BrInst : public MIRInstruction {
@@ -430,34 +551,129 @@ private:
 
 class CondBrInst : public MIRInstruction {
 public:
-    CondBrInst(std::string cond, std::string thenLabel, std::string elseLabel)
-        : cond(std::move(cond)), thenLabel(std::move(thenLabel)), elseLabel(std::move(elseLabel)) {}
+    CondBrInst(ValueID cond, std::string thenLabel, std::string elseLabel)
+        : cond(cond), thenLabel(std::move(thenLabel)), elseLabel(std::move(elseLabel)) {}
 
     MIRInstructionKind getKind() const override { return MIRInstructionKind::CondBr; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        fn(cond);
+    }
     std::string toString() const override {
-        return "br " + cond + ", label %" + thenLabel + ", label %" + elseLabel;
+        return "br " + valueName(cond) + ", label %" + thenLabel + ", label %" + elseLabel;
     }
 
-    const std::string& getCond() const { return cond; }
+    ValueID getCond() const { return cond; }
     const std::string& getThenLabel() const { return thenLabel; }
     const std::string& getElseLabel() const { return elseLabel; }
 
 private:
-    std::string cond;
+    ValueID cond;
     std::string thenLabel;
     std::string elseLabel;
 };
 
+// Merges the values a variable has on each incoming edge, as built by promoteAllocas.
+// An incoming value is NoValue on an edge where the variable is not assigned yet.
+class PhiInst : public MIRInstruction {
+public:
+    struct Incoming {
+        std::string block;
+        ValueID value;
+    };
+
+    PhiInst(ValueID dest, std::shared_ptr<Type> type)
+        : dest(dest), type(std::move(type)) {}
+
+    MIRInstructionKind getKind() const override { return MIRInstructionKind::Phi; }
+    ValueID getResult() const override { return dest; }
+    void forEachOperand(const std::function<void(ValueID&)>& fn) override {
+        for (auto& incoming : incomings) {
+            if (incoming.value != NoValue) fn(incoming.value);
+        }
+    }
+    std::string toString() const override {
+        std::string res = valueName(dest) + " = phi " + type->toString();
+        for (size_t i = 0; i < incomings.size(); ++i) {
+            std::string value = incomings[i].value == NoValue ? "undef" : valueName(incomings[i].value);
+            res += (i ? ", [" : " [") + value + ", %" + incomings[i].block + "]";
+        }
+        return res;
+    }
+
+    ValueID getDest() const { return dest; }
+    std::shared_ptr<Type> getType() const { return type; }
+    // One entry per incoming edge, so a block branching here twice appears twice
+    const std::vector<Incoming>& getIncomings() const { return incomings; }
+    void addIncoming(std::string block, ValueID value) { incomings.push_back({std::move(block), value}); }
+    // Drops the entry of one edge from `block`; false if there is none
+    bool removeIncoming(const std::string& block) {
+        auto it = std::find_if(incomings.begin(), incomings.end(), [&](const Incoming& incoming) { return incoming.block == block; });
+        if (it == incomings.end()) return false;
+        incomings.erase(it);
+        return true;
+    }
+    // Moves every entry from `from` over to `to`, for when the edge's source block is split
+    void replaceIncomingBlock(const std::string& from, const std::string& to) {
+        for (auto& incoming : incomings) {
+            if (incoming.block == from) incoming.block = to;
+        }
+    }
+
+private:
+    ValueID dest;
+    std::shared_ptr<Type> type;
+    std::vector<Incoming> incomings;
+};
+
 class BasicBlock {
 public:
     BasicBlock(std::string name) : name(std::move(name)) {}
 
     const std::string& getName() const { return name; }
-    
+    MIRFunction* getParent() const { return parent; }
+
     void appendInstruction(std::unique_ptr<MIRInstruction> inst) {
+        inst->parent = this;
         instructions.push_back(std::move(inst));
     }
 
+    // Inserts before the instruction at `index`
+    void insertInstruction(size_t index, std::unique_ptr<MIRInstruction> inst) {
+        inst->parent = this;
+        instructions.insert(instructions.begin() + index, std::move(inst));
+    }
+
+    void replaceInstruction(size_t index, std::unique_ptr<MIRInstruction> inst) {
+        inst->parent = this;
+        instructions[index] = std::move(inst);
+    }
+
+    // Removes the instructions from `index` on and hands them back, e.g. to start a new block
+    std::vector<std::unique_ptr<MIRInstruction>> takeInstructionsFrom(size_t index) {
+        std::vector<std::unique_ptr<MIRInstruction>> tail;
+        tail.reserve(instructions.size() - index);
+        std::move(instructions.begin() + index, instructions.end(), std::back_inserter(tail));
+        instructions.erase(instructions.begin() + index, instructions.end());
+        return tail;
+    }
+
+    template <typename Pred>
+    void eraseInstructionsIf(Pred pred) {
+        std::erase_if(instructions, [&](const std::unique_ptr<MIRInstruction>& inst) { return pred(*inst); });
+    }
+
+    // Names of the blocks the terminator branches to, one per edge
+    std::vector<std::string> getSuccessorNames() const {
+        if (instructions.empty()) return {};
+        const MIRInstruction* last = instructions.back().get();
+        if (last->getKind() == MIRInstructionKind::Br) return {static_cast<const BrInst*>(last)->getTarget()};
+        if (last->getKind() == MIRInstructionKind::CondBr) {
+            auto* condBr = static_cast<const CondBrInst*>(last);
+            return {condBr->getThenLabel(), condBr->getElseLabel()};
+        }
+        return {};
+    }
+
     bool hasTerminator() const {
         if (instructions.empty()) return false;
         auto kind = instructions.back()->getKind();
@@ -477,7 +693,9 @@ public:
     }
 
     private:
+    friend class MIRFunction;
     std::string name;
+    MIRFunction* parent = nullptr;
     std::vector<std::unique_ptr<MIRInstruction>> instructions;
 };
 
@@ -488,8 +706,11 @@ public:
 
     const std::string& getName() const { return name; }
     std::shared_ptr<Type> getReturnType() const { return returnType; }
+    // NoFunction until the function is added to a module
+    FunctionID getID() const { return id; }
 
     void addParameter(std::string name, std::shared_ptr<Type> type) {
+        paramValues.push_back(createValue("%" + name, type));
         params.push_back({std::move(name), type});
     }
 
@@ -497,10 +718,52 @@ public:
         return params;
     }
 
+    // Value carrying the incoming argument for parameter i
+    ValueID getParameterValue(size_t i) const { return paramValues[i]; }
+
+    // Allocates a fresh value; a name already in use gets a ".N" suffix
+    ValueID createValue(std::string valueName, std::shared_ptr<Type> type = nullptr) {
+        if (valueIDs.count(valueName)) {
+            std::string base = valueName;
+            unsigned suffix = 1;
+            do {
+                valueName = base + "." + std::to_string(suffix++);
+            } while (valueIDs.count(valueName));
+        }
+        ValueID id = static_cast<ValueID>(values.size());
+        valueIDs.emplace(valueName, id);
+        values.push_back({std::move(valueName), std::move(type)});
+        return id;
+    }
+
+    // Allocates an anonymous value; it has no name and prints as %<id>
+    ValueID createTemp(std::shared_ptr<Type> type = nullptr) {
+        ValueID id = static_cast<ValueID>(values.size());
+        values.push_back({std::string(), std::move(type)});
+        return id;
+    }
+
+    // Looks a named value up by its exact name
+    std::optional<ValueID> lookupValue(const std::string& valueName) const {
+        auto it = valueIDs.find(valueName);
+        if (it == valueIDs.end()) return std::nullopt;
+        return it->second;
+    }
+
+    // Empty for anonymous values
+    const std::string& getValueName(ValueID id) const { return values[id].name; }
+    std::shared_ptr<Type> getValueType(ValueID id) const { return values[id].type; }
+    void setValueType(ValueID id, std::shared_ptr<Type> type) { values[id].type = std::move(type); }
+    size_t getNumValues() const { return values.size(); }
+
     void setVarArg(bool v) { isVarArg = v; }
     bool getVarArg() const { return isVarArg; }
 
+    void setInlineHint(InlineHint hint) { inlineHint = hint; }
+    InlineHint getInlineHint() const { return inlineHint; }
+
     void appendBlock(std::unique_ptr<BasicBlock> block) {
+        block->parent = this;
         blocks.push_back(std::move(block));
     }
 
@@ -508,8 +771,17 @@ public:
         return blocks;
     }
 
+    // The entry block is never erased
+    template <typename Pred>
+    void eraseBlocksIf(Pred pred) {
+        if (blocks.empty()) return;
+        BasicBlock* entry = blocks.front().get();
+        std::erase_if(blocks, [&](const std::unique_ptr<BasicBlock>& block) { return block.get() != entry && pred(*block); });
+    }
+
     std::string toString() const {
-        std::string res = "fn " + name + "(";
+        std::string res = inlineHint == InlineHint::Always ? "inline fn " : inlineHint == InlineHint::Never ? "noinline fn " : "fn ";
+        res += name + "(";
         for (size_t i = 0; i < params.size(); ++i) {
             res += params[i].first + ": " + params[i].second->toString();
             if (i < params.size() - 1) res += ", ";
@@ -523,16 +795,45 @@ public:
     }
 
 private:
+    struct ValueInfo {
+        std::string name;
+        std::shared_ptr<Type> type;
+    };
+
     std::string name;
     std::shared_ptr<Type> returnType;
     std::vector<std::pair<std::string, std::shared_ptr<Type>>> params;
+    std::vector<ValueID> paramValues;
     std::vector<std::unique_ptr<BasicBlock>> blocks;
+    std::vector<ValueInfo> values;
+    std::unordered_map<std::string, ValueID> valueIDs;
     bool isVarArg;
+    InlineHint inlineHint = InlineHint::None;
+    friend class MIRModule;
+    FunctionID id = NoFunction;
 };
 
+inline std::string MIRInstruction::valueName(ValueID id) const {
+    if (id == NoValue) return "";
+    if (parent && parent->getParent()) {
+        const std::string& name = parent->getParent()->getValueName(id);
+        if (!name.empty()) return name;
+    }
+    return "%" + std::to_string(id);
+}
+
 class MIRModule {
 public:
+    // Fills the ID reserved for the function's name; a second function of the same name gets
+    // an ID of its own, but name lookups keep finding the first
     void addFunction(std::unique_ptr<MIRFunction> func) {
+        FunctionID id = getFunctionID(func->getName());
+        if (byID[id]) {
+            id = static_cast<FunctionID>(byID.size());
+            byID.push_back(nullptr);
+        }
+        byID[id] = func.get();
+        func->id = id;
         functions.push_back(std::move(func));
     }
 
@@ -540,13 +841,31 @@ public:
         addFunction(std::move(func));
     }
 
-    MIRFunction* getFunction(const std::string& name) {
-        for (const auto& f : functions) {
-            if (f->getName() == name) return f.get();
-        }
-        return nullptr;
+    // ID of the function called `name`, reserved if it is not added yet. Calls may be lowered
+    // before their callee; externals such as malloc keep an empty slot
+    FunctionID getFunctionID(const std::string& name) {
+        auto [it, inserted] = functionIDs.emplace(name, static_cast<FunctionID>(byID.size()));
+        if (inserted) byID.push_back(nullptr);
+        return it->second;
+    }
+
+    FunctionID findFunctionID(const std::string& name) const {
+        auto it = functionIDs.find(name);
+        return it == functionIDs.end() ? NoFunction : it->second;
     }
 
+    MIRFunction* getFunction(const std::string& name) const {
+        FunctionID id = findFunctionID(name);
+        return id == NoFunction ? nullptr : byID[id];
+    }
+
+    // Null for an ID that no added function fills
+    MIRFunction* getFunction(FunctionID id) const {
+        return id < byID.size() ? byID[id] : nullptr;
+    }
+
+    size_t getNumFunctionIDs() const { return byID.size(); }
+
     const std::vector<std::unique_ptr<MIRFunction>>& getFunctions() const { return functions; }
 
     std::string toString() const {
@@ -558,7 +877,9 @@ public:
     }
 
 private:
-    std::vector<std::unique_ptr<MIRFunction>> functions;
+    std::vector<std::unique_ptr<MIRFunction>> functions; // in the order they were added
+    std::vector<MIRFunction*> byID;
+    std::unordered_map<std::string, FunctionID> functionIDs;
 };
 
 } // namespace chtholly
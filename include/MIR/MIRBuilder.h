@@ -17,10 +17,12 @@ public:
 
     void lower(ASTNode* node);
     
-    // Expression lowering returns the name of the temporary variable holding the result
-    std::string lowerExpr(Expr* expr);
+    // Expression lowering returns the value holding the result
+    ValueID lowerExpr(Expr* expr);
 
     void addModuleName(const std::string& name) { moduleNames.insert(name); }
+    // Precedes every index into a fixed-size array with a bounds_check
+    void setBoundsChecks(bool enabled) { boundsChecks = enabled; }
 
 private:
     void lowerVarDecl(VarDecl* decl);
@@ -40,23 +42,25 @@ private:
     void lowerBreakStmt(BreakStmt* stmt);
     void lowerContinueStmt(ContinueStmt* stmt);
 
-    std::string lowerAddr(Expr* expr);
-    std::string lowerLiteralExpr(LiteralExpr* expr);
-    std::string lowerBinaryExpr(BinaryExpr* expr);
-    std::string lowerUnaryExpr(UnaryExpr* expr);
-    std::string lowerIdentifierExpr(IdentifierExpr* id);
-    std::string lowerCallExpr(CallExpr* call);
-    std::string lowerMemberAccessExpr(MemberAccessExpr* expr);
-    std::string lowerStructLiteralExpr(StructLiteralExpr* expr);
-    std::string lowerArrayLiteralExpr(ArrayLiteralExpr* expr);
-    std::string lowerIndexingExpr(IndexingExpr* expr);
-    std::string lowerAddressOfExpr(AddressOfExpr* expr);
-    std::string lowerDereferenceExpr(DereferenceExpr* expr);
-    std::string lowerQuestionExpr(QuestionExpr* expr);
-    std::string lowerIntrinsicExpr(IntrinsicExpr* expr);
+    ValueID lowerAddr(Expr* expr);
+    ValueID lowerLiteralExpr(LiteralExpr* expr);
+    ValueID lowerBinaryExpr(BinaryExpr* expr);
+    ValueID lowerUnaryExpr(UnaryExpr* expr);
+    ValueID lowerIdentifierExpr(IdentifierExpr* id);
+    ValueID lowerCallExpr(CallExpr* call);
+    ValueID lowerMemberAccessExpr(MemberAccessExpr* expr);
+    ValueID lowerStructLiteralExpr(StructLiteralExpr* expr);
+    ValueID lowerArrayLiteralExpr(ArrayLiteralExpr* expr);
+    ValueID lowerIndexingExpr(IndexingExpr* expr);
+    ValueID lowerAddressOfExpr(AddressOfExpr* expr);
+    ValueID lowerDereferenceExpr(DereferenceExpr* expr);
+    ValueID lowerQuestionExpr(QuestionExpr* expr);
+    ValueID lowerIntrinsicExpr(IntrinsicExpr* expr);
 
-    std::string newTemp();
+    ValueID newTemp();
     BasicBlock* newBlock(std::string name);
+    // Binds the call to the callee's module ID, reserving one if the callee is not lowered yet
+    std::unique_ptr<CallInst> newCall(ValueID dest, const std::string& callee, std::vector<ValueID> args);
 
     void pushScope();
     void popScope();
@@ -65,8 +69,8 @@ private:
     MIRModule& module;
     MIRFunction* currentFunction = nullptr;
     BasicBlock* currentBlock = nullptr;
-    int tempCount = 0;
     int blockCount = 0;
+    bool boundsChecks = false;
     
     struct LocalVar {
         std::string name;
@@ -74,7 +78,7 @@ private:
     };
     struct ShadowedVar {
         std::string name;
-        std::string oldMirName;
+        ValueID oldMirValue;
         std::string oldPtrType;
     };
     struct Scope {
@@ -89,10 +93,10 @@ private:
     };
     std::vector<LoopContext> loopStack;
 
-    // Map variable names to their alloca names in MIR
-    std::map<std::string, std::string> varMap;
-    // Map pointer names to their struct type names
-    std::map<std::string, std::string> ptrTypeMap;
+    // Map variable names to their alloca values in MIR
+    std::map<std::string, ValueID> varMap;
+    // Map pointer values to their struct type names
+    std::map<ValueID, std::string> ptrTypeMap;
 
     struct StructInfo {
         std::string name;
@@ -0,0 +1,21 @@
+#ifndef CHTHOLLY_MEM2REG_H
+#define CHTHOLLY_MEM2REG_H
+
+#include "MIR/Dominators.h"
+
+namespace chtholly {
+
+// Rewrites the function's scalar locals into SSA form. An alloca is promoted when
+// it holds an integer, float, bool or pointer, is only ever loaded from and stored
+// to, every store writes a value of exactly its type (as CodeGenerator types it),
+// and no load can run before a store. Each load is replaced by the reaching stored
+// value, phis are placed on the iterated dominance frontiers of the stores, and
+// phis nothing uses are dropped. Returns the number of allocas promoted.
+unsigned promoteAllocas(MIRFunction& func, const MIRModule& module);
+// Same, reusing an up-to-date dominator tree and inferValueTypes result
+unsigned promoteAllocas(MIRFunction& func, const DominatorTree& domTree, const std::vector<std::shared_ptr<Type>>& types);
+unsigned promoteAllocas(MIRModule& module);
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_MEM2REG_H
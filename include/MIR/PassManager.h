@@ -0,0 +1,82 @@
+#ifndef CHTHOLLY_PASSMANAGER_H
+#define CHTHOLLY_PASSMANAGER_H
+
+#include "MIR/CallGraph.h"
+#include "MIR/Dominators.h"
+#include <iostream>
+#include <optional>
+#include <set>
+
+namespace chtholly {
+
+// Analyses of one function, computed on first request and kept until a pass changes what they describe
+class FunctionAnalyses {
+public:
+    FunctionAnalyses(MIRFunction& func, const MIRModule& module, const CallGraph& callGraph)
+        : func(func), module(module), callGraph(callGraph) {}
+
+    const MIRModule& getModule() const { return module; }
+    // Built once per run; inlining a callee never joins or splits components
+    const CallGraph& getCallGraph() const { return callGraph; }
+    const DominatorTree& getDominatorTree();
+    // inferValueTypes over the function as it is now
+    const std::vector<std::shared_ptr<Type>>& getValueTypes();
+
+    // Called after a pass changed the function; the dominator tree survives unless blocks or edges changed
+    void invalidate(bool cfgChanged);
+
+private:
+    MIRFunction& func;
+    const MIRModule& module;
+    const CallGraph& callGraph;
+    std::unique_ptr<DominatorTree> domTree;
+    std::optional<std::vector<std::shared_ptr<Type>>> valueTypes;
+};
+
+class FunctionPass {
+public:
+    virtual ~FunctionPass() = default;
+    // Names the pass for -print-after and the time report
+    virtual const char* getName() const = 0;
+    // Returns whether the function changed
+    virtual bool run(MIRFunction& func, FunctionAnalyses& analyses) = 0;
+    // Whether a change may add, remove or redirect blocks and edges
+    virtual bool changesCFG() const { return false; }
+
+    void setRemarkStream(std::ostream* out) { remarks = out; }
+
+protected:
+    // Where to explain what the pass did and did not do; null unless asked for
+    std::ostream* remarks = nullptr;
+};
+
+// Runs its passes in order over each function of a module in turn, so a function's
+// cached analyses carry from one pass to the next. Functions are visited callees
+// first along the call graph, so a pass looking into a callee sees it optimized.
+class PassManager {
+public:
+    void addPass(std::unique_ptr<FunctionPass> pass) { passes.push_back(std::move(pass)); }
+    size_t getNumPasses() const { return passes.size(); }
+
+    // Dumps every function after the named pass has run on it; "all" dumps after each pass
+    void printAfter(const std::string& passName) { printAfterPasses.insert(passName); }
+    // Lets the named pass ("all" for every pass) write its remarks to the print stream
+    void reportRemarks(const std::string& passName) { remarkPasses.insert(passName); }
+    void setPrintStream(std::ostream& out) { printStream = &out; }
+
+    // Returns whether any function changed
+    bool run(MIRModule& module);
+
+private:
+    bool shouldPrintAfter(const FunctionPass& pass) const;
+    bool shouldReport(const FunctionPass& pass) const;
+
+    std::vector<std::unique_ptr<FunctionPass>> passes;
+    std::set<std::string> printAfterPasses;
+    std::set<std::string> remarkPasses;
+    std::ostream* printStream = &std::cerr;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_PASSMANAGER_H
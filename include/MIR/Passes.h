@@ -0,0 +1,113 @@
+#ifndef CHTHOLLY_PASSES_H
+#define CHTHOLLY_PASSES_H
+
+#include "MIR/PassManager.h"
+
+namespace chtholly {
+
+// Turns conditional branches on constant conditions into plain branches, then
+// erases the blocks the entry no longer reaches and their phi entries.
+class UnreachableBlockElim : public FunctionPass {
+public:
+    const char* getName() const override { return "unreachable-blocks"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+    bool changesCFG() const override { return true; }
+};
+
+// Replaces calls with the callee's body, see inlineCall. Because the pass manager
+// visits callees first, a callee is weighed and copied after its own inlining and
+// cleanup. Calls within one recursive component of the call graph are kept.
+// `inline` callees are always inlined, `noinline` ones never; any other callee
+// is inlined while its inlineCost is at most the threshold and the caller has
+// not grown past MaxCallerCost.
+class Inliner : public FunctionPass {
+public:
+    static constexpr unsigned DefaultThreshold = 40;
+    static constexpr unsigned MaxCallerCost = 2000;
+
+    explicit Inliner(unsigned threshold = DefaultThreshold) : threshold(threshold) {}
+
+    const char* getName() const override { return "inline"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+    bool changesCFG() const override { return true; }
+
+private:
+    unsigned threshold;
+};
+
+// Moves malloc allocations to the stack when analyzeHeapAllocations finds their
+// pointer never escapes: the call becomes an alloca at the top of the entry block
+// and the frees are dropped. Allocations inside a loop keep the heap, since one
+// stack slot would be shared by every iteration, as do those without a constant
+// size or larger than MaxStackBytes. Remarks list each allocation and its fate.
+class HeapToStack : public FunctionPass {
+public:
+    static constexpr uint64_t MaxStackBytes = 4096;
+
+    const char* getName() const override { return "heap-to-stack"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+};
+
+// promoteAllocas as a pass
+class Mem2Reg : public FunctionPass {
+public:
+    const char* getName() const override { return "mem2reg"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+};
+
+// Evaluates integer and bool BinOp/UnaryOp instructions whose operands are
+// constants, with the 32-bit wrapping CodeGenerator gives integer constants.
+// Division by zero, INT_MIN / -1 and out-of-range shifts are left alone.
+class ConstantFolding : public FunctionPass {
+public:
+    const char* getName() const override { return "const-fold"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+};
+
+// Replaces a value with an equivalent one already available: unary plus copies,
+// phis whose incoming values are all the same, constants and struct field
+// addresses repeated from a dominating block, and loads whose memory was stored
+// or loaded earlier in the same block with nothing in between that may write it.
+class CopyPropagation : public FunctionPass {
+public:
+    const char* getName() const override { return "copy-prop"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+};
+
+// Erases instructions without side effects whose results are unused, and
+// allocas that are only ever stored to along with those stores.
+class DeadCodeElimination : public FunctionPass {
+public:
+    const char* getName() const override { return "dce"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+};
+
+// What --bounds-checks asks for: no checks, a check before every index into a
+// fixed-size array that BoundsCheckElim cannot prove in bounds, or those checks
+// also hoisted out of loops
+enum class BoundsCheckMode { Off, On, Hoisted };
+
+// Removes bounds checks that cannot fail: constant indices in range, and indices
+// that are a for loop's counter (plus a constant) when the loop's start and bound
+// are constants that keep them in range. With hoisting, a remaining check on the
+// counter of a loop stepping by one, which runs on every iteration of a loop
+// left only through its header, becomes a single range check in front of the
+// loop; an out-of-bounds loop then traps before its first iteration rather than
+// at the faulting one. Remarks say what became of each check.
+class BoundsCheckElim : public FunctionPass {
+public:
+    explicit BoundsCheckElim(bool hoist = false) : hoist(hoist) {}
+
+    const char* getName() const override { return "bounds-check-elim"; }
+    bool run(MIRFunction& func, FunctionAnalyses& analyses) override;
+
+private:
+    bool hoist;
+};
+
+// The pipeline the compiler runs after MIR lowering
+void addDefaultPasses(PassManager& passManager, BoundsCheckMode boundsChecks = BoundsCheckMode::On);
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_PASSES_H
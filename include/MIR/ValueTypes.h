@@ -0,0 +1,19 @@
+#ifndef CHTHOLLY_VALUETYPES_H
+#define CHTHOLLY_VALUETYPES_H
+
+#include "MIR/Dominators.h"
+
+namespace chtholly {
+
+// The type CodeGenerator gives each value, replayed over the blocks in its emission
+// order: it decides the value's LLVM type and how loads through it are lowered.
+// MIR temporaries carry no type of their own, so a pass replacing one value with
+// another must check the two agree here.
+std::vector<std::shared_ptr<Type>> inferValueTypes(const MIRFunction& func, const MIRModule& module, const DominatorTree& domTree);
+
+// Null (unknown) only matches null
+bool sameValueType(const std::shared_ptr<Type>& a, const std::shared_ptr<Type>& b);
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_VALUETYPES_H
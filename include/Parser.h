@@ -1,7 +1,7 @@
 #ifndef CHTHOLLY_PARSER_H
 #define CHTHOLLY_PARSER_H
 
-#include "Lexer/Lexer.h"
+#include "Lexer/TokenStream.h"
 #include "AST/Declarations.h"
 #include "AST/Expressions.h"
 #include "AST/Statements.h"
@@ -51,6 +51,7 @@ public:
 private:
     Token advance();
     Token peek();
+    Token peekNext(); // token after the current one
     bool match(TokenType type);
     Token consume(TokenType type, const std::string& message);
 
@@ -59,10 +60,16 @@ private:
     std::shared_ptr<Type> parseType();
     std::unique_ptr<ConstraintExpr> parseConstraintExpr();
     bool isGenericContext();
+    // In an expression, whether the `[` ahead indexes rather than specializes, e.g. a[i] but add[T](x)
+    bool isIndexStart();
     std::vector<GenericParam> parseGenericParams();
     std::unique_ptr<Param> parseParam();
+    // `inline` or `noinline` before `fn`
+    static bool isInlineModifier(TokenType type) { return type == TokenType::Inline || type == TokenType::Noinline; }
+    InlineHint parseInlineHint();
 
-    Lexer m_lexer;
+    TokenStream m_tokens;
+    size_t m_index = 0;
     Token m_currentToken;
     std::vector<std::set<std::string>> m_activeGenericParams;
 };
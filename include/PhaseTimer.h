@@ -0,0 +1,44 @@
+#ifndef CHTHOLLY_PHASETIMER_H
+#define CHTHOLLY_PHASETIMER_H
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <chrono>
+#include <string>
+
+namespace chtholly {
+
+// Times one compiler phase for the -ftime-report summary and, under -ftime-trace,
+// records it as a Chrome trace event whose detail names the module, function or
+// instantiation being processed. Phases may nest and may run on codegen workers.
+// The phase name must outlive the timer; string literals are expected.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(llvm::StringRef phase, llvm::StringRef detail = "");
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    static void enableReport();
+    // Starts LLVM's time-trace profiler on the calling thread; shorter events are dropped from the trace
+    static void enableTrace(unsigned granularityUs);
+    static bool isTraceEnabled();
+
+    // Worker threads register with the profiler so their events are merged into the trace
+    static void beginThread();
+    static void endThread();
+
+    // Prints the report and writes the trace, whichever are enabled, then turns both off
+    static void finish(const std::string& traceFile);
+
+private:
+    llvm::StringRef phase;
+    bool timed;
+    std::chrono::steady_clock::time_point start;
+    llvm::TimeTraceScope trace;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_PHASETIMER_H
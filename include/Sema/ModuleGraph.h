@@ -0,0 +1,127 @@
+#ifndef CHTHOLLY_MODULEGRAPH_H
+#define CHTHOLLY_MODULEGRAPH_H
+
+#include "AST/ASTArena.h"
+#include "AST/ImportDecl.h"
+#include "Sema/ModuleInterface.h"
+#include "Sema/Sema.h"
+#include "Sema/SymbolTable.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chtholly {
+
+class ModuleCache;
+
+// Module name an import binds, and the prefix its declarations are mangled with
+std::string importModuleName(const ImportDecl& decl);
+// Prefixes a module's top-level function, struct, enum or class name with the module name
+void mangleModuleDecl(ASTNode* node, const std::string& moduleName);
+
+// Loads every file module reachable from a program's imports before the program
+// itself is analyzed. Imports are discovered by scanning each parsed module's
+// top-level import declarations; each wave of newly discovered modules is parsed
+// concurrently, then modules are analyzed in dependency order with independent
+// branches of the import DAG running in parallel. Worker threads have no active
+// TypeContext, so types built there are not interned.
+//
+// With an interface directory, every analyzed module leaves a ModuleInterface
+// there. A declarations-only build (nothing is lowered) binds an import from its
+// interface instead, as long as neither it nor anything it imports has changed.
+//
+// With a ModuleCache, modules analyzed by an earlier build in the same process
+// are reused the same way, bodies included, so they can be lowered again.
+class ModuleGraph {
+public:
+    struct ImportRef {
+        std::string path;
+        std::string name;
+    };
+
+    struct Module {
+        std::string path;
+        // Mangling prefix, taken from the first import of this file reached depth-first
+        std::string name;
+        uint64_t sourceHash = 0; // only computed when interfaces are in use
+        std::unique_ptr<ASTArena> arena;
+        std::vector<std::unique_ptr<ASTNode>> nodes;
+        std::vector<ImportRef> importRefs; // every file import as written, in source order
+        std::vector<Module*> imports; // direct file imports in the graph that built this, in source order
+        std::unique_ptr<Sema> sema;
+        std::optional<ModuleInterface> interface; // up-to-date interface standing in for the source
+        std::shared_ptr<const Module> cached; // module analyzed by an earlier build standing in for the source
+        std::shared_ptr<SymbolTable> symbols; // set once the module is analyzed
+    };
+
+    explicit ModuleGraph(unsigned jobs = 1);
+    ~ModuleGraph();
+
+    ModuleGraph(const ModuleGraph&) = delete;
+    ModuleGraph& operator=(const ModuleGraph&) = delete;
+
+    void setInterfaceDir(const std::string& dir) { interfaceDir = dir; }
+    // Set when no module will be lowered, which is what allows skipping their bodies
+    void setDeclarationsOnly(bool value) { declarationsOnly = value; }
+    // Reuses unchanged modules from earlier builds and keeps this build's for later ones
+    void setModuleCache(ModuleCache* value) { cache = value; }
+
+    // Throws std::runtime_error for unreadable files, import cycles and errors in any module
+    void build(const std::vector<std::unique_ptr<ASTNode>>& program);
+
+    const Module* find(const std::string& path) const;
+    size_t getNumModules() const { return modules.size(); }
+
+    // Lists every module's nodes, specializations included, dependencies first; the graph keeps owning them
+    void collectNodes(std::vector<ASTNode*>& nodes) const;
+
+private:
+    Module* addModule(const std::string& path);
+    std::vector<Module*> linkImports(Module* importer, const std::vector<ImportRef>& refs);
+    void parseAll(const std::vector<Module*>& batch, bool useInterfaces);
+    bool loadInterface(Module& module);
+    bool takeCached(Module& module);
+    std::vector<Module*> dropStaleInterfaces();
+    std::vector<Module*> dropStaleCachedModules();
+    void analyzeAll();
+    void analyzeModule(Module& module);
+    void writeInterface(const Module& module);
+    void storeInCache();
+
+    unsigned jobs;
+    std::string interfaceDir;
+    bool declarationsOnly = false;
+    ModuleCache* cache = nullptr;
+    std::vector<std::shared_ptr<Module>> modules; // discovery order
+    std::unordered_map<std::string, Module*> byPath;
+    std::vector<Module*> rootImports;
+};
+
+// Analyzed modules kept between the builds of a long-lived compiler, one per path.
+// An entry stands in for its file while the file's contents, the name it is
+// imported under and the modules it imports are all unchanged; anything else is
+// parsed and analyzed again and replaces the entry. Only the graph reads or
+// writes entries, and only one graph may use a cache at a time.
+class ModuleCache {
+public:
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+
+private:
+    friend class ModuleGraph;
+
+    struct Entry {
+        std::shared_ptr<const ModuleGraph::Module> module;
+        // What each of module->imports was when it was analyzed; the raw pointers may be gone
+        std::vector<std::shared_ptr<const ModuleGraph::Module>> imports;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_MODULEGRAPH_H
@@ -0,0 +1,63 @@
+#ifndef CHTHOLLY_MODULEINTERFACE_H
+#define CHTHOLLY_MODULEINTERFACE_H
+
+#include "AST/ASTNode.h"
+#include "Sema/SymbolTable.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chtholly {
+
+// Public surface of an analyzed module: its public symbols and types, plus the
+// source text of the generic declarations an importer needs to monomorphize.
+// Written to "<cache dir>/<source hash>.cnsi" after a module is analyzed, so a
+// later compilation can bind an unchanged import without parsing or analyzing it.
+// Bodies are not part of the interface; it only stands in for a module whose
+// code is not generated.
+struct ModuleInterface {
+    struct Import {
+        std::string path;
+        std::string name;
+        uint64_t sourceHash = 0; // hash of the imported file when this interface was written
+    };
+
+    struct Entry {
+        std::string name;
+        std::shared_ptr<Type> type; // null for generic and request declarations
+        bool isMutable = false;
+        int32_t decl = -1; // index into genericDecls, or -1
+    };
+
+    uint64_t sourceHash = 0;
+    std::vector<Import> imports;
+    std::vector<Entry> symbols;
+    std::vector<Entry> types;
+    std::vector<std::string> genericDecls;
+
+    static uint64_t hashSource(std::string_view source);
+    static std::string fileName(uint64_t sourceHash);
+
+    // Captures the public part of an analyzed module's table; std::nullopt if a
+    // generic declaration does not print back to source that parses
+    static std::optional<ModuleInterface> fromSymbolTable(uint64_t sourceHash, const SymbolTable& table);
+
+    // Builds a table holding only the public surface. Generic declarations are
+    // parsed into the active ASTArena and appended to `decls`, which must outlive the table
+    std::shared_ptr<SymbolTable> toSymbolTable(std::vector<std::unique_ptr<ASTNode>>& decls) const;
+
+    std::string serialize() const;
+    // std::nullopt for truncated files, other versions and anything else malformed
+    static std::optional<ModuleInterface> deserialize(std::string_view data);
+
+    // Replaces the file atomically so concurrent compilations never read half of one
+    bool write(const std::string& path) const;
+    static std::optional<ModuleInterface> read(const std::string& path);
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_MODULEINTERFACE_H
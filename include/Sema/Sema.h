@@ -5,12 +5,15 @@
 #include "AST/Declarations.h"
 #include "AST/Expressions.h"
 #include "AST/ImportDecl.h"
+#include "AST/ASTArena.h"
 #include "Sema/SymbolTable.h"
 #include "Sema/Substituter.h"
 #include <set>
 
 namespace chtholly {
 
+class ModuleGraph;
+
 class Sema {
 public:
     Sema();
@@ -21,6 +24,14 @@ public:
     std::vector<std::unique_ptr<ASTNode>>& getAnalyzedNodes() { return analyzedNodes; }
     const std::unordered_map<std::string, std::shared_ptr<SymbolTable>>& getModules() const { return modules; }
 
+    // Resolves file imports from an already analyzed graph instead of loading them inline
+    void setModuleGraph(const ModuleGraph* graph) { moduleGraph = graph; }
+    // Also lists every module's nodes, dependencies first, so they are lowered with this program;
+    // the graph keeps owning them and must outlive lowering
+    void adoptModules(const ModuleGraph& graph);
+    const std::vector<ASTNode*>& getModuleNodes() const { return moduleNodes; }
+    void moveNodesInto(std::vector<std::unique_ptr<ASTArena>>& arenas, std::vector<std::unique_ptr<ASTNode>>& nodes);
+
     // Monomorphization
     std::string mangleGenericName(const std::string& baseName, const std::vector<std::shared_ptr<Type>>& typeArgs);
     FunctionDecl* monomorphizeFunction(FunctionDecl* decl, const std::vector<std::shared_ptr<Type>>& typeArgs);
@@ -76,8 +87,12 @@ private:
     SymbolTable symbolTable;
     std::vector<std::shared_ptr<EnumType>> registeredEnums;
     std::set<std::string> loadedModules;
+    const ModuleGraph* moduleGraph = nullptr;
     std::unordered_map<std::string, std::shared_ptr<SymbolTable>> modules;
+    // One arena per imported module; declared before analyzedNodes so it outlives them
+    std::vector<std::unique_ptr<ASTArena>> moduleArenas;
     std::vector<std::unique_ptr<ASTNode>> analyzedNodes;
+    std::vector<ASTNode*> moduleNodes; // owned by the module graph
 
     // Monomorphization Cache (Ownership in analyzedNodes)
     std::unordered_map<std::string, FunctionDecl*> m_monomorphizedFunctions;
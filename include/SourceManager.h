@@ -0,0 +1,58 @@
+#ifndef CHTHOLLY_SOURCEMANAGER_H
+#define CHTHOLLY_SOURCEMANAGER_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace chtholly {
+
+// Owns the text of every source file read during one compilation. Files are
+// memory-mapped read-only where the OS allows it and read into memory otherwise,
+// so tokens can point straight into the file without copying it. Each path is
+// loaded at most once; its text stays valid until the manager is destroyed.
+class SourceManager {
+public:
+    SourceManager();
+    ~SourceManager();
+
+    SourceManager(const SourceManager&) = delete;
+    SourceManager& operator=(const SourceManager&) = delete;
+
+    // Returns std::nullopt if the file cannot be opened or read
+    std::optional<std::string_view> load(const std::string& path);
+
+    size_t getNumFiles() const { return files.size(); }
+
+    static SourceManager* current();
+
+    class Scope {
+    public:
+        explicit Scope(SourceManager& manager);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        SourceManager* previous;
+    };
+
+private:
+    struct File {
+        std::unique_ptr<llvm::MemoryBuffer> buffer;
+        std::string_view text;
+    };
+
+    std::unordered_map<std::string, File> files;
+};
+
+} // namespace chtholly
+
+#endif // CHTHOLLY_SOURCEMANAGER_H
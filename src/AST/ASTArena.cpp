@@ -0,0 +1,84 @@
+#include "AST/ASTArena.h"
+#include "AST/ASTNode.h"
+#include <cstdint>
+#include <new>
+
+namespace chtholly {
+
+namespace {
+
+thread_local ASTArena* currentArena = nullptr;
+
+// Every node is preceded by a header naming its arena, or nullptr for the heap,
+// so a node outliving its Scope is still deleted correctly
+struct alignas(std::max_align_t) NodeHeader {
+    ASTArena* arena;
+};
+
+} // namespace
+
+ASTArena::~ASTArena() {
+    for (char* slab : slabs) {
+        ::operator delete(slab);
+    }
+}
+
+void* ASTArena::allocate(std::size_t size, std::size_t align) {
+    auto alignUp = [align](char* p) {
+        return reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(p) + align - 1) & ~(std::uintptr_t)(align - 1));
+    };
+
+    bytesAllocated += size;
+
+    // Oversized requests get their own slab so the current one is not abandoned
+    if (size + align > SlabSize) {
+        char* slab = static_cast<char*>(::operator new(size + align));
+        slabs.push_back(slab);
+        bytesReserved += size + align;
+        return alignUp(slab);
+    }
+
+    char* aligned = cursor ? alignUp(cursor) : nullptr;
+    if (!aligned || aligned + size > end) {
+        char* slab = static_cast<char*>(::operator new(SlabSize));
+        slabs.push_back(slab);
+        bytesReserved += SlabSize;
+        end = slab + SlabSize;
+        aligned = alignUp(slab);
+    }
+    cursor = aligned + size;
+    return aligned;
+}
+
+ASTArena* ASTArena::current() {
+    return currentArena;
+}
+
+ASTArena::Scope::Scope(ASTArena& arena) : previous(currentArena) {
+    currentArena = &arena;
+}
+
+ASTArena::Scope::~Scope() {
+    currentArena = previous;
+}
+
+void* ASTNode::operator new(std::size_t size) {
+    void* mem;
+    if (currentArena) {
+        mem = currentArena->allocate(sizeof(NodeHeader) + size, alignof(NodeHeader));
+    } else {
+        mem = ::operator new(sizeof(NodeHeader) + size);
+    }
+    auto* header = new (mem) NodeHeader{currentArena};
+    return header + 1;
+}
+
+void ASTNode::operator delete(void* ptr) {
+    if (!ptr) return;
+    auto* header = static_cast<NodeHeader*>(ptr) - 1;
+    if (!header->arena) {
+        ::operator delete(header);
+    }
+}
+
+} // namespace chtholly
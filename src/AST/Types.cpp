@@ -1,7 +1,18 @@
 #include "AST/Types.h"
+#include <functional>
 
 namespace chtholly {
 
+namespace {
+
+thread_local TypeContext* currentContext = nullptr;
+
+size_t hashCombine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+} // namespace
+
 std::shared_ptr<Type> Type::getI8() {
     static auto instance = std::make_shared<PrimitiveType>(TypeKind::I8);
     return instance;
@@ -63,8 +74,72 @@ std::shared_ptr<Type> Type::getVoid() {
 }
 
 std::shared_ptr<Type> Type::getI8Ptr() {
-    static auto instance = std::make_shared<PointerType>(getI8());
+    // Seeded into every TypeContext, so it stays the interned i8* of each compilation
+    static std::shared_ptr<Type> instance = std::make_shared<PointerType>(getI8());
     return instance;
 }
 
+std::shared_ptr<PointerType> PointerType::get(const std::shared_ptr<Type>& baseType) {
+    if (auto* context = TypeContext::current()) return context->getPointerType(baseType);
+    return std::make_shared<PointerType>(baseType);
+}
+
+std::shared_ptr<ArrayType> ArrayType::get(const std::shared_ptr<Type>& baseType, int size) {
+    if (auto* context = TypeContext::current()) return context->getArrayType(baseType, size);
+    return std::make_shared<ArrayType>(baseType, size);
+}
+
+std::shared_ptr<FunctionType> FunctionType::get(const std::vector<std::shared_ptr<Type>>& params, const std::shared_ptr<Type>& returnType, bool isVariadic) {
+    if (auto* context = TypeContext::current()) return context->getFunctionType(params, returnType, isVariadic);
+    return std::make_shared<FunctionType>(params, returnType, isVariadic);
+}
+
+TypeContext::TypeContext() {
+    pointerTypes.emplace(Type::getI8().get(), std::static_pointer_cast<PointerType>(Type::getI8Ptr()));
+}
+
+TypeContext* TypeContext::current() {
+    return currentContext;
+}
+
+TypeContext::Scope::Scope(TypeContext& context) : previous(currentContext) {
+    currentContext = &context;
+}
+
+TypeContext::Scope::~Scope() {
+    currentContext = previous;
+}
+
+size_t TypeContext::KeyHash::operator()(const ArrayKey& key) const {
+    return hashCombine(std::hash<const Type*>()(key.base), std::hash<int>()(key.size));
+}
+
+size_t TypeContext::KeyHash::operator()(const FunctionKey& key) const {
+    size_t seed = hashCombine(std::hash<const Type*>()(key.returnType), key.isVariadic);
+    for (const Type* param : key.params) seed = hashCombine(seed, std::hash<const Type*>()(param));
+    return seed;
+}
+
+std::shared_ptr<PointerType> TypeContext::getPointerType(const std::shared_ptr<Type>& baseType) {
+    auto& entry = pointerTypes[baseType.get()];
+    if (!entry) entry = std::make_shared<PointerType>(baseType);
+    return entry;
+}
+
+std::shared_ptr<ArrayType> TypeContext::getArrayType(const std::shared_ptr<Type>& baseType, int size) {
+    auto& entry = arrayTypes[{baseType.get(), size}];
+    if (!entry) entry = std::make_shared<ArrayType>(baseType, size);
+    return entry;
+}
+
+std::shared_ptr<FunctionType> TypeContext::getFunctionType(const std::vector<std::shared_ptr<Type>>& params, const std::shared_ptr<Type>& returnType, bool isVariadic) {
+    FunctionKey key{{}, returnType.get(), isVariadic};
+    key.params.reserve(params.size());
+    for (const auto& p : params) key.params.push_back(p.get());
+
+    auto& entry = functionTypes[std::move(key)];
+    if (!entry) entry = std::make_shared<FunctionType>(params, returnType, isVariadic);
+    return entry;
+}
+
 } // namespace chtholly
@@ -1,24 +1,88 @@
 #include "Backend/CodeGenerator.h"
+#include "MIR/Dominators.h"
+#include "PhaseTimer.h"
+#include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/MC/TargetRegistry.h>
+#include <llvm/MC/MCSubtargetInfo.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/TargetParser/Host.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/raw_ostream.h>
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 
 namespace chtholly {
 
+namespace {
+
+llvm::OptimizationLevel toLLVMOptLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::OptimizationLevel::O0;
+        case OptLevel::O1: return llvm::OptimizationLevel::O1;
+        case OptLevel::O2: return llvm::OptimizationLevel::O2;
+        case OptLevel::O3: return llvm::OptimizationLevel::O3;
+    }
+    return llvm::OptimizationLevel::O0;
+}
+
+llvm::CodeGenOptLevel toCodeGenOptLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::CodeGenOptLevel::None;
+        case OptLevel::O1: return llvm::CodeGenOptLevel::Less;
+        case OptLevel::O2: return llvm::CodeGenOptLevel::Default;
+        case OptLevel::O3: return llvm::CodeGenOptLevel::Aggressive;
+    }
+    return llvm::CodeGenOptLevel::None;
+}
+
+// Rejects CPU names and -mattr features the target does not know; LLVM would only warn and fall back to generic
+bool checkSubtarget(const llvm::Target* target, const std::string& triple, const std::string& cpu, const std::string& explicitFeatures) {
+    std::unique_ptr<llvm::MCSubtargetInfo> subtarget(target->createMCSubtargetInfo(triple, "", ""));
+    if (!subtarget) return true;
+
+    if (cpu != "generic" && !subtarget->isCPUStringValid(cpu)) {
+        std::cerr << "CodeGenerator: Unknown target CPU '" << cpu << "' for " << triple << std::endl;
+        return false;
+    }
+
+    auto known = subtarget->getAllProcessorFeatures();
+    size_t start = 0;
+    while (start < explicitFeatures.size()) {
+        size_t comma = explicitFeatures.find(',', start);
+        if (comma == std::string::npos) comma = explicitFeatures.size();
+        std::string feature = explicitFeatures.substr(start, comma - start);
+        start = comma + 1;
+        if (feature.empty()) continue;
+        if (feature[0] == '+' || feature[0] == '-') feature = feature.substr(1);
+        bool found = std::any_of(known.begin(), known.end(), [&](const llvm::SubtargetFeatureKV& kv) { return feature == kv.Key; });
+        if (!found) {
+            std::cerr << "CodeGenerator: Unknown target feature '" << feature << "' for " << triple << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 CodeGenerator::CodeGenerator(MIRModule& mirModule) : mirModule(mirModule) {
     context = std::make_unique<llvm::LLVMContext>();
     llvmModule = std::make_unique<llvm::Module>("chtholly", *context);
     builder = std::make_unique<llvm::IRBuilder<>>(*context);
 }
 
+CodeGenerator::~CodeGenerator() = default;
+
 void CodeGenerator::generate() {
+    PhaseTimer timer("LLVM IR generation");
+
     // 1. Declare standard functions if used but not defined
     bool usesMalloc = false;
     bool usesFree = false;
@@ -51,6 +115,7 @@ void CodeGenerator::generate() {
         llvm::Function::Create(freeTy, llvm::Function::ExternalLinkage, "free", *llvmModule);
     }
 
+    functionsByID.assign(mirModule.getNumFunctionIDs(), nullptr);
     for (auto& func : mirModule.getFunctions()) {
         std::vector<llvm::Type*> paramTypes;
         for (const auto& param : func->getParameters()) {
@@ -63,7 +128,7 @@ void CodeGenerator::generate() {
             func->getVarArg()
         );
 
-        llvm::Function::Create(
+        functionsByID[func->getID()] = llvm::Function::Create(
             funcType, 
             llvm::Function::ExternalLinkage, 
             func->getName(), 
@@ -71,7 +136,14 @@ void CodeGenerator::generate() {
         );
     }
 
+    // Externals have an ID but no MIR function; bind them to the declarations made above
+    for (const char* external : {"malloc", "free"}) {
+        FunctionID id = mirModule.findFunctionID(external);
+        if (id != NoFunction && !functionsByID[id]) functionsByID[id] = llvmModule->getFunction(external);
+    }
+
     for (auto& func : mirModule.getFunctions()) {
+        if (!partition.empty() && !partition.count(func.get())) continue;
         generateFunction(func.get());
     }
 }
@@ -81,6 +153,7 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
     if (!func || mirFunc->getBlocks().empty()) {
         return;
     }
+    PhaseTimer timer("LLVM IR function", mirFunc->getName());
 
     std::map<std::string, llvm::BasicBlock*> blockMap;
     for (auto& mirBlock : mirFunc->getBlocks()) {
@@ -88,52 +161,68 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
         blockMap[mirBlock->getName()] = llvm::BasicBlock::Create(*context, mirBlock->getName(), func);
     }
 
-    valueMap.clear();
-    mirTypeMap.clear();
+    values.assign(mirFunc->getNumValues(), nullptr);
+    valueTypes.resize(mirFunc->getNumValues());
+    for (ValueID id = 0; id < mirFunc->getNumValues(); ++id) {
+        valueTypes[id] = mirFunc->getValueType(id);
+    }
+    auto nameOf = [mirFunc](ValueID id) -> const std::string& { return mirFunc->getValueName(id); };
 
-    // Add parameters to valueMap
     size_t argIdx = 0;
     for (auto& arg : func->args()) {
-        std::string argName = "%" + mirFunc->getParameters()[argIdx].first;
-        valueMap[argName] = &arg;
-        mirTypeMap[argName] = mirFunc->getParameters()[argIdx].second;
+        values[mirFunc->getParameterValue(argIdx)] = &arg;
         argIdx++;
     }
 
-    for (auto& mirBlock : mirFunc->getBlocks()) {
+    // Dominators are emitted before the blocks they dominate, so SSA values exist by the time they are used.
+    // Phis are filled in at the end, once every incoming value and the block it leaves from are known.
+    DominatorTree domTree(*mirFunc);
+    std::map<std::string, llvm::BasicBlock*> exitBlocks;
+    std::vector<std::pair<PhiInst*, llvm::PHINode*>> phis;
+    // Shared by the function's failing bounds checks
+    llvm::BasicBlock* trapBlock = nullptr;
+    for (BasicBlock* mirBlock : emissionOrder(*mirFunc, domTree)) {
         if (blockMap.find(mirBlock->getName()) == blockMap.end()) continue;
         builder->SetInsertPoint(blockMap[mirBlock->getName()]);
         
         for (auto& inst : mirBlock->getInstructions()) {
             switch (inst->getKind()) {
+                case MIRInstructionKind::Phi: {
+                    auto* phiInst = static_cast<PhiInst*>(inst.get());
+                    auto* phi = builder->CreatePHI(getLLVMType(phiInst->getType().get()), phiInst->getIncomings().size(), nameOf(phiInst->getDest()));
+                    values[phiInst->getDest()] = phi;
+                    valueTypes[phiInst->getDest()] = phiInst->getType();
+                    phis.push_back({phiInst, phi});
+                    break;
+                }
                 case MIRInstructionKind::Alloca: {
                     auto* allocaInst = static_cast<AllocaInst*>(inst.get());
                     auto* type = getLLVMType(allocaInst->getType().get());
-                    valueMap[allocaInst->getName()] = builder->CreateAlloca(type, nullptr, allocaInst->getName());
-                    mirTypeMap[allocaInst->getName()] = allocaInst->getType();
+                    values[allocaInst->getDest()] = createEntryBlockAlloca(func, type, nameOf(allocaInst->getDest()));
+                    valueTypes[allocaInst->getDest()] = allocaInst->getType();
                     break;
                 }
                 case MIRInstructionKind::Load: {
                     auto* loadInst = static_cast<LoadInst*>(inst.get());
-                    llvm::Value* ptr = valueMap[loadInst->getSrc()];
-                    auto chthollyTy = mirTypeMap[loadInst->getSrc()];
+                    llvm::Value* ptr = values[loadInst->getSrc()];
+                    auto chthollyTy = valueTypes[loadInst->getSrc()];
                     llvm::Type* llvmTy = getLLVMType(chthollyTy.get());
-                    valueMap[loadInst->getDest()] = builder->CreateLoad(llvmTy, ptr, loadInst->getDest());
-                    mirTypeMap[loadInst->getDest()] = chthollyTy;
+                    values[loadInst->getDest()] = builder->CreateLoad(llvmTy, ptr, nameOf(loadInst->getDest()));
+                    valueTypes[loadInst->getDest()] = chthollyTy;
                     break;
                 }
                 case MIRInstructionKind::Store: {
                     auto* storeInst = static_cast<StoreInst*>(inst.get());
-                    llvm::Value* val = valueMap[storeInst->getSrc()];
-                    llvm::Value* ptr = valueMap[storeInst->getDest()];
+                    llvm::Value* val = values[storeInst->getSrc()];
+                    llvm::Value* ptr = values[storeInst->getDest()];
                     builder->CreateStore(val, ptr);
                     break;
                 }
                 case MIRInstructionKind::BinOp: {
                     auto* binOp = static_cast<BinOpInst*>(inst.get());
-                    llvm::Value* left = valueMap[binOp->getLeft()];
-                    llvm::Value* right = valueMap[binOp->getRight()];
-                    auto chthollyTy = mirTypeMap[binOp->getLeft()];
+                    llvm::Value* left = values[binOp->getLeft()];
+                    llvm::Value* right = values[binOp->getRight()];
+                    auto chthollyTy = valueTypes[binOp->getLeft()];
                     bool isUnsigned = chthollyTy && chthollyTy->isUnsigned();
                     
                     llvm::Value* res = nullptr;
@@ -170,14 +259,14 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
                         case TokenType::Caret: res = builder->CreateXor(left, right); break;
                         default: break;
                     }
-                    valueMap[binOp->getDest()] = res;
-                    mirTypeMap[binOp->getDest()] = mirTypeMap[binOp->getLeft()];
+                    values[binOp->getDest()] = res;
+                    valueTypes[binOp->getDest()] = res && res->getType()->isIntegerTy(1) ? Type::getBool() : valueTypes[binOp->getLeft()];
                     break;
                 }
                 case MIRInstructionKind::UnaryOp: {
                     auto* unaryOp = static_cast<UnaryOpInst*>(inst.get());
-                    llvm::Value* operand = valueMap[unaryOp->getOperand()];
-                    auto chthollyTy = mirTypeMap[unaryOp->getOperand()];
+                    llvm::Value* operand = values[unaryOp->getOperand()];
+                    auto chthollyTy = valueTypes[unaryOp->getOperand()];
                     
                     llvm::Value* res = nullptr;
                     switch (unaryOp->getOp()) {
@@ -190,37 +279,40 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
                         case TokenType::Tilde: res = builder->CreateNot(operand); break;
                         default: break;
                     }
-                    valueMap[unaryOp->getDest()] = res;
-                    mirTypeMap[unaryOp->getDest()] = chthollyTy;
+                    values[unaryOp->getDest()] = res;
+                    valueTypes[unaryOp->getDest()] = chthollyTy;
                     break;
                 }
                 case MIRInstructionKind::Call: {
                     auto* call = static_cast<CallInst*>(inst.get());
-                    llvm::Function* callee = llvmModule->getFunction(call->getCallee());
+                    FunctionID calleeID = call->getCalleeID();
+                    llvm::Function* callee = calleeID < functionsByID.size() ? functionsByID[calleeID] : nullptr;
+                    // Calls built without an ID are resolved by name
+                    if (!callee) callee = llvmModule->getFunction(call->getCallee());
                     if (!callee) throw std::runtime_error("Undefined function: " + call->getCallee());
                     
                     std::vector<llvm::Value*> args;
-                    for (const auto& argName : call->getArgs()) {
-                        args.push_back(valueMap[argName]);
+                    for (ValueID arg : call->getArgs()) {
+                        args.push_back(values[arg]);
                     }
                     
-                    if (callee->getReturnType()->isVoidTy()) {
+                    if (callee->getReturnType()->isVoidTy() || call->getDest() == NoValue) {
                         builder->CreateCall(callee, args);
                     } else {
-                        valueMap[call->getDest()] = builder->CreateCall(callee, args, call->getDest());
-                        auto* targetFunc = mirModule.getFunction(call->getCallee());
+                        values[call->getDest()] = builder->CreateCall(callee, args, nameOf(call->getDest()));
+                        auto* targetFunc = calleeID != NoFunction ? mirModule.getFunction(calleeID) : mirModule.getFunction(call->getCallee());
                         if (targetFunc) {
-                            mirTypeMap[call->getDest()] = targetFunc->getReturnType();
+                            valueTypes[call->getDest()] = targetFunc->getReturnType();
                         }
                     }
                     break;
                 }
                 case MIRInstructionKind::Ret: {
                     auto* ret = static_cast<ReturnInst*>(inst.get());
-                    if (ret->getVal().empty()) {
+                    if (ret->getVal() == NoValue) {
                         builder->CreateRetVoid();
                     } else {
-                        builder->CreateRet(valueMap[ret->getVal()]);
+                        builder->CreateRet(values[ret->getVal()]);
                     }
                     break;
                 }
@@ -231,23 +323,58 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
                 }
                 case MIRInstructionKind::CondBr: {
                     auto* condBr = static_cast<CondBrInst*>(inst.get());
-                    builder->CreateCondBr(valueMap[condBr->getCond()], 
+                    builder->CreateCondBr(values[condBr->getCond()], 
                                           blockMap[condBr->getThenLabel()], 
                                           blockMap[condBr->getElseLabel()]);
                     break;
                 }
                 case MIRInstructionKind::ArrayElementPtr: {
                     auto* aepInst = static_cast<ArrayElementPtrInst*>(inst.get());
-                    llvm::Value* arrayPtr = valueMap[aepInst->getPtr()];
-                    llvm::Value* index = valueMap[aepInst->getIndex()];
+                    llvm::Value* arrayPtr = values[aepInst->getPtr()];
+                    llvm::Value* index = values[aepInst->getIndex()];
                     llvm::Type* elemTy = getLLVMType(aepInst->getElementType().get());
-                    valueMap[aepInst->getDest()] = builder->CreateGEP(elemTy, arrayPtr, index, aepInst->getDest());
-                    mirTypeMap[aepInst->getDest()] = std::make_shared<PointerType>(aepInst->getElementType());
+                    values[aepInst->getDest()] = builder->CreateGEP(elemTy, arrayPtr, index, nameOf(aepInst->getDest()));
+                    valueTypes[aepInst->getDest()] = PointerType::get(aepInst->getElementType());
+                    break;
+                }
+                case MIRInstructionKind::BoundsCheck: {
+                    auto* check = static_cast<BoundsCheckInst*>(inst.get());
+                    llvm::Type* i64 = llvm::Type::getInt64Ty(*context);
+                    llvm::Value* length = llvm::ConstantInt::get(i64, check->getLength());
+                    // Indices are compared as i64, widened by the signedness of the checked type
+                    ValueID typed = check->getEnd() == NoValue ? check->getIndex() : check->getEnd();
+                    bool isUnsigned = valueTypes[typed] && valueTypes[typed]->isUnsigned();
+                    auto widen = [&](ValueID value) {
+                        return isUnsigned ? builder->CreateZExtOrTrunc(values[value], i64) : builder->CreateSExtOrTrunc(values[value], i64);
+                    };
+
+                    llvm::Value* inBounds = nullptr;
+                    if (check->getEnd() == NoValue) {
+                        // A negative index is a huge unsigned one, so one compare covers both ends
+                        inBounds = builder->CreateICmpULT(widen(check->getIndex()), length);
+                    } else {
+                        llvm::Value* first = widen(check->getIndex());
+                        llvm::Value* end = widen(check->getEnd());
+                        llvm::Value* empty = isUnsigned ? builder->CreateICmpULE(end, first) : builder->CreateICmpSLE(end, first);
+                        llvm::Value* fits = isUnsigned ? builder->CreateICmpULE(end, length)
+                                                       : builder->CreateAnd(builder->CreateICmpSGE(first, llvm::ConstantInt::get(i64, 0)), builder->CreateICmpSLE(end, length));
+                        inBounds = builder->CreateOr(empty, fits);
+                    }
+
+                    if (!trapBlock) {
+                        trapBlock = llvm::BasicBlock::Create(*context, "bounds.fail", func);
+                        llvm::IRBuilder<> trapBuilder(trapBlock);
+                        trapBuilder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+                        trapBuilder.CreateUnreachable();
+                    }
+                    auto* rest = llvm::BasicBlock::Create(*context, mirBlock->getName() + ".inbounds", func);
+                    builder->CreateCondBr(inBounds, rest, trapBlock);
+                    builder->SetInsertPoint(rest);
                     break;
                 }
                 case MIRInstructionKind::StructElementPtr: {
                     auto* sepInst = static_cast<StructElementPtrInst*>(inst.get());
-                    llvm::Value* ptr = valueMap[sepInst->getPtr()];
+                    llvm::Value* ptr = values[sepInst->getPtr()];
                     
                     auto chthollyStructTy = structDefMap[sepInst->getStructName()];
                     if (!chthollyStructTy) {
@@ -268,26 +395,26 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
                         throw std::runtime_error("Field '" + sepInst->getFieldName() + "' not found in struct " + sepInst->getStructName());
                     }
 
-                    valueMap[sepInst->getDest()] = builder->CreateStructGEP(llvmStructTy, ptr, fieldIndex, sepInst->getDest());
-                    mirTypeMap[sepInst->getDest()] = fields[fieldIndex].type;
+                    values[sepInst->getDest()] = builder->CreateStructGEP(llvmStructTy, ptr, fieldIndex, nameOf(sepInst->getDest()));
+                    valueTypes[sepInst->getDest()] = fields[fieldIndex].type;
                     break;
                 }
                 case MIRInstructionKind::VariantTag: {
                     auto* vTagInst = static_cast<VariantTagInst*>(inst.get());
-                    llvm::Value* enumPtr = valueMap[vTagInst->getEnumPtr()];
-                    auto chthollyTy = mirTypeMap[vTagInst->getEnumPtr()];
+                    llvm::Value* enumPtr = values[vTagInst->getEnumPtr()];
+                    auto chthollyTy = valueTypes[vTagInst->getEnumPtr()];
                     auto enumTy = std::dynamic_pointer_cast<EnumType>(chthollyTy);
                     auto* llvmEnumTy = enumMap[enumTy->getName()];
 
                     llvm::Value* tagPtr = builder->CreateStructGEP(llvmEnumTy, enumPtr, 0, "tagptr");
-                    valueMap[vTagInst->getDest()] = builder->CreateLoad(llvm::Type::getInt32Ty(*context), tagPtr, vTagInst->getDest());
-                    mirTypeMap[vTagInst->getDest()] = Type::getI32();
+                    values[vTagInst->getDest()] = builder->CreateLoad(llvm::Type::getInt32Ty(*context), tagPtr, nameOf(vTagInst->getDest()));
+                    valueTypes[vTagInst->getDest()] = Type::getI32();
                     break;
                 }
                 case MIRInstructionKind::VariantData: {
                     auto* vDataInst = static_cast<VariantDataInst*>(inst.get());
-                    llvm::Value* enumPtr = valueMap[vDataInst->getEnumPtr()];
-                    auto chthollyTy = mirTypeMap[vDataInst->getEnumPtr()];
+                    llvm::Value* enumPtr = values[vDataInst->getEnumPtr()];
+                    auto chthollyTy = valueTypes[vDataInst->getEnumPtr()];
                     auto enumTy = std::dynamic_pointer_cast<EnumType>(chthollyTy);
                     auto* llvmEnumTy = enumMap[enumTy->getName()];
                     const auto& variant = enumTy->getVariants()[vDataInst->getTag()];
@@ -307,15 +434,15 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
                         llvm::Value* castedPtr = builder->CreatePointerCast(dataPtr, llvm::PointerType::get(variantTy, 0));
                         for (size_t i = 0; i < vDataInst->getArgs().size(); ++i) {
                             llvm::Value* fieldPtr = builder->CreateStructGEP(variantTy, castedPtr, (unsigned)i);
-                            builder->CreateStore(valueMap[vDataInst->getArgs()[i]], fieldPtr);
+                            builder->CreateStore(values[vDataInst->getArgs()[i]], fieldPtr);
                         }
                     }
                     break;
                 }
                 case MIRInstructionKind::VariantExtract: {
                     auto* vExtInst = static_cast<VariantExtractInst*>(inst.get());
-                    llvm::Value* enumPtr = valueMap[vExtInst->getEnumPtr()];
-                    auto chthollyTy = mirTypeMap[vExtInst->getEnumPtr()];
+                    llvm::Value* enumPtr = values[vExtInst->getEnumPtr()];
+                    auto chthollyTy = valueTypes[vExtInst->getEnumPtr()];
                     auto enumTy = std::dynamic_pointer_cast<EnumType>(chthollyTy);
                     auto* llvmEnumTy = enumMap[enumTy->getName()];
                     const auto& variant = enumTy->getVariants()[vExtInst->getTag()];
@@ -332,24 +459,24 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
                     llvm::Value* fieldPtr = builder->CreateStructGEP(variantTy, castedPtr, (unsigned)vExtInst->getFieldIndex());
                     
                     llvm::Type* llvmFieldTy = getLLVMType(vExtInst->getFieldType().get());
-                    valueMap[vExtInst->getDest()] = builder->CreateLoad(llvmFieldTy, fieldPtr, vExtInst->getDest());
-                    mirTypeMap[vExtInst->getDest()] = vExtInst->getFieldType();
+                    values[vExtInst->getDest()] = builder->CreateLoad(llvmFieldTy, fieldPtr, nameOf(vExtInst->getDest()));
+                    valueTypes[vExtInst->getDest()] = vExtInst->getFieldType();
                     break;
                 }
                 case MIRInstructionKind::Sizeof: {
                     auto* sizeofInst = static_cast<SizeofInst*>(inst.get());
                     llvm::Type* llvmTy = getLLVMType(sizeofInst->getType().get());
                     uint64_t size = llvmModule->getDataLayout().getTypeAllocSize(llvmTy);
-                    valueMap[sizeofInst->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context), size);
-                    mirTypeMap[sizeofInst->getDest()] = Type::getI64();
+                    values[sizeofInst->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context), size);
+                    valueTypes[sizeofInst->getDest()] = Type::getI64();
                     break;
                 }
                 case MIRInstructionKind::Alignof: {
                     auto* alignofInst = static_cast<AlignofInst*>(inst.get());
                     llvm::Type* llvmTy = getLLVMType(alignofInst->getType().get());
                     uint64_t align = llvmModule->getDataLayout().getABITypeAlign(llvmTy).value();
-                    valueMap[alignofInst->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context), align);
-                    mirTypeMap[alignofInst->getDest()] = Type::getI64();
+                    values[alignofInst->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context), align);
+                    valueTypes[alignofInst->getDest()] = Type::getI64();
                     break;
                 }
                 case MIRInstructionKind::Offsetof: {
@@ -363,41 +490,57 @@ void CodeGenerator::generateFunction(MIRFunction* mirFunc) {
 
                     const llvm::StructLayout* layout = llvmModule->getDataLayout().getStructLayout(llvmTy);
                     uint64_t offset = layout->getElementOffset(fieldIndex);
-                    valueMap[offsetofInst->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context), offset);
-                    mirTypeMap[offsetofInst->getDest()] = Type::getI64();
+                    values[offsetofInst->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*context), offset);
+                    valueTypes[offsetofInst->getDest()] = Type::getI64();
                     break;
                 }
                 case MIRInstructionKind::ConstInt: {
                     auto* constInt = static_cast<ConstIntInst*>(inst.get());
-                    valueMap[constInt->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), constInt->getValue());
-                    mirTypeMap[constInt->getDest()] = Type::getI32();
+                    values[constInt->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), constInt->getValue());
+                    valueTypes[constInt->getDest()] = Type::getI32();
                     break;
                 }
                 case MIRInstructionKind::ConstBool: {
                     auto* constBool = static_cast<ConstBoolInst*>(inst.get());
-                    valueMap[constBool->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt1Ty(*context), constBool->getValue());
-                    mirTypeMap[constBool->getDest()] = Type::getBool();
+                    values[constBool->getDest()] = llvm::ConstantInt::get(llvm::Type::getInt1Ty(*context), constBool->getValue());
+                    valueTypes[constBool->getDest()] = Type::getBool();
                     break;
                 }
                 case MIRInstructionKind::ConstString: {
                     auto* constString = static_cast<ConstStringInst*>(inst.get());
-                    valueMap[constString->getDest()] = getOrCreateGlobalString(constString->getValue());
-                    mirTypeMap[constString->getDest()] = Type::getI8Ptr();
+                    values[constString->getDest()] = getOrCreateGlobalString(constString->getValue());
+                    valueTypes[constString->getDest()] = Type::getI8Ptr();
                     break;
                 }
                 case MIRInstructionKind::ConstDouble: {
                     auto* constDouble = static_cast<ConstDoubleInst*>(inst.get());
-                    valueMap[constDouble->getDest()] = llvm::ConstantFP::get(llvm::Type::getDoubleTy(*context), constDouble->getValue());
-                    mirTypeMap[constDouble->getDest()] = Type::getF64();
+                    values[constDouble->getDest()] = llvm::ConstantFP::get(llvm::Type::getDoubleTy(*context), constDouble->getValue());
+                    valueTypes[constDouble->getDest()] = Type::getF64();
                     break;
                 }
             }
         }
+        exitBlocks[mirBlock->getName()] = builder->GetInsertBlock();
+    }
+
+    for (auto& [phiInst, phi] : phis) {
+        for (const auto& incoming : phiInst->getIncomings()) {
+            llvm::Value* value = incoming.value == NoValue ? llvm::UndefValue::get(phi->getType()) : values[incoming.value];
+            phi->addIncoming(value, exitBlocks[incoming.block]);
+        }
     }
 
     llvm::verifyFunction(*func);
 }
 
+llvm::AllocaInst* CodeGenerator::createEntryBlockAlloca(llvm::Function* func, llvm::Type* type, const std::string& name) {
+    // Keep every stack slot in the entry block so mem2reg/SROA can promote it,
+    // even when the MIR alloca sits inside a loop body.
+    llvm::BasicBlock& entry = func->getEntryBlock();
+    llvm::IRBuilder<> entryBuilder(&entry, entry.begin());
+    return entryBuilder.CreateAlloca(type, nullptr, name);
+}
+
 llvm::Value* CodeGenerator::getOrCreateGlobalString(const std::string& str) {
     if (globalStrings.count(str)) return globalStrings[str];
     llvm::Value* ptr = builder->CreateGlobalStringPtr(str);
@@ -485,59 +628,168 @@ llvm::Type* CodeGenerator::getLLVMType(Type* chthollyType) {
     return llvm::Type::getVoidTy(*context);
 }
 
-void CodeGenerator::emitObjectFile(const std::string& filename) {
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+bool CodeGenerator::prepareModule() {
+    if (prepared) return true;
 
     auto targetTriple = llvm::sys::getDefaultTargetTriple();
     llvmModule->setTargetTriple(targetTriple);
 
-    std::string error;
-    auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+    std::string CPU = resolveTargetCPU();
+    std::string features = resolveTargetFeatures();
 
-    if (!target) {
-        std::cerr << "CodeGenerator: Failed to lookup target: " << error << std::endl;
-        return;
-    }
+    // A target machine handed in through setTargetMachine was checked when it was created
+    if (!targetMachine) {
+        // Target registration is global; partitions may be prepared on several threads at once
+        static std::once_flag targetsInitialized;
+        std::call_once(targetsInitialized, [] {
+            llvm::InitializeNativeTarget();
+            llvm::InitializeNativeTargetAsmPrinter();
+            llvm::InitializeNativeTargetAsmParser();
+        });
+
+        std::string error;
+        auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+
+        if (!target) {
+            std::cerr << "CodeGenerator: Failed to lookup target: " << error << std::endl;
+            return false;
+        }
 
-    auto CPU = "generic";
-    auto features = "";
+        if (!checkSubtarget(target, targetTriple, CPU, targetFeatures)) return false;
 
-    llvm::TargetOptions opt;
-    auto RM = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);
-    auto targetMachine = target->createTargetMachine(targetTriple, CPU, features, opt, RM);
+        llvm::TargetOptions opt;
+        auto RM = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);
+        targetMachine.reset(target->createTargetMachine(targetTriple, CPU, features, opt, RM, std::nullopt, toCodeGenOptLevel(optLevel)));
 
-    if (!targetMachine) {
-        std::cerr << "CodeGenerator: Failed to create target machine" << std::endl;
-        return;
+        if (!targetMachine) {
+            std::cerr << "CodeGenerator: Failed to create target machine" << std::endl;
+            return false;
+        }
     }
 
     llvmModule->setDataLayout(targetMachine->createDataLayout());
 
+    // Stamp the subtarget on every definition so the IR-level cost models agree with instruction selection
+    if (CPU != "generic" || !features.empty()) {
+        for (auto& func : *llvmModule) {
+            if (func.isDeclaration()) continue;
+            func.addFnAttr("target-cpu", CPU);
+            if (!features.empty()) func.addFnAttr("target-features", features);
+        }
+    }
+
+    if (llvm::verifyModule(*llvmModule, &llvm::errs())) {
+        std::cerr << "CodeGenerator: Module verification FAILED!" << std::endl;
+        return false;
+    }
+
+    runOptimizationPipeline(targetMachine.get());
+    prepared = true;
+    return true;
+}
+
+bool CodeGenerator::emitObjectFile(const std::string& filename) {
+    if (!prepareModule()) return false;
+
     std::error_code EC;
     llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
 
     if (EC) {
         std::cerr << "CodeGenerator: Could not open file: " << EC.message() << std::endl;
-        return;
+        return false;
+    }
+
+    bool emitted = emitObject(dest);
+    dest.close();
+    if (dest.has_error()) {
+        std::cerr << "CodeGenerator: Could not write " << filename << ": " << dest.error().message() << std::endl;
+        dest.clear_error();
+        emitted = false;
     }
+    // Never leave a truncated object behind for a later link to pick up
+    if (!emitted) llvm::sys::fs::remove(filename);
+    return emitted;
+}
+
+bool CodeGenerator::emitObjectToBuffer(llvm::SmallVectorImpl<char>& buffer) {
+    if (!prepareModule()) return false;
 
+    llvm::raw_svector_ostream dest(buffer);
+    return emitObject(dest);
+}
+
+bool CodeGenerator::emitObject(llvm::raw_pwrite_stream& dest) {
+    PhaseTimer timer("Object emission");
     llvm::legacy::PassManager pass;
     auto fileType = llvm::CodeGenFileType::ObjectFile;
 
     if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
         std::cerr << "CodeGenerator: TargetMachine can't emit a file of this type" << std::endl;
-        return;
-    }
-
-    if (llvm::verifyModule(*llvmModule, &llvm::errs())) {
-        std::cerr << "CodeGenerator: Module verification FAILED!" << std::endl;
-        return;
+        return false;
     }
 
     pass.run(*llvmModule);
     dest.flush();
+    return true;
+}
+
+std::string CodeGenerator::resolveTargetCPU() const {
+    if (targetCPU.empty()) return "generic";
+    if (targetCPU == "native") return llvm::sys::getHostCPUName().str();
+    return targetCPU;
+}
+
+std::string CodeGenerator::resolveTargetFeatures() const {
+    std::vector<std::string> list;
+    if (targetCPU == "native") {
+        llvm::StringMap<bool> hostFeatures;
+        if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+            for (const auto& feature : hostFeatures) {
+                list.push_back((feature.second ? "+" : "-") + feature.first().str());
+            }
+        }
+    }
+
+    // Explicit -mattr entries come last so they override anything detected on the host
+    size_t start = 0;
+    while (start < targetFeatures.size()) {
+        size_t comma = targetFeatures.find(',', start);
+        if (comma == std::string::npos) comma = targetFeatures.size();
+        std::string feature = targetFeatures.substr(start, comma - start);
+        if (!feature.empty()) {
+            if (feature[0] != '+' && feature[0] != '-') feature = "+" + feature;
+            list.push_back(feature);
+        }
+        start = comma + 1;
+    }
+
+    std::string res;
+    for (size_t i = 0; i < list.size(); ++i) {
+        res += list[i];
+        if (i < list.size() - 1) res += ",";
+    }
+    return res;
+}
+
+void CodeGenerator::runOptimizationPipeline(llvm::TargetMachine* targetMachine) {
+    if (optLevel == OptLevel::O0) return;
+    PhaseTimer timer("LLVM optimization");
+
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    // Passing the TargetMachine gives the vectorizers and the inliner real cost models
+    llvm::PassBuilder PB(targetMachine);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(toLLVMOptLevel(optLevel));
+    MPM.run(*llvmModule, MAM);
 }
 
 } // namespace chtholly
@@ -0,0 +1,70 @@
+#include "Backend/JIT.h"
+#include "PhaseTimer.h"
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/TargetExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/ADT/SmallVector.h>
+#include <stdexcept>
+
+namespace chtholly {
+
+JIT::JIT() = default;
+JIT::~JIT() = default;
+
+int JIT::runMain(CodeGenerator& codegen, const std::string& programName, const std::vector<std::string>& args) {
+    MainFn mainFn = compileMain(codegen, programName);
+    // The program's own run time is not a compiler phase, so it stays outside every PhaseTimer
+    return llvm::orc::runAsMain(mainFn, args, llvm::StringRef(programName));
+}
+
+JIT::MainFn JIT::compileMain(CodeGenerator& codegen, const std::string& programName) {
+    if (!codegen.prepareModule()) {
+        throw std::runtime_error("JIT: Failed to prepare module");
+    }
+
+    // Mirror the AOT target machine so the optimized IR and its data layout match what the JIT compiles for
+    llvm::TargetMachine* targetMachine = codegen.getTargetMachine();
+    llvm::orc::JITTargetMachineBuilder JTMB(targetMachine->getTargetTriple());
+    JTMB.setCPU(targetMachine->getTargetCPU().str());
+    JTMB.setCodeGenOptLevel(targetMachine->getOptLevel());
+
+    llvm::SmallVector<llvm::StringRef, 16> featureList;
+    targetMachine->getTargetFeatureString().split(featureList, ',', -1, false);
+    for (auto feature : featureList) {
+        JTMB.getFeatures().AddFeature(feature);
+    }
+
+    PhaseTimer timer("JIT compile", programName);
+    auto lljit = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(JTMB)).create();
+    if (!lljit) {
+        throw std::runtime_error("JIT: " + llvm::toString(lljit.takeError()));
+    }
+
+    // Resolve libc (printf, malloc, ...) against the host process
+    auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*lljit)->getDataLayout().getGlobalPrefix());
+    if (!generator) {
+        throw std::runtime_error("JIT: " + llvm::toString(generator.takeError()));
+    }
+    (*lljit)->getMainJITDylib().addGenerator(std::move(*generator));
+
+    auto module = codegen.takeLLVMModule();
+    auto context = codegen.takeLLVMContext();
+    llvm::orc::ThreadSafeModule threadSafeModule(std::move(module), std::move(context));
+    if (auto err = (*lljit)->addIRModule(std::move(threadSafeModule))) {
+        throw std::runtime_error("JIT: " + llvm::toString(std::move(err)));
+    }
+
+    // Looking main up materializes the module, so machine code generation happens here
+    auto mainSym = (*lljit)->lookup("main");
+    if (!mainSym) {
+        throw std::runtime_error("JIT: " + llvm::toString(mainSym.takeError()));
+    }
+
+    this->jit = std::move(*lljit);
+    return mainSym->toPtr<MainFn>();
+}
+
+} // namespace chtholly
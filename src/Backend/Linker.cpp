@@ -3,11 +3,38 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <memory>
+#include <optional>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FileUtilities.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdlib>
 
 namespace chtholly {
 
 Linker::Linker() {
+#ifdef _WIN32
     loadToolPaths();
+#else
+    findDriver();
+#endif
+}
+
+bool Linker::findDriver() {
+    // The C compiler driver knows the host's crt objects, libc and dynamic loader, which bare ld does not
+    std::vector<std::string> candidates;
+    if (const char* cc = std::getenv("CC")) candidates.push_back(cc);
+    candidates.insert(candidates.end(), {"cc", "gcc", "clang"});
+
+    for (const auto& name : candidates) {
+        auto path = llvm::sys::findProgramByName(name);
+        if (path) {
+            m_driverPath = *path;
+            return true;
+        }
+    }
+    return false;
 }
 
 bool Linker::loadToolPaths() {
@@ -145,6 +172,33 @@ bool Linker::loadToolPaths() {
 
 
 bool Linker::invoke(const std::string& objFile, const std::string& exeFile) {
+    return invoke(std::vector<std::string>{objFile}, exeFile);
+}
+
+bool Linker::invoke(const std::vector<std::string>& objFiles, const std::string& exeFile) {
+#ifndef _WIN32
+    if (m_driverPath.empty()) {
+        std::cerr << "Linker: No C compiler driver (cc, gcc, clang) found on PATH" << std::endl;
+        return false;
+    }
+
+    std::vector<llvm::StringRef> args = {m_driverPath};
+    std::cout << "Executing linker: " << m_driverPath;
+    for (const auto& objFile : objFiles) {
+        args.push_back(objFile);
+        std::cout << " " << objFile;
+    }
+    args.insert(args.end(), {"-o", exeFile});
+    std::cout << " -o " << exeFile << std::endl;
+
+    std::string errMsg;
+    int result = llvm::sys::ExecuteAndWait(m_driverPath, args, std::nullopt, {}, 0, 0, &errMsg);
+    if (result < 0) {
+        std::cerr << "Linker: " << errMsg << std::endl;
+    }
+    return result == 0;
+#else
+
 
     if (m_linkerPath.empty()) {
 
@@ -160,7 +214,11 @@ bool Linker::invoke(const std::string& objFile, const std::string& exeFile) {
 
     cmd << "\"" << m_linkerPath << "\" ";
 
-    cmd << objFile << " ";
+    for (const auto& objFile : objFiles) {
+
+        cmd << objFile << " ";
+
+    }
 
     cmd << "/OUT:\"" << exeFile << "\" ";
 
@@ -192,6 +250,55 @@ bool Linker::invoke(const std::string& objFile, const std::string& exeFile) {
 
     return result == 0;
 
+#endif
+}
+
+bool Linker::writeTemporaryObject(llvm::ArrayRef<char> object, std::string& objPath) {
+#ifdef _WIN32
+    const char* suffix = "obj";
+#else
+    const char* suffix = "o";
+#endif
+    int fd;
+    llvm::SmallString<128> path;
+    if (auto EC = llvm::sys::fs::createTemporaryFile("chtholly", suffix, fd, path)) {
+        std::cerr << "Linker: Could not create temporary object: " << EC.message() << std::endl;
+        return false;
+    }
+    objPath = path.str().str();
+
+    llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+    out.write(object.data(), object.size());
+    out.close();
+    if (out.has_error()) {
+        std::cerr << "Linker: Could not write temporary object " << objPath << ": " << out.error().message() << std::endl;
+        // A stream destroyed with a pending error aborts the process
+        out.clear_error();
+        llvm::sys::fs::remove(objPath);
+        return false;
+    }
+    return true;
+}
+
+bool Linker::invoke(llvm::ArrayRef<char> object, const std::string& exeFile) {
+    std::string objPath;
+    if (!writeTemporaryObject(object, objPath)) return false;
+    llvm::FileRemover remover(objPath);
+
+    return invoke(objPath, exeFile);
+}
+
+bool Linker::invoke(const std::vector<llvm::SmallVector<char, 0>>& objects, const std::string& exeFile) {
+    std::vector<std::string> objPaths;
+    std::vector<std::unique_ptr<llvm::FileRemover>> removers;
+    for (const auto& object : objects) {
+        std::string objPath;
+        if (!writeTemporaryObject(object, objPath)) return false;
+        removers.push_back(std::make_unique<llvm::FileRemover>(objPath));
+        objPaths.push_back(objPath);
+    }
+
+    return invoke(objPaths, exeFile);
 }
 
 } // namespace chtholly
@@ -0,0 +1,292 @@
+#include "Backend/ObjectCache.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace chtholly {
+
+namespace {
+
+// Registers the node codegen would use for each struct or enum name, recursing like CodeGenerator::getLLVMType
+void collectNominalTypes(const Type* type, std::unordered_map<std::string, const Type*>& nominal) {
+    if (!type) return;
+    switch (type->getKind()) {
+        case TypeKind::Pointer:
+            collectNominalTypes(static_cast<const PointerType*>(type)->getBaseType().get(), nominal);
+            break;
+        case TypeKind::Array:
+            collectNominalTypes(static_cast<const ArrayType*>(type)->getBaseType().get(), nominal);
+            break;
+        case TypeKind::Function: {
+            auto* fn = static_cast<const FunctionType*>(type);
+            for (const auto& param : fn->getParamTypes()) collectNominalTypes(param.get(), nominal);
+            collectNominalTypes(fn->getReturnType().get(), nominal);
+            break;
+        }
+        case TypeKind::Struct: {
+            auto* st = static_cast<const StructType*>(type);
+            if (!nominal.emplace(st->getName(), type).second) return;
+            for (const auto& field : st->getFields()) collectNominalTypes(field.type.get(), nominal);
+            break;
+        }
+        case TypeKind::Enum: {
+            auto* en = static_cast<const EnumType*>(type);
+            if (!nominal.emplace(en->getName(), type).second) return;
+            for (const auto& variant : en->getVariants()) {
+                for (const auto& tuple : variant.tupleTypes) collectNominalTypes(tuple.get(), nominal);
+                for (const auto& field : variant.structFields) collectNominalTypes(field.type.get(), nominal);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Serializes one function into a byte string; the fingerprint is its hash
+class FunctionHasher {
+public:
+    FunctionHasher(const std::unordered_map<std::string, const MIRFunction*>& functions,
+                   const std::unordered_map<std::string, const Type*>& signatureTypes)
+        : functions(functions), signatureTypes(signatureTypes) {}
+
+    void add(const std::string& s) {
+        num(s.size());
+        bytes += s;
+    }
+    void num(uint64_t v) { bytes.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    void type(const std::shared_ptr<Type>& t) {
+        if (!t) {
+            add("<none>");
+            return;
+        }
+        add(t->toString());
+        collectNominalTypes(t.get(), localTypes);
+    }
+
+    void signature(const MIRFunction& func) {
+        add(func.getName());
+        num(func.getVarArg());
+        num(func.getParameters().size());
+        for (const auto& param : func.getParameters()) type(param.second);
+        type(func.getReturnType());
+    }
+
+    void instruction(const MIRFunction& func, const MIRInstruction& inst) {
+        num(static_cast<uint64_t>(inst.getKind()));
+        add(inst.toString());
+        // toString leaves out some operands; everything codegen reads is added here
+        switch (inst.getKind()) {
+            case MIRInstructionKind::Alloca:
+                type(static_cast<const AllocaInst&>(inst).getType());
+                break;
+            case MIRInstructionKind::Phi:
+                type(static_cast<const PhiInst&>(inst).getType());
+                break;
+            case MIRInstructionKind::ConstDouble: {
+                double value = static_cast<const ConstDoubleInst&>(inst).getValue();
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                num(bits);
+                break;
+            }
+            case MIRInstructionKind::StructElementPtr:
+                reached.push_back(static_cast<const StructElementPtrInst&>(inst).getStructName());
+                break;
+            case MIRInstructionKind::ArrayElementPtr:
+                type(static_cast<const ArrayElementPtrInst&>(inst).getElementType());
+                break;
+            case MIRInstructionKind::Sizeof:
+                type(static_cast<const SizeofInst&>(inst).getType());
+                break;
+            case MIRInstructionKind::Alignof:
+                type(static_cast<const AlignofInst&>(inst).getType());
+                break;
+            case MIRInstructionKind::Offsetof:
+                type(static_cast<const OffsetofInst&>(inst).getType());
+                break;
+            case MIRInstructionKind::VariantExtract:
+                type(static_cast<const VariantExtractInst&>(inst).getFieldType());
+                break;
+            case MIRInstructionKind::Call: {
+                auto& call = static_cast<const CallInst&>(inst);
+                num(call.getArgs().size());
+                for (ValueID arg : call.getArgs()) num(arg);
+                // A callee's signature decides the call sequence; its body does not
+                auto callee = functions.find(call.getCallee());
+                if (callee != functions.end() && callee->second != &func) signature(*callee->second);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // Appends the layout of every struct and enum reached so far, including those reached through fields
+    void layouts() {
+        appendSorted(localTypes);
+        std::unordered_map<std::string, bool> done;
+        for (size_t i = 0; i < reached.size(); ++i) {
+            std::string name = reached[i];
+            if (done[name]) continue;
+            done[name] = true;
+
+            const Type* node = resolve(name);
+            add(name);
+            if (!node) continue;
+            if (node->isStruct()) {
+                auto* st = static_cast<const StructType*>(node);
+                num(st->isClass());
+                num(st->getFields().size());
+                for (const auto& field : st->getFields()) {
+                    add(field.name);
+                    nested(field.type.get());
+                }
+            } else {
+                auto* en = static_cast<const EnumType*>(node);
+                num(en->getVariants().size());
+                for (const auto& variant : en->getVariants()) {
+                    add(variant.name);
+                    num(static_cast<uint64_t>(variant.kind));
+                    for (const auto& tuple : variant.tupleTypes) nested(tuple.get());
+                    for (const auto& field : variant.structFields) {
+                        add(field.name);
+                        nested(field.type.get());
+                    }
+                }
+            }
+        }
+    }
+
+    std::string bytes;
+
+private:
+    const Type* resolve(const std::string& name) const {
+        auto it = signatureTypes.find(name);
+        if (it != signatureTypes.end()) return it->second;
+        auto local = localTypes.find(name);
+        return local == localTypes.end() ? nullptr : local->second;
+    }
+
+    void nested(const Type* t) {
+        if (!t) {
+            add("<none>");
+            return;
+        }
+        add(t->toString());
+        std::unordered_map<std::string, const Type*> inner;
+        collectNominalTypes(t, inner);
+        for (const auto& [name, node] : inner) localTypes.emplace(name, node);
+        appendSorted(inner);
+    }
+
+    // Hash maps iterate in no particular order; names are queued sorted so the bytes are stable
+    void appendSorted(const std::unordered_map<std::string, const Type*>& types) {
+        size_t start = reached.size();
+        for (const auto& [name, node] : types) reached.push_back(name);
+        std::sort(reached.begin() + start, reached.end());
+    }
+
+    const std::unordered_map<std::string, const MIRFunction*>& functions;
+    const std::unordered_map<std::string, const Type*>& signatureTypes;
+    std::unordered_map<std::string, const Type*> localTypes;
+    std::vector<std::string> reached;
+};
+
+void anchor() {}
+
+} // namespace
+
+FunctionFingerprinter::FunctionFingerprinter(const MIRModule& mirModule, std::string settings)
+    : settings(std::move(settings)) {
+    for (const auto& func : mirModule.getFunctions()) {
+        functions.emplace(func->getName(), func.get());
+        for (const auto& param : func->getParameters()) {
+            collectNominalTypes(param.second.get(), signatureTypes);
+        }
+        collectNominalTypes(func->getReturnType().get(), signatureTypes);
+    }
+}
+
+uint64_t FunctionFingerprinter::fingerprint(const MIRFunction& func) const {
+    FunctionHasher hasher(functions, signatureTypes);
+    hasher.add(settings);
+    hasher.signature(func);
+
+    hasher.num(func.getNumValues());
+    for (ValueID id = 0; id < func.getNumValues(); ++id) {
+        hasher.add(func.getValueName(id));
+        hasher.type(func.getValueType(id));
+    }
+    for (const auto& block : func.getBlocks()) {
+        hasher.add(block->getName());
+        hasher.num(block->getInstructions().size());
+        for (const auto& inst : block->getInstructions()) {
+            hasher.instruction(func, *inst);
+        }
+    }
+    hasher.layouts();
+    return llvm::xxHash64(hasher.bytes);
+}
+
+ObjectCache::ObjectCache(std::string dir) : dir(std::move(dir)) {}
+
+std::string ObjectCache::pathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.o", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(dir) / name).string();
+}
+
+bool ObjectCache::lookup(uint64_t key, llvm::SmallVectorImpl<char>& object) const {
+    auto buffer = llvm::MemoryBuffer::getFile(pathFor(key), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) return false;
+    object.assign((*buffer)->getBufferStart(), (*buffer)->getBufferEnd());
+    return true;
+}
+
+bool ObjectCache::store(uint64_t key, llvm::ArrayRef<char> object) const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    // Written under a unique name and renamed, so a concurrent build never links half an object
+    std::string path = pathFor(key);
+    llvm::SmallString<128> tempPath;
+    if (llvm::sys::fs::createUniqueFile(path + "-%%%%%%%%.tmp", tempPath)) {
+        std::cerr << "ObjectCache: Could not create a file in " << dir << std::endl;
+        return false;
+    }
+    {
+        std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(object.data(), static_cast<std::streamsize>(object.size()));
+        if (!out) {
+            std::cerr << "ObjectCache: Could not write " << tempPath.c_str() << std::endl;
+            std::filesystem::remove(tempPath.c_str(), ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath.c_str(), path, ec);
+    if (ec) {
+        std::cerr << "ObjectCache: Could not write " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath.c_str(), ec);
+        return false;
+    }
+    return true;
+}
+
+std::string ObjectCache::compilerStamp() {
+    std::string exe = llvm::sys::fs::getMainExecutable(nullptr, reinterpret_cast<void*>(&anchor));
+    llvm::sys::fs::file_status status;
+    if (exe.empty() || llvm::sys::fs::status(exe, status)) return exe;
+    auto modified = status.getLastModificationTime().time_since_epoch().count();
+    return exe + ":" + std::to_string(status.getSize()) + ":" + std::to_string(modified);
+}
+
+} // namespace chtholly
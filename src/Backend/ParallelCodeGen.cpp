@@ -0,0 +1,156 @@
+#include "Backend/ParallelCodeGen.h"
+#include "Backend/ObjectCache.h"
+#include "PhaseTimer.h"
+#include <llvm/TargetParser/Host.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace chtholly {
+
+ParallelCodeGen::ParallelCodeGen(MIRModule& mirModule, unsigned jobs)
+    : mirModule(mirModule), jobs(std::max(jobs, 1u)) {}
+
+std::vector<std::set<const MIRFunction*>> ParallelCodeGen::partition() const {
+    std::vector<std::pair<size_t, const MIRFunction*>> bodies;
+    for (const auto& func : mirModule.getFunctions()) {
+        if (func->getBlocks().empty()) continue;
+        size_t cost = 0;
+        for (const auto& block : func->getBlocks()) {
+            cost += block->getInstructions().size() + 1;
+        }
+        bodies.push_back({cost, func.get()});
+    }
+
+    size_t count = std::max<size_t>(1, std::min<size_t>(jobs, bodies.size()));
+    std::vector<std::set<const MIRFunction*>> partitions(count);
+    std::vector<size_t> load(count, 0);
+
+    // Largest first into the lightest partition keeps the slowest worker close to the average
+    std::stable_sort(bodies.begin(), bodies.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+    for (const auto& [cost, func] : bodies) {
+        size_t lightest = std::min_element(load.begin(), load.end()) - load.begin();
+        partitions[lightest].insert(func);
+        load[lightest] += cost;
+    }
+    return partitions;
+}
+
+bool ParallelCodeGen::emitObjects(std::vector<llvm::SmallVector<char, 0>>& objects) {
+    if (objectCache) return emitIncremental(objects);
+
+    auto partitions = partition();
+    objects.clear();
+    objects.resize(partitions.size());
+    std::vector<char> emitted(partitions.size(), 0);
+    std::vector<std::exception_ptr> errors(partitions.size());
+
+    auto work = [&](size_t i) {
+        PhaseTimer timer("Codegen partition", "partition " + std::to_string(i));
+        try {
+            CodeGenerator codegen(mirModule);
+            codegen.setOptLevel(optLevel);
+            codegen.setTargetCPU(targetCPU);
+            codegen.setTargetFeatures(targetFeatures);
+            codegen.setPartition(std::move(partitions[i]));
+            codegen.generate();
+            emitted[i] = codegen.emitObjectToBuffer(objects[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    // The calling thread takes the first partition itself
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < partitions.size(); ++i) {
+        workers.emplace_back([&work, i] {
+            PhaseTimer::beginThread();
+            work(i);
+            PhaseTimer::endThread();
+        });
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return std::all_of(emitted.begin(), emitted.end(), [](char ok) { return ok != 0; });
+}
+
+bool ParallelCodeGen::emitIncremental(std::vector<llvm::SmallVector<char, 0>>& objects) {
+    // Everything besides the MIR that changes the machine code goes into every key
+    CodeGenerator settingsProbe(mirModule);
+    settingsProbe.setTargetCPU(targetCPU);
+    settingsProbe.setTargetFeatures(targetFeatures);
+    std::string settings = "O" + std::to_string(static_cast<int>(optLevel)) + ";" + llvm::sys::getDefaultTargetTriple() + ";" +
+                           settingsProbe.resolveTargetCPU() + ";" + settingsProbe.resolveTargetFeatures() + ";" +
+                           ObjectCache::compilerStamp();
+
+    std::vector<const MIRFunction*> bodies;
+    std::vector<uint64_t> keys;
+    std::vector<size_t> dirty;
+    objects.clear();
+    {
+        PhaseTimer timer("Object cache lookup");
+        FunctionFingerprinter fingerprinter(mirModule, settings);
+        for (const auto& func : mirModule.getFunctions()) {
+            if (func->getBlocks().empty()) continue;
+            bodies.push_back(func.get());
+            keys.push_back(fingerprinter.fingerprint(*func));
+        }
+        objects.resize(bodies.size());
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            if (!objectCache->lookup(keys[i], objects[i])) dirty.push_back(i);
+        }
+    }
+    numFunctions = bodies.size();
+    numReused = bodies.size() - dirty.size();
+
+    std::vector<char> emitted(dirty.size(), 0);
+    std::vector<std::exception_ptr> errors(dirty.size());
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t d = next++; d < dirty.size(); d = next++) {
+            size_t i = dirty[d];
+            PhaseTimer timer("Codegen function", bodies[i]->getName());
+            try {
+                CodeGenerator codegen(mirModule);
+                codegen.setOptLevel(optLevel);
+                codegen.setTargetCPU(targetCPU);
+                codegen.setTargetFeatures(targetFeatures);
+                codegen.setPartition({bodies[i]});
+                codegen.generate();
+                emitted[d] = codegen.emitObjectToBuffer(objects[i]);
+                if (emitted[d]) objectCache->store(keys[i], objects[i]);
+            } catch (...) {
+                errors[d] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min<size_t>(jobs, dirty.size()); ++t) {
+        workers.emplace_back([&work] {
+            PhaseTimer::beginThread();
+            work();
+            PhaseTimer::endThread();
+        });
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return std::all_of(emitted.begin(), emitted.end(), [](char ok) { return ok != 0; });
+}
+
+} // namespace chtholly
@@ -0,0 +1,330 @@
+#include "CharScan.h"
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define CHTHOLLY_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC 不需要为单个函数开启 AVX2
+#define CHTHOLLY_TARGET_AVX2
+#else
+#define CHTHOLLY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace chtholly::charscan
+{
+
+	namespace {
+		using RunFn = size_t (*)(const char*, const char*);
+
+		struct Kernels {
+			ScanImpl impl;
+			RunFn identifier;
+			RunFn blank;
+			RunFn blockComment;
+			RunFn stringBody;
+		};
+
+		// ---- 标量实现，也用于 SIMD 处理不足一个向量的尾部 ----
+
+		inline bool isIdentifierChar(char c)
+		{
+			unsigned char lower = static_cast<unsigned char>(c) | 0x20;
+			return (lower >= 'a' && lower <= 'z') || (c >= '0' && c <= '9') || c == '_';
+		}
+
+		size_t identifierScalar(const char* p, const char* end)
+		{
+			const char* start = p;
+			while (p < end && isIdentifierChar(*p))
+				++p;
+			return static_cast<size_t>(p - start);
+		}
+
+		size_t blankScalar(const char* p, const char* end)
+		{
+			const char* start = p;
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				++p;
+			return static_cast<size_t>(p - start);
+		}
+
+		size_t blockCommentScalar(const char* p, const char* end)
+		{
+			const char* start = p;
+			while (p < end && *p != '*' && *p != '/' && *p != '\n')
+				++p;
+			return static_cast<size_t>(p - start);
+		}
+
+		size_t stringBodyScalar(const char* p, const char* end)
+		{
+			const char* start = p;
+			while (p < end && *p != '"' && *p != '\\' && *p != '\n')
+				++p;
+			return static_cast<size_t>(p - start);
+		}
+
+		constexpr Kernels scalarKernels = {
+			ScanImpl::Scalar, identifierScalar, blankScalar, blockCommentScalar, stringBodyScalar
+		};
+
+#ifdef CHTHOLLY_SCAN_X86
+		// ---- SSE2：每次分类 16 字节，停止位掩码的最低位即为第一个停止字符 ----
+
+		inline __m128i inRange128(__m128i v, char lo, char hi)
+		{
+			return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+				_mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+		}
+
+		inline __m128i anyOf128(__m128i v, char a, char b, char c)
+		{
+			return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(a)), _mm_cmpeq_epi8(v, _mm_set1_epi8(b))),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+		}
+
+		struct IdentifierStop128 {
+			unsigned operator()(__m128i v) const
+			{
+				__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+				__m128i ok = _mm_or_si128(_mm_or_si128(inRange128(lower, 'a', 'z'), inRange128(v, '0', '9')),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+				return ~static_cast<unsigned>(_mm_movemask_epi8(ok)) & 0xFFFFu;
+			}
+		};
+
+		struct BlankStop128 {
+			unsigned operator()(__m128i v) const
+			{
+				return ~static_cast<unsigned>(_mm_movemask_epi8(anyOf128(v, ' ', '\t', '\r'))) & 0xFFFFu;
+			}
+		};
+
+		struct BlockCommentStop128 {
+			unsigned operator()(__m128i v) const
+			{
+				return static_cast<unsigned>(_mm_movemask_epi8(anyOf128(v, '*', '/', '\n')));
+			}
+		};
+
+		struct StringBodyStop128 {
+			unsigned operator()(__m128i v) const
+			{
+				return static_cast<unsigned>(_mm_movemask_epi8(anyOf128(v, '"', '\\', '\n')));
+			}
+		};
+
+		template <typename Stop, RunFn Tail>
+		size_t sse2Run(const char* p, const char* end)
+		{
+			const char* start = p;
+			while (end - p >= 16)
+			{
+				unsigned mask = Stop{}(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+				if (mask)
+					return static_cast<size_t>(p - start) + std::countr_zero(mask);
+				p += 16;
+			}
+			return static_cast<size_t>(p - start) + Tail(p, end);
+		}
+
+		constexpr Kernels sse2Kernels = {
+			ScanImpl::SSE2,
+			sse2Run<IdentifierStop128, identifierScalar>,
+			sse2Run<BlankStop128, blankScalar>,
+			sse2Run<BlockCommentStop128, blockCommentScalar>,
+			sse2Run<StringBodyStop128, stringBodyScalar>
+		};
+
+		// ---- AVX2：同样的分类，每次 32 字节；只在运行时检测到 AVX2 后才会调用 ----
+
+		CHTHOLLY_TARGET_AVX2 inline __m256i inRange256(__m256i v, char lo, char hi)
+		{
+			return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+				_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+		}
+
+		CHTHOLLY_TARGET_AVX2 inline __m256i anyOf256(__m256i v, char a, char b, char c)
+		{
+			return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(a)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(b))),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+		}
+
+		struct IdentifierStop256 {
+			CHTHOLLY_TARGET_AVX2 unsigned operator()(__m256i v) const
+			{
+				__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+				__m256i ok = _mm256_or_si256(_mm256_or_si256(inRange256(lower, 'a', 'z'), inRange256(v, '0', '9')),
+					_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+				return ~static_cast<unsigned>(_mm256_movemask_epi8(ok));
+			}
+		};
+
+		struct BlankStop256 {
+			CHTHOLLY_TARGET_AVX2 unsigned operator()(__m256i v) const
+			{
+				return ~static_cast<unsigned>(_mm256_movemask_epi8(anyOf256(v, ' ', '\t', '\r')));
+			}
+		};
+
+		struct BlockCommentStop256 {
+			CHTHOLLY_TARGET_AVX2 unsigned operator()(__m256i v) const
+			{
+				return static_cast<unsigned>(_mm256_movemask_epi8(anyOf256(v, '*', '/', '\n')));
+			}
+		};
+
+		struct StringBodyStop256 {
+			CHTHOLLY_TARGET_AVX2 unsigned operator()(__m256i v) const
+			{
+				return static_cast<unsigned>(_mm256_movemask_epi8(anyOf256(v, '"', '\\', '\n')));
+			}
+		};
+
+		// 尾部交给 SSE2 版本，它会再把不足 16 字节的部分交给标量版本
+		template <typename Stop, RunFn Tail>
+		CHTHOLLY_TARGET_AVX2 size_t avx2Run(const char* p, const char* end)
+		{
+			const char* start = p;
+			while (end - p >= 32)
+			{
+				unsigned mask = Stop{}(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+				if (mask)
+					return static_cast<size_t>(p - start) + std::countr_zero(mask);
+				p += 32;
+			}
+			return static_cast<size_t>(p - start) + Tail(p, end);
+		}
+
+		constexpr Kernels avx2Kernels = {
+			ScanImpl::AVX2,
+			avx2Run<IdentifierStop256, sse2Run<IdentifierStop128, identifierScalar>>,
+			avx2Run<BlankStop256, sse2Run<BlankStop128, blankScalar>>,
+			avx2Run<BlockCommentStop256, sse2Run<BlockCommentStop128, blockCommentScalar>>,
+			avx2Run<StringBodyStop256, sse2Run<StringBodyStop128, stringBodyScalar>>
+		};
+
+		bool cpuHasAvx2()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+			__cpuid(info, 1);
+			// 需要 OSXSAVE 与 AVX，并且操作系统保存了 YMM 寄存器
+			if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+				return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+#endif
+
+		const Kernels* detectKernels()
+		{
+#ifdef CHTHOLLY_SCAN_X86
+			return cpuHasAvx2() ? &avx2Kernels : &sse2Kernels;
+#else
+			return &scalarKernels;
+#endif
+		}
+
+		const Kernels*& activeKernels()
+		{
+			static const Kernels* kernels = detectKernels();
+			return kernels;
+		}
+	}
+
+	size_t identifierRun(const char* p, const char* end)
+	{
+		return activeKernels()->identifier(p, end);
+	}
+
+	size_t blankRun(const char* p, const char* end)
+	{
+		return activeKernels()->blank(p, end);
+	}
+
+	size_t lineCommentRun(const char* p, const char* end)
+	{
+		// libc 的 memchr 本身已经向量化
+		const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+		return nl ? static_cast<size_t>(static_cast<const char*>(nl) - p) : static_cast<size_t>(end - p);
+	}
+
+	size_t blockCommentRun(const char* p, const char* end)
+	{
+		return activeKernels()->blockComment(p, end);
+	}
+
+	size_t stringBodyRun(const char* p, const char* end)
+	{
+		return activeKernels()->stringBody(p, end);
+	}
+
+	ScanImpl activeImpl()
+	{
+		return activeKernels()->impl;
+	}
+
+	bool isSupported(ScanImpl impl)
+	{
+		switch (impl)
+		{
+		case ScanImpl::Scalar:
+			return true;
+#ifdef CHTHOLLY_SCAN_X86
+		case ScanImpl::SSE2:
+			return true;
+		case ScanImpl::AVX2:
+			return cpuHasAvx2();
+#endif
+		default:
+			return false;
+		}
+	}
+
+	bool setImpl(ScanImpl impl)
+	{
+		if (!isSupported(impl))
+			return false;
+		switch (impl)
+		{
+#ifdef CHTHOLLY_SCAN_X86
+		case ScanImpl::SSE2:
+			activeKernels() = &sse2Kernels;
+			break;
+		case ScanImpl::AVX2:
+			activeKernels() = &avx2Kernels;
+			break;
+#endif
+		default:
+			activeKernels() = &scalarKernels;
+			break;
+		}
+		return true;
+	}
+
+	const char* implName(ScanImpl impl)
+	{
+		switch (impl)
+		{
+		case ScanImpl::SSE2:
+			return "sse2";
+		case ScanImpl::AVX2:
+			return "avx2";
+		default:
+			return "scalar";
+		}
+	}
+
+} // namespace chtholly::charscan
@@ -1,6 +1,5 @@
 #include "Lexer.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "CharScan.h"
 #include <iostream>
 #include <cctype>
 
@@ -53,6 +52,74 @@ namespace chtholly
 
 		// 此时 LOOKUP 的编译期初始化就能顺利通过了
 		static constexpr LexerLookupTable LOOKUP;
+
+		// 关键字完美哈希：取长度、首字符、中间字符、末字符拼成 32 位，再用种子做乘法散列
+		// 种子在编译期搜索，保证 KEYWORDS 中每个关键字落在不同的槽位
+		constexpr size_t KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+		constexpr unsigned KEYWORD_TABLE_BITS = 8;
+		constexpr uint8_t NO_KEYWORD = 0xFF;
+
+		constexpr size_t maxKeywordLength()
+		{
+			size_t length = 0;
+			for (const auto& keyword : KEYWORDS)
+				length = keyword.spelling.size() > length ? keyword.spelling.size() : length;
+			return length;
+		}
+		constexpr size_t MAX_KEYWORD_LENGTH = maxKeywordLength();
+
+		constexpr uint32_t keywordHash(std::string_view text, uint32_t seed)
+		{
+			uint32_t key = static_cast<uint8_t>(text[0])
+				| static_cast<uint32_t>(static_cast<uint8_t>(text[text.size() / 2])) << 8
+				| static_cast<uint32_t>(static_cast<uint8_t>(text[text.size() - 1])) << 16
+				| static_cast<uint32_t>(text.size()) << 24;
+			uint32_t h = key * seed;
+			h ^= h >> 15;
+			h *= 0x2C1B3C6Du;
+			return h >> (32 - KEYWORD_TABLE_BITS);
+		}
+
+		struct KeywordTable {
+			uint32_t seed = 0;
+			uint8_t slots[1u << KEYWORD_TABLE_BITS] = {}; // KEYWORDS 下标，NO_KEYWORD 表示空
+
+			constexpr KeywordTable()
+			{
+				static_assert(KEYWORD_COUNT < NO_KEYWORD, "keyword index must fit in a slot");
+				for (uint32_t candidate = 1; candidate < 100000; candidate += 2)
+				{
+					for (auto& slot : slots)
+						slot = NO_KEYWORD;
+					bool perfect = true;
+					for (size_t i = 0; i < KEYWORD_COUNT && perfect; ++i)
+					{
+						uint8_t& slot = slots[keywordHash(KEYWORDS[i].spelling, candidate)];
+						perfect = slot == NO_KEYWORD;
+						slot = static_cast<uint8_t>(i);
+					}
+					if (perfect)
+					{
+						seed = candidate;
+						return;
+					}
+				}
+			}
+		};
+
+		static constexpr KeywordTable KEYWORD_TABLE;
+		static_assert(KEYWORD_TABLE.seed != 0, "no collision-free seed for the keyword table");
+
+		// 非关键字返回 nullptr；只需一次散列、一次查表和一次定长比较
+		const KeywordSpelling* findKeyword(std::string_view text)
+		{
+			if (text.empty() || text.size() > MAX_KEYWORD_LENGTH)
+				return nullptr;
+			uint8_t index = KEYWORD_TABLE.slots[keywordHash(text, KEYWORD_TABLE.seed)];
+			if (index == NO_KEYWORD || KEYWORDS[index].spelling != text)
+				return nullptr;
+			return &KEYWORDS[index];
+		}
 	}
 
 	Lexer::Lexer(std::string_view source) : m_source(source) {}
@@ -86,6 +153,23 @@ namespace chtholly
 		}
 		return c;
 	}
+	void Lexer::advanceRun(size_t count)
+	{
+		// 调用方保证这段字符中没有换行，行号不变
+		m_pos += count;
+		m_column += static_cast<int>(count);
+	}
+
+	const char* Lexer::cursor() const
+	{
+		return m_source.data() + m_pos;
+	}
+
+	const char* Lexer::sourceEnd() const
+	{
+		return m_source.data() + m_source.size();
+	}
+
 	bool Lexer::match(char expected)
 	{
 		if (isAtEnd() || peek() != expected)
@@ -106,14 +190,16 @@ namespace chtholly
 			case ' ':
 			case '\r':
 			case '\t':
+				// 整段跳过空格、制表符与回车（缩进通常很长）
+				advanceRun(charscan::blankRun(cursor(), sourceEnd()));
+				break;
 			case '\n':
 				advance();
 				break;
 			case '/':
 				if (peek(1) == '/')
 				{
-					while (peek() != '\n' && !isAtEnd())
-						advance();
+					advanceRun(charscan::lineCommentRun(cursor(), sourceEnd()));
 				}
 				else if (peek(1) == '*')
 				{
@@ -123,6 +209,11 @@ namespace chtholly
 
 					while (nesting > 0 && !isAtEnd())
 					{
+						// 批量跳过不可能开始或结束注释、也不是换行的字符
+						advanceRun(charscan::blockCommentRun(cursor(), sourceEnd()));
+						if (isAtEnd())
+							break;
+
 						if (peek() == '/' && peek(1) == '*')
 						{
 							advance();
@@ -198,39 +289,19 @@ namespace chtholly
 	{
 		// 此时 start_pos 已经在 nextToken() 中通过 m_pos - 1 设置好了
 
-		// 1. 贪婪扫描标识符字符 (字母、数字、下划线)
-		// 利用我们之前讨论的查表法辅助函数
-		while (isAlphaNumeric(peek()))
-		{
-			advance();
-		}
+		// 1. 贪婪扫描标识符字符 (字母、数字、下划线)，按向量宽度批量分类
+		advanceRun(charscan::identifierRun(cursor(), sourceEnd()));
 
 		// 2. 获取当前的文本切片 (零拷贝)
 		std::string_view text = m_source.substr(start_pos, m_pos - start_pos);
 
-		// 3. 静态关键字映射表 (使用 string_view 提高查找效率)
-		static const std::unordered_map<std::string_view, TokenType> keywords = {
-			{"fn", TokenType::Fn}, {"let", TokenType::Let}, {"mut", TokenType::Mut}, {"class", TokenType::Class}, {"struct", TokenType::Struct}, {"enum", TokenType::Enum}, {"if", TokenType::If}, {"else", TokenType::Else}, {"switch", TokenType::Switch}, {"case", TokenType::Case}, {"while", TokenType::While}, {"for", TokenType::For}, {"do", TokenType::Do}, {"return", TokenType::Return}, {"import", TokenType::Import}, {"package", TokenType::Package}, {"use", TokenType::Use}, {"pub", TokenType::Pub}, {"as", TokenType::As}, {"break", TokenType::Break}, {"continue", TokenType::Continue}, {"fallthrough", TokenType::Fallthrough}, {"default", TokenType::Default}, {"void", TokenType::Void}, {"char", TokenType::Char}, {"bool", TokenType::Bool}, {"self", TokenType::Self}, {"Self", TokenType::CapitalSelf}, {"extern", TokenType::Extern}, {"true", TokenType::True}, {"false", TokenType::False}, {"nullptr", TokenType::Nullptr}, {"unsafe", TokenType::Unsafe}, {"malloc", TokenType::Malloc}, {"alloca", TokenType::Alloca}, {"free", TokenType::Free}, {"sizeof", TokenType::Sizeof}, {"alignof", TokenType::Alignof}, {"offsetof", TokenType::Offsetof}, {"align", TokenType::Align}, {"packed", TokenType::Packed}, {"_", TokenType::Underscore},
-			// 基础类型关键字
-			{ "i8", TokenType::I8 },
-			{"i16", TokenType::I16},
-			{"i32", TokenType::I32},
-			{"i64", TokenType::I64},
-			{"u8", TokenType::U8},
-			{"u16", TokenType::U16},
-			{"u32", TokenType::U32},
-			{"u64", TokenType::U64},
-			{"f32", TokenType::F32},
-			{"f64", TokenType::F64} };
-
-		// 4. 匹配关键字
-		auto it = keywords.find(text);
-		if (it != keywords.end())
+		// 3. 编译期生成的完美哈希表中查找关键字
+		if (const KeywordSpelling* keyword = findKeyword(text))
 		{
-			return makeToken(it->second, line, col);
+			return makeToken(keyword->type, line, col);
 		}
 
-		// 5. 否则返回普通标识符
+		// 4. 否则返回普通标识符
 		return makeToken(TokenType::Identifier, line, col);
 	}
 
@@ -313,11 +384,11 @@ namespace chtholly
 
 			std::string_view suffix = m_source.substr(nameStart, m_pos - nameStart);
 
-			static const std::unordered_set<std::string_view> validSuffixes = {
-				"i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64"
-			};
+			// 合法后缀正好是基础数值类型关键字 I8..F64
+			const KeywordSpelling* keyword = findKeyword(suffix);
+			bool validSuffix = keyword && keyword->type >= TokenType::I8 && keyword->type <= TokenType::F64;
 
-			if (validSuffixes.find(suffix) == validSuffixes.end()) {
+			if (!validSuffix) {
 				// 如果后缀无效（例如 42_abc），回退到下划线或字母开始前
 				m_pos = suffixStart;
 				m_column = suffixCol;
@@ -332,8 +403,13 @@ namespace chtholly
 	{
 		// 此时 m_pos - 1 是起始的左引号 "
 
-		while (peek() != '"' && !isAtEnd())
+		while (!isAtEnd())
 		{
+			// 批量跳过普通字符，只在引号、转义和换行处停下
+			advanceRun(charscan::stringBodyRun(cursor(), sourceEnd()));
+			if (isAtEnd() || peek() == '"')
+				break;
+
 			// 【核心改进】如果遇到换行符，说明字符串未闭合就换行了，这是非法格式
 			if (peek() == '\n')
 			{
@@ -396,10 +472,7 @@ namespace chtholly
 		// 逻辑：如果 '\'' 后面跟着的是标识符允许的字符
 		if (isAlpha(peek()))
 		{
-			while (isAlphaNumeric(peek()))
-			{
-				advance();
-			}
+			advanceRun(charscan::identifierRun(cursor(), sourceEnd()));
 			return makeToken(TokenType::Lifetime, line, col);
 		}
 
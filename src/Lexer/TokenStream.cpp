@@ -0,0 +1,102 @@
+#include "TokenStream.h"
+#include "Lexer.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace chtholly
+{
+
+	TokenStream::TokenStream(std::string_view source) : m_source(source)
+	{
+		// 偏移量用 32 位存储
+		if (source.size() > std::numeric_limits<uint32_t>::max())
+		{
+			throw std::runtime_error("Source file is too large to tokenize");
+		}
+
+		// 粗略估计每个 Token 约占 4 个字符，避免反复扩容
+		size_t estimate = source.size() / 4 + 1;
+		m_kinds.reserve(estimate);
+		m_offsets.reserve(estimate);
+		m_lengths.reserve(estimate);
+
+		Lexer lexer(source);
+		while (true)
+		{
+			Token token = lexer.nextToken();
+			// EndOfFile 的切片不指向源码，其位置就是文件末尾
+			size_t start = token.type == TokenType::EndOfFile
+				? source.size()
+				: static_cast<size_t>(token.value.data() - source.data());
+			m_kinds.push_back(token.type);
+			m_offsets.push_back(static_cast<uint32_t>(start));
+			m_lengths.push_back(static_cast<uint32_t>(token.value.size()));
+			if (token.type == TokenType::EndOfFile)
+				break;
+		}
+	}
+
+	std::string_view TokenStream::text(size_t index) const
+	{
+		index = clamp(index);
+		if (m_lengths[index] == 0)
+			return "";
+		return m_source.substr(m_offsets[index], m_lengths[index]);
+	}
+
+	size_t TokenStream::lineIndexOf(uint32_t offset) const
+	{
+		if (m_lineStarts.empty())
+		{
+			m_lineStarts.push_back(0);
+			const char* begin = m_source.data();
+			const char* end = begin + m_source.size();
+			for (const char* p = begin; p < end;)
+			{
+				const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+				if (!nl)
+					break;
+				p = static_cast<const char*>(nl) + 1;
+				m_lineStarts.push_back(static_cast<uint32_t>(p - begin));
+			}
+		}
+
+		// 解析器基本是顺序前进的，先检查上一次的行和它的下一行
+		for (size_t i = m_lineHint; i < m_lineHint + 2 && i < m_lineStarts.size(); ++i)
+		{
+			bool afterStart = m_lineStarts[i] <= offset;
+			bool beforeNext = i + 1 == m_lineStarts.size() || offset < m_lineStarts[i + 1];
+			if (afterStart && beforeNext)
+			{
+				m_lineHint = i;
+				return i;
+			}
+		}
+
+		auto it = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), offset);
+		m_lineHint = static_cast<size_t>(it - m_lineStarts.begin()) - 1;
+		return m_lineHint;
+	}
+
+	int TokenStream::line(size_t index) const
+	{
+		return static_cast<int>(lineIndexOf(offset(index))) + 1;
+	}
+
+	int TokenStream::column(size_t index) const
+	{
+		uint32_t start = offset(index);
+		return static_cast<int>(start - m_lineStarts[lineIndexOf(start)]) + 1;
+	}
+
+	Token TokenStream::token(size_t index) const
+	{
+		uint32_t start = offset(index);
+		size_t lineIndex = lineIndexOf(start);
+		return { kind(index), text(index), static_cast<int>(lineIndex) + 1,
+			static_cast<int>(start - m_lineStarts[lineIndex]) + 1 };
+	}
+
+} // namespace chtholly
@@ -0,0 +1,89 @@
+#include "MIR/CallGraph.h"
+#include <algorithm>
+
+namespace chtholly {
+
+MIRFunction* resolveCallee(const MIRModule& module, const CallInst& call) {
+    if (call.getCalleeID() != NoFunction) return module.getFunction(call.getCalleeID());
+    return module.getFunction(call.getCallee());
+}
+
+CallGraph::CallGraph(const MIRModule& module) {
+    size_t numNodes = module.getNumFunctionIDs();
+    callees.resize(numNodes);
+    selfCalls.resize(numNodes, false);
+    for (FunctionID id = 0; id < numNodes; ++id) {
+        MIRFunction* func = module.getFunction(id);
+        if (!func) continue;
+        auto& out = callees[id];
+        for (const auto& block : func->getBlocks()) {
+            for (const auto& inst : block->getInstructions()) {
+                if (inst->getKind() != MIRInstructionKind::Call) continue;
+                MIRFunction* callee = resolveCallee(module, static_cast<const CallInst&>(*inst));
+                if (!callee || callee->getID() == NoFunction) continue;
+                if (callee->getID() == id) selfCalls[id] = true;
+                if (std::find(out.begin(), out.end(), callee->getID()) == out.end()) out.push_back(callee->getID());
+            }
+        }
+    }
+
+    // Tarjan with an explicit stack, so long call chains cannot overflow the native one.
+    // A component is finished only after everything it calls, which gives callees-first order.
+    constexpr size_t Unvisited = SIZE_MAX;
+    std::vector<size_t> index(numNodes, Unvisited), lowLink(numNodes, 0);
+    std::vector<bool> onStack(numNodes, false);
+    std::vector<FunctionID> sccStack;
+    std::vector<std::pair<FunctionID, size_t>> dfs;
+    size_t nextIndex = 0;
+    sccOf.assign(numNodes, 0);
+    for (FunctionID root = 0; root < numNodes; ++root) {
+        if (index[root] != Unvisited) continue;
+        dfs.push_back({root, 0});
+        while (!dfs.empty()) {
+            auto& [node, next] = dfs.back();
+            if (next == 0 && index[node] == Unvisited) {
+                index[node] = lowLink[node] = nextIndex++;
+                sccStack.push_back(node);
+                onStack[node] = true;
+            }
+            if (next < callees[node].size()) {
+                FunctionID callee = callees[node][next++];
+                if (index[callee] == Unvisited) {
+                    dfs.push_back({callee, 0});
+                } else if (onStack[callee]) {
+                    lowLink[node] = std::min(lowLink[node], index[callee]);
+                }
+                continue;
+            }
+            FunctionID done = node;
+            dfs.pop_back();
+            if (!dfs.empty()) {
+                FunctionID parent = dfs.back().first;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[done]);
+            }
+            if (lowLink[done] != index[done]) continue;
+            std::vector<FunctionID> scc;
+            FunctionID member;
+            do {
+                member = sccStack.back();
+                sccStack.pop_back();
+                onStack[member] = false;
+                sccOf[member] = sccs.size();
+                scc.push_back(member);
+            } while (member != done);
+            sccs.push_back(std::move(scc));
+        }
+    }
+}
+
+bool CallGraph::inSameSCC(FunctionID caller, FunctionID callee) const {
+    if (caller >= sccOf.size() || callee >= sccOf.size()) return false;
+    return sccOf[caller] == sccOf[callee];
+}
+
+bool CallGraph::isRecursive(FunctionID id) const {
+    if (id >= sccOf.size()) return false;
+    return selfCalls[id] || sccs[sccOf[id]].size() > 1;
+}
+
+} // namespace chtholly
@@ -0,0 +1,132 @@
+#include "MIR/Dominators.h"
+#include <algorithm>
+
+namespace chtholly {
+
+DominatorTree::DominatorTree(const MIRFunction& func) {
+    const auto& allBlocks = func.getBlocks();
+    if (allBlocks.empty()) return;
+
+    std::unordered_map<std::string, BasicBlock*> byName;
+    for (const auto& block : allBlocks) {
+        byName.emplace(block->getName(), block.get());
+    }
+    auto successorsOf = [&](const BasicBlock* block) {
+        std::vector<BasicBlock*> result;
+        for (const auto& name : block->getSuccessorNames()) {
+            auto it = byName.find(name);
+            if (it != byName.end()) result.push_back(it->second);
+        }
+        return result;
+    };
+
+    // Post-order by an explicit DFS, so deep chains of blocks cannot overflow the stack
+    std::vector<BasicBlock*> postOrder;
+    std::unordered_map<const BasicBlock*, bool> visited;
+    std::vector<std::pair<BasicBlock*, size_t>> stack;
+    std::vector<std::vector<BasicBlock*>> pending;
+    stack.push_back({allBlocks.front().get(), 0});
+    pending.push_back(successorsOf(allBlocks.front().get()));
+    visited[allBlocks.front().get()] = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        auto& succs = pending.back();
+        if (next < succs.size()) {
+            BasicBlock* succ = succs[next++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.push_back({succ, 0});
+                pending.push_back(successorsOf(succ));
+            }
+            continue;
+        }
+        postOrder.push_back(block);
+        stack.pop_back();
+        pending.pop_back();
+    }
+
+    blocks.assign(postOrder.rbegin(), postOrder.rend());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        indices.emplace(blocks[i], i);
+    }
+
+    successors.resize(blocks.size());
+    predecessors.resize(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        for (BasicBlock* succ : successorsOf(blocks[i])) {
+            size_t s = indices.at(succ);
+            successors[i].push_back(s);
+            predecessors[s].push_back(i);
+        }
+    }
+
+    // Reverse post-order numbers make "intersect" a walk towards smaller indices
+    idoms.assign(blocks.size(), Unreachable);
+    idoms[0] = 0;
+    auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (a > b) a = idoms[a];
+            while (b > a) b = idoms[b];
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < blocks.size(); ++i) {
+            size_t idom = Unreachable;
+            for (size_t pred : predecessors[i]) {
+                if (idoms[pred] == Unreachable) continue;
+                idom = idom == Unreachable ? pred : intersect(pred, idom);
+            }
+            if (idoms[i] != idom) {
+                idoms[i] = idom;
+                changed = true;
+            }
+        }
+    }
+
+    children.resize(blocks.size());
+    for (size_t i = 1; i < blocks.size(); ++i) {
+        children[idoms[i]].push_back(i);
+    }
+
+    // A join point is in the frontier of every block on the way up from each predecessor to its idom
+    frontiers.resize(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (predecessors[i].size() < 2) continue;
+        for (size_t pred : predecessors[i]) {
+            size_t runner = pred;
+            while (runner != idoms[i]) {
+                auto& frontier = frontiers[runner];
+                if (std::find(frontier.begin(), frontier.end(), i) == frontier.end()) frontier.push_back(i);
+                if (runner == 0) break;
+                runner = idoms[runner];
+            }
+        }
+    }
+}
+
+size_t DominatorTree::indexOf(const BasicBlock* block) const {
+    auto it = indices.find(block);
+    return it == indices.end() ? Unreachable : it->second;
+}
+
+bool DominatorTree::dominates(size_t a, size_t b) const {
+    // Immediate dominators have smaller numbers, so the walk up from b stops once it passes a
+    while (b > a) b = idoms[b];
+    return a == b;
+}
+
+std::vector<BasicBlock*> emissionOrder(const MIRFunction& func, const DominatorTree& domTree) {
+    std::vector<BasicBlock*> order;
+    for (size_t i = 0; i < domTree.getNumBlocks(); ++i) {
+        order.push_back(domTree.getBlock(i));
+    }
+    for (const auto& block : func.getBlocks()) {
+        if (domTree.indexOf(block.get()) == DominatorTree::Unreachable) order.push_back(block.get());
+    }
+    return order;
+}
+
+} // namespace chtholly
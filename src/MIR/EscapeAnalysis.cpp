@@ -0,0 +1,153 @@
+#include "MIR/EscapeAnalysis.h"
+#include <unordered_set>
+
+namespace chtholly {
+
+namespace {
+
+bool isCallTo(const MIRInstruction& inst, const char* name) {
+    if (inst.getKind() != MIRInstructionKind::Call) return false;
+    auto& call = static_cast<const CallInst&>(inst);
+    return call.getCallee() == name && call.getArgs().size() == 1;
+}
+
+struct Uses {
+    // Every instruction reading each value, once per operand
+    std::vector<std::vector<MIRInstruction*>> users;
+    std::vector<MIRInstruction*> defs;
+};
+
+Uses collectUses(MIRFunction& func) {
+    Uses uses;
+    uses.users.resize(func.getNumValues());
+    uses.defs.resize(func.getNumValues(), nullptr);
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getResult() != NoValue) uses.defs[inst->getResult()] = inst.get();
+            inst->forEachOperand([&](ValueID& value) { uses.users[value].push_back(inst.get()); });
+        }
+    }
+    return uses;
+}
+
+std::shared_ptr<Type> stackTypeFor(const MIRInstruction* size) {
+    if (!size) return nullptr;
+    if (size->getKind() == MIRInstructionKind::Sizeof) return static_cast<const SizeofInst*>(size)->getType();
+    if (size->getKind() == MIRInstructionKind::ConstInt) {
+        int64_t bytes = static_cast<const ConstIntInst*>(size)->getValue();
+        if (bytes > 0 && bytes <= INT32_MAX) return ArrayType::get(Type::getU8(), static_cast<int>(bytes));
+    }
+    return nullptr;
+}
+
+// Empty when the pointer in `root` stays inside the function; frees of it go to `frees`
+std::string findEscape(ValueID root, const Uses& uses, std::vector<CallInst*>& frees) {
+    // Values holding the allocation's address; interior ones point into it and cannot be freed
+    std::unordered_set<ValueID> aliases{root}, interior;
+    std::vector<ValueID> worklist{root};
+    std::unordered_set<ValueID> slots;
+    std::vector<const StoreInst*> slotStores;
+
+    auto addAlias = [&](ValueID value, bool isInterior) {
+        if (isInterior) interior.insert(value);
+        if (aliases.insert(value).second) worklist.push_back(value);
+    };
+    // A local variable the pointer is stored in; loads from it are the pointer again
+    auto addSlot = [&](ValueID slot) -> std::string {
+        const MIRInstruction* def = uses.defs[slot];
+        if (!def || def->getKind() != MIRInstructionKind::Alloca) return "stored through a pointer";
+        if (!static_cast<const AllocaInst*>(def)->getType()->isPointer()) return "stored in a non-pointer variable";
+        if (!slots.insert(slot).second) return "";
+        for (MIRInstruction* user : uses.users[slot]) {
+            if (user->getKind() == MIRInstructionKind::Load) {
+                addAlias(user->getResult(), false);
+                continue;
+            }
+            auto* store = user->getKind() == MIRInstructionKind::Store ? static_cast<const StoreInst*>(user) : nullptr;
+            if (!store || store->getSrc() == slot) return "held in a variable whose address is taken";
+            slotStores.push_back(store);
+        }
+        return "";
+    };
+
+    while (!worklist.empty()) {
+        ValueID value = worklist.back();
+        worklist.pop_back();
+        for (MIRInstruction* user : uses.users[value]) {
+            std::string escape;
+            switch (user->getKind()) {
+                case MIRInstructionKind::Load:
+                case MIRInstructionKind::VariantTag:
+                case MIRInstructionKind::VariantExtract:
+                    break;
+                case MIRInstructionKind::Store: {
+                    auto* store = static_cast<const StoreInst*>(user);
+                    if (store->getSrc() == value) escape = addSlot(store->getDest());
+                    break;
+                }
+                case MIRInstructionKind::VariantData: {
+                    auto& args = static_cast<const VariantDataInst*>(user)->getArgs();
+                    if (std::find(args.begin(), args.end(), value) != args.end()) escape = "stored in an enum payload";
+                    break;
+                }
+                case MIRInstructionKind::StructElementPtr:
+                    addAlias(user->getResult(), true);
+                    break;
+                case MIRInstructionKind::ArrayElementPtr:
+                    if (static_cast<const ArrayElementPtrInst*>(user)->getIndex() == value) escape = "used as an index";
+                    else addAlias(user->getResult(), true);
+                    break;
+                case MIRInstructionKind::UnaryOp:
+                    if (static_cast<const UnaryOpInst*>(user)->getOp() == TokenType::Plus) addAlias(user->getResult(), interior.count(value));
+                    else escape = "used in arithmetic";
+                    break;
+                case MIRInstructionKind::BinOp: {
+                    TokenType op = static_cast<const BinOpInst*>(user)->getOp();
+                    if (op != TokenType::EqualEqual && op != TokenType::NotEqual) escape = "used in arithmetic";
+                    break;
+                }
+                case MIRInstructionKind::Call: {
+                    auto* call = static_cast<CallInst*>(user);
+                    if (isCallTo(*call, "free") && !interior.count(value)) frees.push_back(call);
+                    else escape = "passed to " + call->getCallee();
+                    break;
+                }
+                case MIRInstructionKind::Ret:
+                    escape = "returned";
+                    break;
+                case MIRInstructionKind::Phi:
+                    escape = "merged by a phi";
+                    break;
+                default:
+                    escape = "used by " + user->toString();
+                    break;
+            }
+            if (!escape.empty()) return escape;
+        }
+    }
+
+    // A variable that may also hold some other pointer makes its loads ambiguous
+    for (const StoreInst* store : slotStores) {
+        if (!aliases.count(store->getSrc())) return "shares a variable with another pointer";
+    }
+    return "";
+}
+
+} // namespace
+
+std::vector<HeapAllocation> analyzeHeapAllocations(MIRFunction& func) {
+    std::vector<HeapAllocation> allocations;
+    Uses uses = collectUses(func);
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (!isCallTo(*inst, "malloc") || inst->getResult() == NoValue) continue;
+            auto* call = static_cast<CallInst*>(inst.get());
+            HeapAllocation allocation{call, stackTypeFor(uses.defs[call->getArgs()[0]]), {}, {}};
+            allocation.escape = findEscape(call->getDest(), uses, allocation.frees);
+            allocations.push_back(std::move(allocation));
+        }
+    }
+    return allocations;
+}
+
+} // namespace chtholly
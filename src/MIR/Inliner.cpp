@@ -0,0 +1,292 @@
+#include "MIR/Inliner.h"
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace chtholly {
+
+namespace {
+
+// Maps the callee's values and block names to the caller's, allocating on first use
+class CalleeMap {
+public:
+    CalleeMap(MIRFunction& caller, const MIRFunction& callee) : caller(caller), callee(callee), values(callee.getNumValues(), NoValue) {
+        for (const auto& block : caller.getBlocks()) {
+            usedBlockNames.insert(block->getName());
+        }
+    }
+
+    void bindValue(ValueID calleeValue, ValueID callerValue) { values[calleeValue] = callerValue; }
+    void bindBlock(const std::string& calleeBlock, const std::string& callerBlock) { blockNames[calleeBlock] = callerBlock; }
+
+    ValueID value(ValueID id) {
+        if (id == NoValue) return NoValue;
+        ValueID& mapped = values[id];
+        if (mapped == NoValue) {
+            // Copy the name: createValue may grow the caller's table while it is read
+            std::string name = callee.getValueName(id);
+            mapped = name.empty() ? caller.createTemp(callee.getValueType(id)) : caller.createValue(std::move(name), callee.getValueType(id));
+        }
+        return mapped;
+    }
+
+    const std::string& block(const std::string& name) {
+        auto it = blockNames.find(name);
+        if (it == blockNames.end()) it = blockNames.emplace(name, freshBlockName(callee.getName() + "." + name)).first;
+        return it->second;
+    }
+
+    // `base`, or `base.N` when the caller already has a block of that name
+    std::string freshBlockName(const std::string& base) {
+        std::string name = base;
+        for (unsigned suffix = 1; usedBlockNames.count(name); ++suffix) {
+            name = base + "." + std::to_string(suffix);
+        }
+        usedBlockNames.insert(name);
+        return name;
+    }
+
+private:
+    MIRFunction& caller;
+    const MIRFunction& callee;
+    std::vector<ValueID> values;
+    std::unordered_map<std::string, std::string> blockNames;
+    std::unordered_set<std::string> usedBlockNames;
+};
+
+std::unique_ptr<MIRInstruction> cloneInstruction(const MIRInstruction& inst, CalleeMap& map) {
+    switch (inst.getKind()) {
+        case MIRInstructionKind::Alloca: {
+            auto& alloca = static_cast<const AllocaInst&>(inst);
+            return std::make_unique<AllocaInst>(map.value(alloca.getDest()), alloca.getType());
+        }
+        case MIRInstructionKind::ConstInt: {
+            auto& constInt = static_cast<const ConstIntInst&>(inst);
+            return std::make_unique<ConstIntInst>(map.value(constInt.getDest()), constInt.getValue());
+        }
+        case MIRInstructionKind::ConstBool: {
+            auto& constBool = static_cast<const ConstBoolInst&>(inst);
+            return std::make_unique<ConstBoolInst>(map.value(constBool.getDest()), constBool.getValue());
+        }
+        case MIRInstructionKind::ConstString: {
+            auto& constString = static_cast<const ConstStringInst&>(inst);
+            return std::make_unique<ConstStringInst>(map.value(constString.getDest()), constString.getValue());
+        }
+        case MIRInstructionKind::ConstDouble: {
+            auto& constDouble = static_cast<const ConstDoubleInst&>(inst);
+            return std::make_unique<ConstDoubleInst>(map.value(constDouble.getDest()), constDouble.getValue());
+        }
+        case MIRInstructionKind::UnaryOp: {
+            auto& unary = static_cast<const UnaryOpInst&>(inst);
+            return std::make_unique<UnaryOpInst>(map.value(unary.getDest()), map.value(unary.getOperand()), unary.getOp());
+        }
+        case MIRInstructionKind::BinOp: {
+            auto& binOp = static_cast<const BinOpInst&>(inst);
+            return std::make_unique<BinOpInst>(map.value(binOp.getDest()), map.value(binOp.getLeft()), map.value(binOp.getRight()), binOp.getOp());
+        }
+        case MIRInstructionKind::Store: {
+            auto& store = static_cast<const StoreInst&>(inst);
+            return std::make_unique<StoreInst>(map.value(store.getSrc()), map.value(store.getDest()));
+        }
+        case MIRInstructionKind::Load: {
+            auto& load = static_cast<const LoadInst&>(inst);
+            return std::make_unique<LoadInst>(map.value(load.getDest()), map.value(load.getSrc()));
+        }
+        case MIRInstructionKind::StructElementPtr: {
+            auto& gep = static_cast<const StructElementPtrInst&>(inst);
+            return std::make_unique<StructElementPtrInst>(map.value(gep.getDest()), map.value(gep.getPtr()), gep.getStructName(), gep.getFieldName());
+        }
+        case MIRInstructionKind::ArrayElementPtr: {
+            auto& gep = static_cast<const ArrayElementPtrInst&>(inst);
+            return std::make_unique<ArrayElementPtrInst>(map.value(gep.getDest()), map.value(gep.getPtr()), map.value(gep.getIndex()), gep.getElementType());
+        }
+        case MIRInstructionKind::BoundsCheck: {
+            auto& check = static_cast<const BoundsCheckInst&>(inst);
+            return std::make_unique<BoundsCheckInst>(map.value(check.getIndex()), check.getLength(), map.value(check.getEnd()));
+        }
+        case MIRInstructionKind::Sizeof: {
+            auto& size = static_cast<const SizeofInst&>(inst);
+            return std::make_unique<SizeofInst>(map.value(size.getDest()), size.getType());
+        }
+        case MIRInstructionKind::Alignof: {
+            auto& align = static_cast<const AlignofInst&>(inst);
+            return std::make_unique<AlignofInst>(map.value(align.getDest()), align.getType());
+        }
+        case MIRInstructionKind::Offsetof: {
+            auto& offset = static_cast<const OffsetofInst&>(inst);
+            return std::make_unique<OffsetofInst>(map.value(offset.getDest()), offset.getType(), offset.getMemberName());
+        }
+        case MIRInstructionKind::VariantTag: {
+            auto& tag = static_cast<const VariantTagInst&>(inst);
+            return std::make_unique<VariantTagInst>(map.value(tag.getDest()), map.value(tag.getEnumPtr()));
+        }
+        case MIRInstructionKind::VariantData: {
+            auto& data = static_cast<const VariantDataInst&>(inst);
+            std::vector<ValueID> args;
+            for (ValueID arg : data.getArgs()) args.push_back(map.value(arg));
+            return std::make_unique<VariantDataInst>(map.value(data.getDest()), map.value(data.getEnumPtr()), data.getTag(), std::move(args));
+        }
+        case MIRInstructionKind::VariantExtract: {
+            auto& extract = static_cast<const VariantExtractInst&>(inst);
+            return std::make_unique<VariantExtractInst>(map.value(extract.getDest()), map.value(extract.getEnumPtr()), extract.getTag(), extract.getFieldIndex(), extract.getFieldType());
+        }
+        case MIRInstructionKind::Call: {
+            auto& call = static_cast<const CallInst&>(inst);
+            std::vector<ValueID> args;
+            for (ValueID arg : call.getArgs()) args.push_back(map.value(arg));
+            return std::make_unique<CallInst>(map.value(call.getDest()), call.getCallee(), std::move(args), call.getCalleeID());
+        }
+        case MIRInstructionKind::Br: {
+            auto& br = static_cast<const BrInst&>(inst);
+            return std::make_unique<BrInst>(map.block(br.getTarget()));
+        }
+        case MIRInstructionKind::CondBr: {
+            auto& condBr = static_cast<const CondBrInst&>(inst);
+            return std::make_unique<CondBrInst>(map.value(condBr.getCond()), map.block(condBr.getThenLabel()), map.block(condBr.getElseLabel()));
+        }
+        case MIRInstructionKind::Phi: {
+            auto& phi = static_cast<const PhiInst&>(inst);
+            auto copy = std::make_unique<PhiInst>(map.value(phi.getDest()), phi.getType());
+            for (const auto& incoming : phi.getIncomings()) {
+                copy->addIncoming(map.block(incoming.block), map.value(incoming.value));
+            }
+            return copy;
+        }
+        case MIRInstructionKind::Ret:
+            break;
+    }
+    throw std::logic_error("ret is rewritten by inlineCall, not cloned");
+}
+
+} // namespace
+
+unsigned inlineCost(const MIRFunction& func) {
+    unsigned cost = 0;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            switch (inst->getKind()) {
+                case MIRInstructionKind::Alloca:
+                case MIRInstructionKind::ConstInt:
+                case MIRInstructionKind::ConstBool:
+                case MIRInstructionKind::ConstString:
+                case MIRInstructionKind::ConstDouble:
+                case MIRInstructionKind::Phi:
+                case MIRInstructionKind::Br:
+                case MIRInstructionKind::Ret:
+                    break;
+                case MIRInstructionKind::Call:
+                    cost += CallCost;
+                    break;
+                default:
+                    cost += 1;
+                    break;
+            }
+        }
+    }
+    return cost;
+}
+
+bool isInlinable(const MIRFunction& callee) {
+    const auto& blocks = callee.getBlocks();
+    if (blocks.empty() || callee.getVarArg()) return false;
+    bool returns = false;
+    for (const auto& block : blocks) {
+        const auto& insts = block->getInstructions();
+        if (insts.empty()) continue;
+        if (!block->hasTerminator()) return false;
+        if (insts.back()->getKind() == MIRInstructionKind::Ret) returns = true;
+        for (const auto& succ : block->getSuccessorNames()) {
+            if (succ == blocks.front()->getName()) return false;
+        }
+    }
+    return returns;
+}
+
+void inlineCall(MIRFunction& caller, CallInst& call, const MIRFunction& callee) {
+    BasicBlock* callBlock = call.getParent();
+    const auto& callBlockInsts = callBlock->getInstructions();
+    size_t callIndex = 0;
+    while (callBlockInsts[callIndex].get() != &call) ++callIndex;
+
+    CalleeMap map(caller, callee);
+    for (size_t i = 0; i < callee.getParameters().size(); ++i) {
+        map.bindValue(callee.getParameterValue(i), call.getArgs()[i]);
+    }
+    // Nothing branches back to the callee's entry, so its instructions take the call's place
+    const auto& calleeBlocks = callee.getBlocks();
+    map.bindBlock(calleeBlocks.front()->getName(), callBlock->getName());
+
+    auto tail = callBlock->takeInstructionsFrom(callIndex);
+    ValueID result = callee.getReturnType()->isVoid() ? NoValue : call.getDest();
+    tail.erase(tail.begin()); // destroys the call
+
+    size_t numReturns = 0;
+    for (const auto& block : calleeBlocks) {
+        const auto& insts = block->getInstructions();
+        if (!insts.empty() && insts.back()->getKind() == MIRInstructionKind::Ret) ++numReturns;
+    }
+
+    // With several returns the rest of the call's block moves to an exit block where a phi
+    // merges the results; a single return copies its value and continues in place
+    std::unique_ptr<BasicBlock> exit;
+    PhiInst* resultPhi = nullptr;
+    if (numReturns > 1) {
+        exit = std::make_unique<BasicBlock>(map.freshBlockName(callee.getName() + ".exit"));
+        if (result != NoValue) {
+            auto phi = std::make_unique<PhiInst>(result, callee.getReturnType());
+            resultPhi = phi.get();
+            exit->appendInstruction(std::move(phi));
+        }
+    }
+    auto appendTail = [&](BasicBlock& block) {
+        for (auto& inst : tail) {
+            block.appendInstruction(std::move(inst));
+        }
+    };
+
+    BasicBlock* tailBlock = exit.get();
+    for (const auto& calleeBlock : calleeBlocks) {
+        if (calleeBlock->getInstructions().empty()) continue;
+        std::unique_ptr<BasicBlock> newBlock;
+        BasicBlock* block = callBlock;
+        if (calleeBlock != calleeBlocks.front()) {
+            newBlock = std::make_unique<BasicBlock>(map.block(calleeBlock->getName()));
+            block = newBlock.get();
+        }
+        for (const auto& inst : calleeBlock->getInstructions()) {
+            if (inst->getKind() != MIRInstructionKind::Ret) {
+                block->appendInstruction(cloneInstruction(*inst, map));
+                continue;
+            }
+            ValueID returned = map.value(static_cast<const ReturnInst&>(*inst).getVal());
+            if (exit) {
+                if (resultPhi) resultPhi->addIncoming(block->getName(), returned);
+                block->appendInstruction(std::make_unique<BrInst>(exit->getName()));
+            } else {
+                if (result != NoValue) block->appendInstruction(std::make_unique<UnaryOpInst>(result, returned, TokenType::Plus));
+                appendTail(*block);
+                tailBlock = block;
+            }
+        }
+        if (newBlock) caller.appendBlock(std::move(newBlock));
+    }
+    if (exit) {
+        appendTail(*exit);
+        caller.appendBlock(std::move(exit));
+    }
+
+    // The call's block's outgoing edges now leave from wherever its tail landed
+    if (tailBlock == callBlock) return;
+    for (const auto& succName : tailBlock->getSuccessorNames()) {
+        for (const auto& block : caller.getBlocks()) {
+            if (block->getName() != succName) continue;
+            for (const auto& inst : block->getInstructions()) {
+                if (inst->getKind() == MIRInstructionKind::Phi) {
+                    static_cast<PhiInst&>(*inst).replaceIncomingBlock(callBlock->getName(), tailBlock->getName());
+                }
+            }
+        }
+    }
+}
+
+} // namespace chtholly
@@ -1,5 +1,6 @@
 #include "MIR/MIRBuilder.h"
 #include "AST/Patterns.h"
+#include "PhaseTimer.h"
 #include <stdexcept>
 #include <iostream>
 
@@ -87,8 +88,8 @@ void MIRBuilder::lower(ASTNode* node) {
     }
 }
 
-std::string MIRBuilder::lowerExpr(Expr* expr) {
-    if (!expr) return "";
+ValueID MIRBuilder::lowerExpr(Expr* expr) {
+    if (!expr) return NoValue;
     switch (expr->getKind()) {
         case ASTNodeKind::LiteralExpr:
             return lowerLiteralExpr(static_cast<LiteralExpr*>(expr));
@@ -117,7 +118,7 @@ std::string MIRBuilder::lowerExpr(Expr* expr) {
         case ASTNodeKind::IntrinsicExpr:
             return lowerIntrinsicExpr(static_cast<IntrinsicExpr*>(expr));
         default:
-            return "";
+            return NoValue;
     }
 }
 
@@ -127,7 +128,7 @@ void MIRBuilder::lowerVarDecl(VarDecl* decl) {
     }
     
     std::shared_ptr<Type> type = decl->getType();
-    std::string initVal;
+    ValueID initVal = NoValue;
     if (decl->getInitializer()) {
         auto initExpr = const_cast<Expr*>(decl->getInitializer());
         initVal = lowerExpr(initExpr);
@@ -145,7 +146,7 @@ void MIRBuilder::lowerVarDecl(VarDecl* decl) {
 
     if (!type) type = Type::getI32();
 
-    std::string mirName = "%" + decl->getName();
+    ValueID mirName = currentFunction->createValue("%" + decl->getName(), type);
     currentBlock->appendInstruction(std::make_unique<AllocaInst>(mirName, type));
     
     if (!scopeStack.empty()) {
@@ -155,9 +156,9 @@ void MIRBuilder::lowerVarDecl(VarDecl* decl) {
         ShadowedVar shadow;
         shadow.name = decl->getName();
         if (varMap.count(shadow.name)) {
-            shadow.oldMirName = varMap[shadow.name];
-            if (ptrTypeMap.count(shadow.oldMirName)) {
-                shadow.oldPtrType = ptrTypeMap[shadow.oldMirName];
+            shadow.oldMirValue = varMap[shadow.name];
+            if (ptrTypeMap.count(shadow.oldMirValue)) {
+                shadow.oldPtrType = ptrTypeMap[shadow.oldMirValue];
             }
             scope.shadowed.push_back(shadow);
         }
@@ -168,7 +169,7 @@ void MIRBuilder::lowerVarDecl(VarDecl* decl) {
         ptrTypeMap[mirName] = std::dynamic_pointer_cast<StructType>(type)->getName();
     }
 
-    if (!initVal.empty()) {
+    if (initVal != NoValue) {
         currentBlock->appendInstruction(std::make_unique<StoreInst>(initVal, mirName));
     }
 }
@@ -183,14 +184,16 @@ void MIRBuilder::lowerBlock(Block* block, bool shouldPushScope) {
 }
 
 void MIRBuilder::lowerFunctionDecl(FunctionDecl* decl) {
+    PhaseTimer timer("MIR function", decl->getName());
+
     // Reset function-local state
     scopeStack.clear();
     varMap.clear();
     ptrTypeMap.clear();
-    tempCount = 0;
 
     auto func = std::make_unique<MIRFunction>(decl->getName(), decl->getReturnType());
     func->setVarArg(decl->getVarArg());
+    func->setInlineHint(decl->getInlineHint());
     
     // Add parameters to MIRFunction first
     for (const auto& param : decl->getParams()) {
@@ -212,10 +215,11 @@ void MIRBuilder::lowerFunctionDecl(FunctionDecl* decl) {
     
     // Lower body parameters (alloca and store)
     pushScope();
-    for (const auto& param : decl->getParams()) {
-        std::string argName = "%" + param->getName();
+    for (size_t i = 0; i < decl->getParams().size(); ++i) {
+        const auto& param = decl->getParams()[i];
+        ValueID argName = currentFunction->getParameterValue(i);
         
-        std::string stackName = "%" + param->getName() + ".addr";
+        ValueID stackName = currentFunction->createValue("%" + param->getName() + ".addr", param->getType());
         currentBlock->appendInstruction(std::make_unique<AllocaInst>(stackName, param->getType()));
         currentBlock->appendInstruction(std::make_unique<StoreInst>(argName, stackName));
         
@@ -239,7 +243,7 @@ void MIRBuilder::lowerFunctionDecl(FunctionDecl* decl) {
         if (decl->getReturnType()->isVoid()) {
             currentBlock->appendInstruction(std::make_unique<ReturnInst>());
         } else if (decl->getReturnType()->isInteger()) {
-            std::string temp = newTemp();
+            ValueID temp = newTemp();
             currentBlock->appendInstruction(std::make_unique<ConstIntInst>(temp, 0));
             currentBlock->appendInstruction(std::make_unique<ReturnInst>(temp));
         }
@@ -251,7 +255,7 @@ void MIRBuilder::lowerFunctionDecl(FunctionDecl* decl) {
 }
 
 void MIRBuilder::lowerReturnStmt(ReturnStmt* stmt) {
-    std::string val;
+    ValueID val = NoValue;
     if (stmt->getExpression()) {
         val = lowerExpr(const_cast<Expr*>(stmt->getExpression()));
     }
@@ -260,7 +264,7 @@ void MIRBuilder::lowerReturnStmt(ReturnStmt* stmt) {
 }
 
 void MIRBuilder::lowerIfStmt(IfStmt* stmt) {
-    std::string cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
+    ValueID cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
     
     BasicBlock* thenBB = newBlock("if.then");
     BasicBlock* elseBB = stmt->getElseBlock() ? newBlock("if.else") : nullptr;
@@ -315,7 +319,7 @@ void MIRBuilder::lowerWhileStmt(WhileStmt* stmt) {
 
     // Condition block
     currentBlock = condBB;
-    std::string cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
+    ValueID cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
     currentBlock->appendInstruction(std::make_unique<CondBrInst>(cond, bodyBB->getName(), mergeBB->getName()));
 
     // Body block
@@ -345,7 +349,7 @@ void MIRBuilder::lowerDoWhileStmt(DoWhileStmt* stmt) {
     }
 
     currentBlock = condBB;
-    std::string cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
+    ValueID cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
     currentBlock->appendInstruction(std::make_unique<CondBrInst>(cond, bodyBB->getName(), mergeBB->getName()));
 
     loopStack.pop_back();
@@ -365,7 +369,7 @@ void MIRBuilder::lowerForStmt(ForStmt* stmt) {
 
     currentBlock = condBB;
     if (stmt->getCondition()) {
-        std::string cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
+        ValueID cond = lowerExpr(const_cast<Expr*>(stmt->getCondition()));
         currentBlock->appendInstruction(std::make_unique<CondBrInst>(cond, bodyBB->getName(), mergeBB->getName()));
     } else {
         currentBlock->appendInstruction(std::make_unique<BrInst>(bodyBB->getName()));
@@ -387,7 +391,7 @@ void MIRBuilder::lowerForStmt(ForStmt* stmt) {
 
 void MIRBuilder::lowerSwitchStmt(SwitchStmt* stmt) {
     auto condExpr = const_cast<Expr*>(stmt->getCondition());
-    std::string condAddr = lowerAddr(condExpr);
+    ValueID condAddr = lowerAddr(condExpr);
     auto condType = condExpr->getType();
 
     BasicBlock* endBB = newBlock("switch.end");
@@ -420,13 +424,13 @@ void MIRBuilder::lowerSwitchStmt(SwitchStmt* stmt) {
                     auto enumTy = std::dynamic_pointer_cast<EnumType>(condType);
                     int tag = enumTy->findVariantIndex(varPat->getVariantName());
 
-                    std::string actualTag = newTemp();
+                    ValueID actualTag = newTemp();
                     currentBlock->appendInstruction(std::make_unique<VariantTagInst>(actualTag, condAddr));
                     
-                    std::string expectedTag = newTemp();
+                    ValueID expectedTag = newTemp();
                     currentBlock->appendInstruction(std::make_unique<ConstIntInst>(expectedTag, tag));
                     
-                    std::string cmp = newTemp();
+                    ValueID cmp = newTemp();
                     currentBlock->appendInstruction(std::make_unique<BinOpInst>(cmp, actualTag, expectedTag, TokenType::EqualEqual));
                     
                     currentBlock->appendInstruction(std::make_unique<CondBrInst>(cmp, bodyLabel, nextCaseLabel));
@@ -439,11 +443,11 @@ void MIRBuilder::lowerSwitchStmt(SwitchStmt* stmt) {
                 auto kind = c->getPattern()->getKind();
                 if (kind == ASTNodeKind::LiteralPattern) {
                     auto litPat = static_cast<const LiteralPattern*>(c->getPattern());
-                    std::string val = lowerExpr(const_cast<LiteralExpr*>(const_cast<LiteralExpr*>(litPat->getLiteral())));
-                    std::string condVal = newTemp();
+                    ValueID val = lowerExpr(const_cast<LiteralExpr*>(const_cast<LiteralExpr*>(litPat->getLiteral())));
+                    ValueID condVal = newTemp();
                     currentBlock->appendInstruction(std::make_unique<LoadInst>(condVal, condAddr));
                     
-                    std::string cmp = newTemp();
+                    ValueID cmp = newTemp();
                     currentBlock->appendInstruction(std::make_unique<BinOpInst>(cmp, condVal, val, TokenType::EqualEqual));
                     currentBlock->appendInstruction(std::make_unique<CondBrInst>(cmp, bodyLabel, nextCaseLabel));
                 } else if (kind == ASTNodeKind::WildcardPattern || kind == ASTNodeKind::IdentifierPattern) {
@@ -467,7 +471,7 @@ void MIRBuilder::lowerSwitchStmt(SwitchStmt* stmt) {
                 for (size_t j = 0; j < subPats.size(); ++j) {
                     if (subPats[j]->getKind() == ASTNodeKind::IdentifierPattern) {
                         auto idPat = static_cast<const IdentifierPattern*>(subPats[j].get());
-                        std::string fieldVal = newTemp();
+                        ValueID fieldVal = newTemp();
                         std::shared_ptr<Type> fieldType;
                         if (variant->kind == EnumType::Variant::Kind::Tuple) fieldType = variant->tupleTypes[j];
                         else fieldType = variant->structFields[j].type;
@@ -475,7 +479,7 @@ void MIRBuilder::lowerSwitchStmt(SwitchStmt* stmt) {
                         currentBlock->appendInstruction(std::make_unique<VariantExtractInst>(fieldVal, condAddr, (int)enumTy->findVariantIndex(variant->name), (int)j, fieldType));
                         
                         // Bind to local variable
-                        std::string localAddr = newTemp();
+                        ValueID localAddr = newTemp();
                         currentBlock->appendInstruction(std::make_unique<AllocaInst>(localAddr, fieldType));
                         currentBlock->appendInstruction(std::make_unique<StoreInst>(fieldVal, localAddr));
                         varMap[idPat->getName()] = localAddr;
@@ -509,8 +513,8 @@ void MIRBuilder::lowerContinueStmt(ContinueStmt* stmt) {
     currentBlock->appendInstruction(std::make_unique<BrInst>(loopStack.back().continueLabel));
 }
 
-std::string MIRBuilder::lowerAddr(Expr* expr) {
-    if (!expr) return "";
+ValueID MIRBuilder::lowerAddr(Expr* expr) {
+    if (!expr) return NoValue;
     switch (expr->getKind()) {
         case ASTNodeKind::IdentifierExpr: {
             auto id = static_cast<IdentifierExpr*>(expr);
@@ -519,18 +523,19 @@ std::string MIRBuilder::lowerAddr(Expr* expr) {
         }
         case ASTNodeKind::MemberAccessExpr: {
             auto memAccess = static_cast<MemberAccessExpr*>(expr);
-            std::string baseAddr = lowerAddr(const_cast<Expr*>(memAccess->getBase()));
+            ValueID baseAddr = lowerAddr(const_cast<Expr*>(memAccess->getBase()));
             std::string structName = ptrTypeMap[baseAddr];
-            std::string result = newTemp();
+            ValueID result = newTemp();
             currentBlock->appendInstruction(std::make_unique<StructElementPtrInst>(result, baseAddr, structName, memAccess->getMemberName()));
             return result;
         }
         case ASTNodeKind::IndexingExpr: {
             auto indexing = static_cast<IndexingExpr*>(expr);
-            std::string baseAddr = lowerAddr(const_cast<Expr*>(indexing->getBase()));
-            std::string indexVal = lowerExpr(const_cast<Expr*>(indexing->getIndex()));
-            std::string result = newTemp();
+            ValueID baseAddr = lowerAddr(const_cast<Expr*>(indexing->getBase()));
+            ValueID indexVal = lowerExpr(const_cast<Expr*>(indexing->getIndex()));
+            ValueID result = newTemp();
             auto arrayTy = std::dynamic_pointer_cast<ArrayType>(const_cast<Expr*>(indexing->getBase())->getType());
+            if (boundsChecks) currentBlock->appendInstruction(std::make_unique<BoundsCheckInst>(indexVal, arrayTy->getSize()));
             currentBlock->appendInstruction(std::make_unique<ArrayElementPtrInst>(result, baseAddr, indexVal, arrayTy->getBaseType()));
             return result;
         }
@@ -539,12 +544,12 @@ std::string MIRBuilder::lowerAddr(Expr* expr) {
             return lowerExpr(const_cast<Expr*>(deref->getOperand()));
         }
         default:
-            return "";
+            return NoValue;
     }
 }
 
-std::string MIRBuilder::lowerLiteralExpr(LiteralExpr* expr) {
-    std::string temp = newTemp();
+ValueID MIRBuilder::lowerLiteralExpr(LiteralExpr* expr) {
+    ValueID temp = newTemp();
     const auto& value = expr->getValue();
 
     if (std::holds_alternative<bool>(value)) {
@@ -562,33 +567,33 @@ std::string MIRBuilder::lowerLiteralExpr(LiteralExpr* expr) {
     return temp;
 }
 
-std::string MIRBuilder::lowerBinaryExpr(BinaryExpr* expr) {
+ValueID MIRBuilder::lowerBinaryExpr(BinaryExpr* expr) {
     if (expr->getOp() == TokenType::Equal) {
-        std::string dest = lowerAddr(const_cast<Expr*>(expr->getLeft()));
-        std::string src = lowerExpr(const_cast<Expr*>(expr->getRight()));
+        ValueID dest = lowerAddr(const_cast<Expr*>(expr->getLeft()));
+        ValueID src = lowerExpr(const_cast<Expr*>(expr->getRight()));
         currentBlock->appendInstruction(std::make_unique<StoreInst>(src, dest));
         return src;
     }
 
-    std::string left = lowerExpr(const_cast<Expr*>(expr->getLeft()));
-    std::string right = lowerExpr(const_cast<Expr*>(expr->getRight()));
-    std::string dest = newTemp();
+    ValueID left = lowerExpr(const_cast<Expr*>(expr->getLeft()));
+    ValueID right = lowerExpr(const_cast<Expr*>(expr->getRight()));
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<BinOpInst>(dest, left, right, expr->getOp()));
     return dest;
 }
 
-std::string MIRBuilder::lowerUnaryExpr(UnaryExpr* expr) {
-    std::string operand = lowerExpr(const_cast<Expr*>(expr->getOperand()));
-    std::string dest = newTemp();
+ValueID MIRBuilder::lowerUnaryExpr(UnaryExpr* expr) {
+    ValueID operand = lowerExpr(const_cast<Expr*>(expr->getOperand()));
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<UnaryOpInst>(dest, operand, expr->getOp()));
     return dest;
 }
 
-std::string MIRBuilder::lowerIdentifierExpr(IdentifierExpr* id) {
+ValueID MIRBuilder::lowerIdentifierExpr(IdentifierExpr* id) {
     std::string name = id->toString();
     if (varMap.find(name) != varMap.end()) {
-        std::string src = varMap[name];
-        std::string dest = newTemp();
+        ValueID src = varMap[name];
+        ValueID dest = newTemp();
         currentBlock->appendInstruction(std::make_unique<LoadInst>(dest, src));
         return dest;
     }
@@ -596,13 +601,13 @@ std::string MIRBuilder::lowerIdentifierExpr(IdentifierExpr* id) {
     for (auto const& [enumName, enumTy] : enumTypes) {
         int tag = enumTy->findVariantIndex(name);
         if (tag != -1) {
-            std::string enumPtr = newTemp();
+            ValueID enumPtr = newTemp();
             currentBlock->appendInstruction(std::make_unique<AllocaInst>(enumPtr, enumTy));
             
-            std::string voidDest = newTemp();
-            currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::vector<std::string>{}));
+            ValueID voidDest = newTemp();
+            currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::vector<ValueID>{}));
             
-            std::string result = newTemp();
+            ValueID result = newTemp();
             currentBlock->appendInstruction(std::make_unique<LoadInst>(result, enumPtr));
             return result;
         }
@@ -611,9 +616,9 @@ std::string MIRBuilder::lowerIdentifierExpr(IdentifierExpr* id) {
     throw std::runtime_error("Undefined identifier in MIR lowering: " + name);
 }
 
-std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
+ValueID MIRBuilder::lowerCallExpr(CallExpr* call) {
     std::string calleeName;
-    std::vector<std::string> args;
+    std::vector<ValueID> args;
 
     if (call->getCallee()->getKind() == ASTNodeKind::IdentifierExpr) {
         auto id = static_cast<const IdentifierExpr*>(call->getCallee());
@@ -621,21 +626,21 @@ std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
         
         if (structTypes.find(calleeName) != structTypes.end()) {
              auto& info = structTypes[calleeName];
-             std::string objPtr = newTemp();
+             ValueID objPtr = newTemp();
              currentBlock->appendInstruction(std::make_unique<AllocaInst>(objPtr, info.type));
              ptrTypeMap[objPtr] = calleeName;
              
-             std::vector<std::string> ctorArgs;
+             std::vector<ValueID> ctorArgs;
              ctorArgs.push_back(objPtr);
              for (const auto& arg : call->getArgs()) {
                  ctorArgs.push_back(lowerExpr(arg.get()));
              }
              
              std::string ctorName = calleeName + "_" + calleeName;
-             std::string voidDest = newTemp();
-             currentBlock->appendInstruction(std::make_unique<CallInst>(voidDest, ctorName, std::move(ctorArgs)));
+             ValueID voidDest = newTemp();
+             currentBlock->appendInstruction(newCall(voidDest, ctorName, std::move(ctorArgs)));
              
-             std::string result = newTemp();
+             ValueID result = newTemp();
              currentBlock->appendInstruction(std::make_unique<LoadInst>(result, objPtr));
              return result;
         }
@@ -643,18 +648,18 @@ std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
         for (auto const& [name, enumTy] : enumTypes) {
             int tag = enumTy->findVariantIndex(calleeName);
             if (tag != -1) {
-                std::string enumPtr = newTemp();
+                ValueID enumPtr = newTemp();
                 currentBlock->appendInstruction(std::make_unique<AllocaInst>(enumPtr, enumTy));
                 
-                std::vector<std::string> variantArgs;
+                std::vector<ValueID> variantArgs;
                 for (const auto& arg : call->getArgs()) {
                     variantArgs.push_back(lowerExpr(arg.get()));
                 }
                 
-                std::string voidDest = newTemp();
+                ValueID voidDest = newTemp();
                 currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::move(variantArgs)));
                 
-                std::string result = newTemp();
+                ValueID result = newTemp();
                 currentBlock->appendInstruction(std::make_unique<LoadInst>(result, enumPtr));
                 return result;
             }
@@ -671,7 +676,7 @@ std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
         if (spec->getBase()->getKind() == ASTNodeKind::MemberAccessExpr) {
             auto memAccess = static_cast<const MemberAccessExpr*>(spec->getBase());
             // It's a method call!
-            std::string selfAddr = lowerAddr(const_cast<Expr*>(memAccess->getBase()));
+            ValueID selfAddr = lowerAddr(const_cast<Expr*>(memAccess->getBase()));
             args.push_back(selfAddr);
         }
 
@@ -702,18 +707,18 @@ std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
                  auto enumTy = enumTypes[baseName];
                  int tag = enumTy->findVariantIndex(memAccess->getMemberName());
                  if (tag != -1) {
-                     std::string enumPtr = newTemp();
+                     ValueID enumPtr = newTemp();
                      currentBlock->appendInstruction(std::make_unique<AllocaInst>(enumPtr, enumTy));
                      
-                     std::vector<std::string> variantArgs;
+                     std::vector<ValueID> variantArgs;
                      for (const auto& arg : call->getArgs()) {
                          variantArgs.push_back(lowerExpr(arg.get()));
                      }
                      
-                     std::string voidDest = newTemp();
+                     ValueID voidDest = newTemp();
                      currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::move(variantArgs)));
                      
-                     std::string result = newTemp();
+                     ValueID result = newTemp();
                      currentBlock->appendInstruction(std::make_unique<LoadInst>(result, enumPtr));
                      return result;
                  }
@@ -725,7 +730,7 @@ std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
                  }
              }
         } else if (isVariable) {
-             std::string allocaPtr = varMap[baseName];
+             ValueID allocaPtr = varMap[baseName];
              if (ptrTypeMap.find(allocaPtr) == ptrTypeMap.end()) {
                  throw std::runtime_error("Unknown type for variable: " + baseName);
              }
@@ -744,12 +749,12 @@ std::string MIRBuilder::lowerCallExpr(CallExpr* call) {
         throw std::runtime_error("Complex callee not supported in MIRBuilder yet: " + call->getCallee()->toString());
     }
 
-    std::string dest = newTemp();
-    currentBlock->appendInstruction(std::make_unique<CallInst>(dest, calleeName, std::move(args)));
+    ValueID dest = newTemp();
+    currentBlock->appendInstruction(newCall(dest, calleeName, std::move(args)));
     return dest;
 }
 
-std::string MIRBuilder::lowerMemberAccessExpr(MemberAccessExpr* expr) {
+ValueID MIRBuilder::lowerMemberAccessExpr(MemberAccessExpr* expr) {
     if (expr->getBase()->getKind() == ASTNodeKind::IdentifierExpr) {
         auto id = static_cast<const IdentifierExpr*>(expr->getBase());
         std::string baseName = id->toString();
@@ -757,13 +762,13 @@ std::string MIRBuilder::lowerMemberAccessExpr(MemberAccessExpr* expr) {
             auto enumTy = enumTypes[baseName];
             int tag = enumTy->findVariantIndex(expr->getMemberName());
             if (tag != -1) {
-                std::string enumPtr = newTemp();
+                ValueID enumPtr = newTemp();
                 currentBlock->appendInstruction(std::make_unique<AllocaInst>(enumPtr, enumTy));
                 
-                std::string voidDest = newTemp();
-                currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::vector<std::string>{}));
+                ValueID voidDest = newTemp();
+                currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::vector<ValueID>{}));
                 
-                std::string result = newTemp();
+                ValueID result = newTemp();
                 currentBlock->appendInstruction(std::make_unique<LoadInst>(result, enumPtr));
                 return result;
             }
@@ -775,32 +780,32 @@ std::string MIRBuilder::lowerMemberAccessExpr(MemberAccessExpr* expr) {
             auto enumTy = enumTypes[mangledName];
             int tag = enumTy->findVariantIndex(expr->getMemberName());
             if (tag != -1) {
-                std::string enumPtr = newTemp();
+                ValueID enumPtr = newTemp();
                 currentBlock->appendInstruction(std::make_unique<AllocaInst>(enumPtr, enumTy));
                 
-                std::vector<std::string> variantArgs; // Unit variant has no args
-                std::string voidDest = newTemp();
+                std::vector<ValueID> variantArgs; // Unit variant has no args
+                ValueID voidDest = newTemp();
                 currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::move(variantArgs)));
                 
-                std::string result = newTemp();
+                ValueID result = newTemp();
                 currentBlock->appendInstruction(std::make_unique<LoadInst>(result, enumPtr));
                 return result;
             }
         }
     }
 
-    std::string basePtr = lowerAddr(const_cast<Expr*>(expr->getBase()));
+    ValueID basePtr = lowerAddr(const_cast<Expr*>(expr->getBase()));
     std::string structName = ptrTypeMap[basePtr]; 
 
-    std::string fieldPtr = newTemp();
+    ValueID fieldPtr = newTemp();
     currentBlock->appendInstruction(std::make_unique<StructElementPtrInst>(fieldPtr, basePtr, structName, expr->getMemberName()));
     
-    std::string dest = newTemp();
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<LoadInst>(dest, fieldPtr));
     return dest;
 }
 
-std::string MIRBuilder::lowerStructLiteralExpr(StructLiteralExpr* expr) {
+ValueID MIRBuilder::lowerStructLiteralExpr(StructLiteralExpr* expr) {
     std::string name;
     if (expr->getBase()->getKind() == ASTNodeKind::SpecializationExpr) {
         auto spec = static_cast<const SpecializationExpr*>(expr->getBase());
@@ -821,11 +826,11 @@ std::string MIRBuilder::lowerStructLiteralExpr(StructLiteralExpr* expr) {
                 int tag = enumTy->findVariantIndex(variantName);
                 if (tag != -1) {
                     const auto& variant = enumTy->getVariants()[tag];
-                    std::string enumPtr = newTemp();
+                    ValueID enumPtr = newTemp();
                     currentBlock->appendInstruction(std::make_unique<AllocaInst>(enumPtr, enumTy));
                     ptrTypeMap[enumPtr] = enumName;
 
-                    std::vector<std::string> args;
+                    std::vector<ValueID> args;
                     for (const auto& f : variant.structFields) {
                         for (const auto& init : expr->getFields()) {
                             if (init.name == f.name) {
@@ -835,10 +840,10 @@ std::string MIRBuilder::lowerStructLiteralExpr(StructLiteralExpr* expr) {
                         }
                     }
 
-                    std::string voidDest = newTemp();
+                    ValueID voidDest = newTemp();
                     currentBlock->appendInstruction(std::make_unique<VariantDataInst>(voidDest, enumPtr, tag, std::move(args)));
                     
-                    std::string result = newTemp();
+                    ValueID result = newTemp();
                     currentBlock->appendInstruction(std::make_unique<LoadInst>(result, enumPtr));
                     return result;
                 }
@@ -848,70 +853,70 @@ std::string MIRBuilder::lowerStructLiteralExpr(StructLiteralExpr* expr) {
     }
     const auto& info = it->second;
 
-    std::string structPtr = newTemp();
+    ValueID structPtr = newTemp();
     currentBlock->appendInstruction(std::make_unique<AllocaInst>(structPtr, info.type));
     ptrTypeMap[structPtr] = name;
     
     for (const auto& init : expr->getFields()) {
-        std::string val = lowerExpr(const_cast<Expr*>(init.value.get()));
-        std::string fieldPtr = newTemp();
+        ValueID val = lowerExpr(const_cast<Expr*>(init.value.get()));
+        ValueID fieldPtr = newTemp();
         currentBlock->appendInstruction(std::make_unique<StructElementPtrInst>(fieldPtr, structPtr, name, init.name));
         currentBlock->appendInstruction(std::make_unique<StoreInst>(val, fieldPtr));
     }
     
-    std::string dest = newTemp();
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<LoadInst>(dest, structPtr));
     return dest;
 }
 
-std::string MIRBuilder::lowerArrayLiteralExpr(ArrayLiteralExpr* expr) {
-    auto arrayType = std::make_shared<ArrayType>(Type::getI32(), (int)expr->getElements().size());
+ValueID MIRBuilder::lowerArrayLiteralExpr(ArrayLiteralExpr* expr) {
+    auto arrayType = ArrayType::get(Type::getI32(), (int)expr->getElements().size());
     
-    std::string arrayPtr = newTemp();
+    ValueID arrayPtr = newTemp();
     currentBlock->appendInstruction(std::make_unique<AllocaInst>(arrayPtr, arrayType));
     
     for (size_t i = 0; i < expr->getElements().size(); ++i) {
-        std::string val = lowerExpr(expr->getElements()[i].get());
-        std::string indexTemp = newTemp();
+        ValueID val = lowerExpr(expr->getElements()[i].get());
+        ValueID indexTemp = newTemp();
         currentBlock->appendInstruction(std::make_unique<ConstIntInst>(indexTemp, i));
-        std::string elPtr = newTemp();
+        ValueID elPtr = newTemp();
         currentBlock->appendInstruction(std::make_unique<ArrayElementPtrInst>(elPtr, arrayPtr, indexTemp, arrayType->getBaseType()));
         currentBlock->appendInstruction(std::make_unique<StoreInst>(val, elPtr));
     }
     
-    std::string dest = newTemp();
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<LoadInst>(dest, arrayPtr));
     return dest;
 }
 
-std::string MIRBuilder::lowerIndexingExpr(IndexingExpr* expr) {
-    std::string elPtr = lowerAddr(expr);
-    std::string dest = newTemp();
+ValueID MIRBuilder::lowerIndexingExpr(IndexingExpr* expr) {
+    ValueID elPtr = lowerAddr(expr);
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<LoadInst>(dest, elPtr));
     return dest;
 }
 
-std::string MIRBuilder::lowerAddressOfExpr(AddressOfExpr* expr) {
+ValueID MIRBuilder::lowerAddressOfExpr(AddressOfExpr* expr) {
     return lowerAddr(const_cast<Expr*>(expr->getOperand()));
 }
 
-std::string MIRBuilder::lowerDereferenceExpr(DereferenceExpr* expr) {
-    std::string ptr = lowerExpr(const_cast<Expr*>(expr->getOperand()));
-    std::string dest = newTemp();
+ValueID MIRBuilder::lowerDereferenceExpr(DereferenceExpr* expr) {
+    ValueID ptr = lowerExpr(const_cast<Expr*>(expr->getOperand()));
+    ValueID dest = newTemp();
     currentBlock->appendInstruction(std::make_unique<LoadInst>(dest, ptr));
     return dest;
 }
 
-std::string MIRBuilder::lowerQuestionExpr(QuestionExpr* expr) {
-    std::string resVal = lowerExpr(const_cast<Expr*>(expr->getOperand()));
+ValueID MIRBuilder::lowerQuestionExpr(QuestionExpr* expr) {
+    ValueID resVal = lowerExpr(const_cast<Expr*>(expr->getOperand()));
     auto enumTy = std::dynamic_pointer_cast<EnumType>(const_cast<Expr*>(expr->getOperand())->getType());
     
     // Allocate space for the Result to extract tag and data
-    std::string resAddr = newTemp();
+    ValueID resAddr = newTemp();
     currentBlock->appendInstruction(std::make_unique<AllocaInst>(resAddr, enumTy));
     currentBlock->appendInstruction(std::make_unique<StoreInst>(resVal, resAddr));
 
-    std::string tag = newTemp();
+    ValueID tag = newTemp();
     currentBlock->appendInstruction(std::make_unique<VariantTagInst>(tag, resAddr));
 
     BasicBlock* okBB = newBlock("q.ok");
@@ -919,8 +924,8 @@ std::string MIRBuilder::lowerQuestionExpr(QuestionExpr* expr) {
     BasicBlock* mergeBB = newBlock("q.merge");
 
     // 0 is Ok, 1 is Err
-    std::string isErr = newTemp();
-    std::string zero = newTemp();
+    ValueID isErr = newTemp();
+    ValueID zero = newTemp();
     currentBlock->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
     currentBlock->appendInstruction(std::make_unique<BinOpInst>(isErr, tag, zero, TokenType::NotEqual));
     currentBlock->appendInstruction(std::make_unique<CondBrInst>(isErr, errBB->getName(), okBB->getName()));
@@ -932,7 +937,7 @@ std::string MIRBuilder::lowerQuestionExpr(QuestionExpr* expr) {
 
     // Ok block: extract value
     currentBlock = okBB;
-    std::string okVal = newTemp();
+    ValueID okVal = newTemp();
     auto okType = enumTy->getVariants()[0].tupleTypes[0];
     currentBlock->appendInstruction(std::make_unique<VariantExtractInst>(okVal, resAddr, 0, 0, okType));
     currentBlock->appendInstruction(std::make_unique<BrInst>(mergeBB->getName()));
@@ -941,8 +946,8 @@ std::string MIRBuilder::lowerQuestionExpr(QuestionExpr* expr) {
     return okVal;
 }
 
-std::string MIRBuilder::lowerIntrinsicExpr(IntrinsicExpr* expr) {
-    std::string result = newTemp();
+ValueID MIRBuilder::lowerIntrinsicExpr(IntrinsicExpr* expr) {
+    ValueID result = newTemp();
     switch (expr->getIntrinsicKind()) {
         case IntrinsicExpr::IntrinsicKind::Sizeof:
             currentBlock->appendInstruction(std::make_unique<SizeofInst>(result, expr->getTypeArg()));
@@ -956,15 +961,15 @@ std::string MIRBuilder::lowerIntrinsicExpr(IntrinsicExpr* expr) {
             break;
         }
         case IntrinsicExpr::IntrinsicKind::Malloc: {
-            std::string sizeVal;
+            ValueID sizeVal;
             if (expr->getArgs().empty()) {
-                std::string sizeTemp = newTemp();
+                ValueID sizeTemp = newTemp();
                 currentBlock->appendInstruction(std::make_unique<SizeofInst>(sizeTemp, expr->getTypeArg()));
                 sizeVal = sizeTemp;
             } else {
                 sizeVal = lowerExpr(expr->getArgs()[0].get());
             }
-            currentBlock->appendInstruction(std::make_unique<CallInst>(result, "malloc", std::vector<std::string>{sizeVal}));
+            currentBlock->appendInstruction(newCall(result, "malloc", std::vector<ValueID>{sizeVal}));
             break;
         }
         case IntrinsicExpr::IntrinsicKind::Alloca: {
@@ -972,8 +977,8 @@ std::string MIRBuilder::lowerIntrinsicExpr(IntrinsicExpr* expr) {
             break;
         }
         case IntrinsicExpr::IntrinsicKind::Free: {
-            std::string ptrVal = lowerExpr(expr->getArgs()[0].get());
-            currentBlock->appendInstruction(std::make_unique<CallInst>("", "free", std::vector<std::string>{ptrVal}));
+            ValueID ptrVal = lowerExpr(expr->getArgs()[0].get());
+            currentBlock->appendInstruction(newCall(NoValue, "free", std::vector<ValueID>{ptrVal}));
             break;
         }
     }
@@ -1000,8 +1005,12 @@ void MIRBuilder::lowerEnumDecl(EnumDecl* decl) {
     }
 }
 
-std::string MIRBuilder::newTemp() {
-    return "%t" + std::to_string(tempCount++);
+ValueID MIRBuilder::newTemp() {
+    return currentFunction->createTemp();
+}
+
+std::unique_ptr<CallInst> MIRBuilder::newCall(ValueID dest, const std::string& callee, std::vector<ValueID> args) {
+    return std::make_unique<CallInst>(dest, callee, std::move(args), module.getFunctionID(callee));
 }
 
 BasicBlock* MIRBuilder::newBlock(std::string name) {
@@ -1054,7 +1063,14 @@ void MIRBuilder::lowerClassDecl(ClassDecl* decl) {
 
 void MIRBuilder::lowerMethodDecl(MethodDecl* decl, const std::string& className) {
     std::string mangledName = className + "_" + decl->getName();
+    PhaseTimer timer("MIR function", mangledName);
+
+    // Value IDs are per function, so stale entries must not leak across
+    varMap.clear();
+    ptrTypeMap.clear();
+
     auto func = std::make_unique<MIRFunction>(mangledName, decl->getReturnType());
+    func->setInlineHint(decl->getInlineHint());
     currentFunction = func.get();
     
     auto entry = std::make_unique<BasicBlock>("entry");
@@ -1062,10 +1078,10 @@ void MIRBuilder::lowerMethodDecl(MethodDecl* decl, const std::string& className)
     currentFunction->appendBlock(std::move(entry));
     
     for (const auto& param : decl->getParams()) {
-        std::string argName = "%" + param->getName();
         func->addParameter(param->getName(), param->getType());
+        ValueID argName = func->getParameterValue(func->getParameters().size() - 1);
         
-        std::string stackName = "%" + param->getName() + ".addr";
+        ValueID stackName = func->createValue("%" + param->getName() + ".addr", param->getType());
         currentBlock->appendInstruction(std::make_unique<AllocaInst>(stackName, param->getType()));
         currentBlock->appendInstruction(std::make_unique<StoreInst>(argName, stackName));
         
@@ -1096,7 +1112,12 @@ void MIRBuilder::lowerMethodDecl(MethodDecl* decl, const std::string& className)
 
 void MIRBuilder::lowerConstructorDecl(ConstructorDecl* decl, const std::string& className) {
     std::string mangledName = className + "_" + decl->getName(); 
-    
+    PhaseTimer timer("MIR function", mangledName);
+
+    // Value IDs are per function, so stale entries must not leak across
+    varMap.clear();
+    ptrTypeMap.clear();
+
     auto func = std::make_unique<MIRFunction>(mangledName, Type::getVoid());
     currentFunction = func.get();
     
@@ -1105,12 +1126,12 @@ void MIRBuilder::lowerConstructorDecl(ConstructorDecl* decl, const std::string&
     currentFunction->appendBlock(std::move(entry));
     
     auto classType = structTypes[className].type;
-    auto selfPtrType = std::make_shared<PointerType>(classType);
+    auto selfPtrType = PointerType::get(classType);
     
-    std::string selfArgName = "%self";
     func->addParameter("self", selfPtrType);
+    ValueID selfArgName = func->getParameterValue(0);
     
-    std::string selfStackName = "%self.addr";
+    ValueID selfStackName = func->createValue("%self.addr", selfPtrType);
     currentBlock->appendInstruction(std::make_unique<AllocaInst>(selfStackName, selfPtrType));
     currentBlock->appendInstruction(std::make_unique<StoreInst>(selfArgName, selfStackName));
     
@@ -1118,10 +1139,10 @@ void MIRBuilder::lowerConstructorDecl(ConstructorDecl* decl, const std::string&
     ptrTypeMap[selfStackName] = className;
 
     for (const auto& param : decl->getParams()) {
-        std::string argName = "%" + param->getName();
         func->addParameter(param->getName(), param->getType());
+        ValueID argName = func->getParameterValue(func->getParameters().size() - 1);
         
-        std::string stackName = "%" + param->getName() + ".addr";
+        ValueID stackName = func->createValue("%" + param->getName() + ".addr", param->getType());
         currentBlock->appendInstruction(std::make_unique<AllocaInst>(stackName, param->getType()));
         currentBlock->appendInstruction(std::make_unique<StoreInst>(argName, stackName));
         
@@ -1160,8 +1181,8 @@ void MIRBuilder::popScope() {
             auto classType = std::dynamic_pointer_cast<ClassType>(it->type);
             if (structTypes.count(classType->getName()) && structTypes[classType->getName()].hasDestructor) {
                 std::string dtorName = classType->getName() + "_~" + classType->getName();
-                std::string addr = varMap[it->name];
-                currentBlock->appendInstruction(std::make_unique<CallInst>("", dtorName, std::vector<std::string>{addr}));
+                ValueID addr = varMap[it->name];
+                currentBlock->appendInstruction(newCall(NoValue, dtorName, std::vector<ValueID>{addr}));
             }
         }
         bool wasShadowing = false;
@@ -1172,16 +1193,16 @@ void MIRBuilder::popScope() {
             }
         }
         if (!wasShadowing) {
-            std::string mirName = varMap[it->name];
+            ValueID mirName = varMap[it->name];
             varMap.erase(it->name);
             ptrTypeMap.erase(mirName);
         }
     }
 
     for (const auto& s : scope.shadowed) {
-        varMap[s.name] = s.oldMirName;
+        varMap[s.name] = s.oldMirValue;
         if (!s.oldPtrType.empty()) {
-            ptrTypeMap[s.oldMirName] = s.oldPtrType;
+            ptrTypeMap[s.oldMirValue] = s.oldPtrType;
         }
     }
 
@@ -1196,8 +1217,8 @@ void MIRBuilder::emitAllDestructors() {
                 if (structTypes.count(classType->getName()) && structTypes[classType->getName()].hasDestructor) {
                     std::string dtorName = classType->getName() + "_~" + classType->getName();
                     if (varMap.count(it->name)) {
-                        std::string addr = varMap[it->name];
-                        currentBlock->appendInstruction(std::make_unique<CallInst>("", dtorName, std::vector<std::string>{addr}));
+                        ValueID addr = varMap[it->name];
+                        currentBlock->appendInstruction(newCall(NoValue, dtorName, std::vector<ValueID>{addr}));
                     }
                 }
             }
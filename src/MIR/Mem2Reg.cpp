@@ -0,0 +1,275 @@
+#include "MIR/Mem2Reg.h"
+#include "MIR/ValueTypes.h"
+#include <unordered_map>
+
+namespace chtholly {
+
+namespace {
+
+bool isScalar(const std::shared_ptr<Type>& type) {
+    return type && (type->isInteger() || type->isFloatingPoint() || type->isBoolean() || type->isPointer());
+}
+
+struct PendingPhi {
+    size_t candidate;
+    size_t block;
+    std::vector<PhiInst::Incoming> incomings;
+};
+
+} // namespace
+
+unsigned promoteAllocas(MIRFunction& func, const MIRModule& module) {
+    if (func.getBlocks().empty()) return 0;
+    DominatorTree domTree(func);
+    return promoteAllocas(func, domTree, inferValueTypes(func, module, domTree));
+}
+
+unsigned promoteAllocas(MIRFunction& func, const DominatorTree& domTree, const std::vector<std::shared_ptr<Type>>& types) {
+    if (func.getBlocks().empty()) return 0;
+
+    std::vector<ValueID> allocas;
+    std::vector<std::shared_ptr<Type>> allocaTypes;
+    std::unordered_map<ValueID, size_t> candidateOf;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() != MIRInstructionKind::Alloca) continue;
+            auto type = static_cast<const AllocaInst&>(*inst).getType();
+            if (!isScalar(type) || candidateOf.count(inst->getResult())) continue;
+            candidateOf.emplace(inst->getResult(), allocas.size());
+            allocas.push_back(inst->getResult());
+            allocaTypes.push_back(type);
+        }
+    }
+    if (allocas.empty()) return 0;
+
+    // Anything but loading from or storing to the alloca leaks its address
+    std::vector<bool> promotable(allocas.size(), true);
+    auto candidate = [&](ValueID value) -> size_t {
+        auto it = candidateOf.find(value);
+        return it == candidateOf.end() ? SIZE_MAX : it->second;
+    };
+    for (const auto& block : func.getBlocks()) {
+        // Codegen drops empty blocks, so a block must keep its terminator once its loads and stores go
+        bool eligible = domTree.indexOf(block.get()) != DominatorTree::Unreachable && block->hasTerminator();
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() == MIRInstructionKind::Load) {
+                size_t c = candidate(static_cast<const LoadInst&>(*inst).getSrc());
+                if (c != SIZE_MAX && !eligible) promotable[c] = false;
+                continue;
+            }
+            if (inst->getKind() == MIRInstructionKind::Store) {
+                auto& store = static_cast<const StoreInst&>(*inst);
+                size_t stored = candidate(store.getSrc());
+                if (stored != SIZE_MAX) promotable[stored] = false;
+                size_t c = candidate(store.getDest());
+                if (c != SIZE_MAX && (!eligible || !sameValueType(types[store.getSrc()], allocaTypes[c]))) promotable[c] = false;
+                continue;
+            }
+            inst->forEachOperand([&](ValueID& operand) {
+                size_t c = candidate(operand);
+                if (c != SIZE_MAX) promotable[c] = false;
+            });
+        }
+    }
+
+    // Phis get provisional IDs past the value table until it is known which of them survive
+    ValueID firstPhiID = static_cast<ValueID>(func.getNumValues());
+    std::vector<PendingPhi> phis;
+    std::unordered_map<ValueID, ValueID> replacement; // load result -> reaching value
+    while (true) {
+        phis.clear();
+        replacement.clear();
+        std::vector<std::vector<size_t>> phisAt(domTree.getNumBlocks());
+
+        // Phis go on the iterated dominance frontier of each block storing to the alloca
+        std::vector<std::vector<size_t>> storeBlocks(allocas.size());
+        for (size_t b = 0; b < domTree.getNumBlocks(); ++b) {
+            for (const auto& inst : domTree.getBlock(b)->getInstructions()) {
+                if (inst->getKind() != MIRInstructionKind::Store) continue;
+                size_t c = candidate(static_cast<const StoreInst&>(*inst).getDest());
+                if (c != SIZE_MAX && promotable[c] && (storeBlocks[c].empty() || storeBlocks[c].back() != b)) storeBlocks[c].push_back(b);
+            }
+        }
+        for (size_t c = 0; c < allocas.size(); ++c) {
+            if (!promotable[c]) continue;
+            std::vector<bool> hasPhi(domTree.getNumBlocks(), false);
+            std::vector<size_t> worklist = storeBlocks[c];
+            while (!worklist.empty()) {
+                size_t b = worklist.back();
+                worklist.pop_back();
+                for (size_t join : domTree.getFrontier(b)) {
+                    if (hasPhi[join]) continue;
+                    hasPhi[join] = true;
+                    phisAt[join].push_back(phis.size());
+                    phis.push_back({c, join, {}});
+                    worklist.push_back(join);
+                }
+            }
+        }
+
+        // Renaming walks the dominator tree keeping the reaching value of each alloca on a stack
+        std::vector<std::vector<ValueID>> reaching(allocas.size());
+        std::vector<bool> readsUndefined(allocas.size(), false);
+        std::vector<std::pair<size_t, bool>> walk = {{0, false}};
+        std::vector<std::vector<size_t>> pushed(domTree.getNumBlocks());
+        while (!walk.empty()) {
+            auto [b, leaving] = walk.back();
+            walk.pop_back();
+            if (leaving) {
+                for (size_t c : pushed[b]) reaching[c].pop_back();
+                continue;
+            }
+            walk.push_back({b, true});
+
+            for (size_t p : phisAt[b]) {
+                reaching[phis[p].candidate].push_back(firstPhiID + static_cast<ValueID>(p));
+                pushed[b].push_back(phis[p].candidate);
+            }
+            for (const auto& inst : domTree.getBlock(b)->getInstructions()) {
+                if (inst->getKind() == MIRInstructionKind::Load) {
+                    auto& load = static_cast<const LoadInst&>(*inst);
+                    size_t c = candidate(load.getSrc());
+                    if (c == SIZE_MAX || !promotable[c]) continue;
+                    if (reaching[c].empty()) {
+                        readsUndefined[c] = true;
+                        continue;
+                    }
+                    replacement[load.getDest()] = reaching[c].back();
+                } else if (inst->getKind() == MIRInstructionKind::Store) {
+                    auto& store = static_cast<const StoreInst&>(*inst);
+                    size_t c = candidate(store.getDest());
+                    if (c == SIZE_MAX || !promotable[c]) continue;
+                    auto it = replacement.find(store.getSrc());
+                    reaching[c].push_back(it == replacement.end() ? store.getSrc() : it->second);
+                    pushed[b].push_back(c);
+                }
+            }
+            for (size_t succ : domTree.getSuccessors(b)) {
+                for (size_t p : phisAt[succ]) {
+                    const auto& values = reaching[phis[p].candidate];
+                    phis[p].incomings.push_back({domTree.getBlock(b)->getName(), values.empty() ? NoValue : values.back()});
+                }
+            }
+            const auto& children = domTree.getChildren(b);
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                walk.push_back({*it, false});
+            }
+        }
+
+        // A load that can run before any store keeps its alloca; try again without those
+        bool retry = false;
+        for (size_t c = 0; c < allocas.size(); ++c) {
+            if (promotable[c] && readsUndefined[c]) {
+                promotable[c] = false;
+                retry = true;
+            }
+        }
+        if (!retry) break;
+    }
+
+    unsigned promoted = 0;
+    for (bool p : promotable) promoted += p;
+    if (!promoted) return 0;
+
+    auto isPromoted = [&](ValueID value) {
+        size_t c = candidate(value);
+        return c != SIZE_MAX && promotable[c];
+    };
+    auto isRemoved = [&](const MIRInstruction& inst) {
+        switch (inst.getKind()) {
+            case MIRInstructionKind::Alloca:
+                return isPromoted(inst.getResult());
+            case MIRInstructionKind::Load:
+                return isPromoted(static_cast<const LoadInst&>(inst).getSrc());
+            case MIRInstructionKind::Store:
+                return isPromoted(static_cast<const StoreInst&>(inst).getDest());
+            default:
+                return false;
+        }
+    };
+    auto resolve = [&](ValueID value) {
+        auto it = replacement.find(value);
+        return it == replacement.end() ? value : it->second;
+    };
+    auto phiIndex = [&](ValueID value) -> size_t {
+        return value >= firstPhiID ? value - firstPhiID : SIZE_MAX;
+    };
+
+    // Only phis something outside the promoted loads and stores reads are kept, with those they read
+    std::vector<bool> live(phis.size(), false);
+    std::vector<size_t> worklist;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (isRemoved(*inst)) continue;
+            inst->forEachOperand([&](ValueID& operand) {
+                size_t p = phiIndex(resolve(operand));
+                if (p != SIZE_MAX && !live[p]) {
+                    live[p] = true;
+                    worklist.push_back(p);
+                }
+            });
+        }
+    }
+    while (!worklist.empty()) {
+        size_t p = worklist.back();
+        worklist.pop_back();
+        for (const auto& incoming : phis[p].incomings) {
+            size_t q = incoming.value == NoValue ? SIZE_MAX : phiIndex(incoming.value);
+            if (q != SIZE_MAX && !live[q]) {
+                live[q] = true;
+                worklist.push_back(q);
+            }
+        }
+    }
+
+    std::vector<ValueID> phiValue(phis.size(), NoValue);
+    for (size_t p = 0; p < phis.size(); ++p) {
+        if (!live[p]) continue;
+        std::string name = func.getValueName(allocas[phis[p].candidate]);
+        const auto& type = allocaTypes[phis[p].candidate];
+        phiValue[p] = name.empty() ? func.createTemp(type) : func.createValue(name, type);
+    }
+    auto finalValue = [&](ValueID value) {
+        value = resolve(value);
+        size_t p = phiIndex(value);
+        return p == SIZE_MAX ? value : phiValue[p];
+    };
+
+    for (const auto& block : func.getBlocks()) {
+        block->eraseInstructionsIf(isRemoved);
+        for (const auto& inst : block->getInstructions()) {
+            inst->forEachOperand([&](ValueID& operand) { operand = finalValue(operand); });
+        }
+    }
+    // Codegen still emits unreachable blocks, so their edges into a phi's block need an entry too
+    for (const auto& block : func.getBlocks()) {
+        if (domTree.indexOf(block.get()) != DominatorTree::Unreachable) continue;
+        for (const auto& name : block->getSuccessorNames()) {
+            for (auto& phi : phis) {
+                if (domTree.getBlock(phi.block)->getName() == name) phi.incomings.push_back({block->getName(), NoValue});
+            }
+        }
+    }
+    for (size_t b = 0; b < domTree.getNumBlocks(); ++b) {
+        size_t position = 0;
+        for (size_t p = 0; p < phis.size(); ++p) {
+            if (phis[p].block != b || !live[p]) continue;
+            auto phi = std::make_unique<PhiInst>(phiValue[p], allocaTypes[phis[p].candidate]);
+            for (const auto& incoming : phis[p].incomings) {
+                phi->addIncoming(incoming.block, incoming.value == NoValue ? NoValue : finalValue(incoming.value));
+            }
+            domTree.getBlock(b)->insertInstruction(position++, std::move(phi));
+        }
+    }
+    return promoted;
+}
+
+unsigned promoteAllocas(MIRModule& module) {
+    unsigned promoted = 0;
+    for (const auto& func : module.getFunctions()) {
+        promoted += promoteAllocas(*func, module);
+    }
+    return promoted;
+}
+
+} // namespace chtholly
@@ -0,0 +1,56 @@
+#include "MIR/PassManager.h"
+#include "MIR/ValueTypes.h"
+#include "PhaseTimer.h"
+
+namespace chtholly {
+
+const DominatorTree& FunctionAnalyses::getDominatorTree() {
+    if (!domTree) domTree = std::make_unique<DominatorTree>(func);
+    return *domTree;
+}
+
+const std::vector<std::shared_ptr<Type>>& FunctionAnalyses::getValueTypes() {
+    if (!valueTypes) valueTypes = inferValueTypes(func, module, getDominatorTree());
+    return *valueTypes;
+}
+
+void FunctionAnalyses::invalidate(bool cfgChanged) {
+    valueTypes.reset();
+    if (cfgChanged) domTree.reset();
+}
+
+bool PassManager::shouldPrintAfter(const FunctionPass& pass) const {
+    return printAfterPasses.count("all") || printAfterPasses.count(pass.getName());
+}
+
+bool PassManager::shouldReport(const FunctionPass& pass) const {
+    return remarkPasses.count("all") || remarkPasses.count(pass.getName());
+}
+
+bool PassManager::run(MIRModule& module) {
+    bool changed = false;
+    for (const auto& pass : passes) {
+        pass->setRemarkStream(shouldReport(*pass) ? printStream : nullptr);
+    }
+    CallGraph callGraph(module);
+    for (const auto& scc : callGraph.getSCCs()) {
+        for (FunctionID id : scc) {
+            MIRFunction* func = module.getFunction(id);
+            if (!func || func->getBlocks().empty()) continue;
+            FunctionAnalyses analyses(*func, module, callGraph);
+            for (const auto& pass : passes) {
+                PhaseTimer timer(pass->getName(), func->getName());
+                if (pass->run(*func, analyses)) {
+                    analyses.invalidate(pass->changesCFG());
+                    changed = true;
+                }
+                if (shouldPrintAfter(*pass)) {
+                    *printStream << "*** MIR after " << pass->getName() << " on " << func->getName() << " ***\n" << func->toString();
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+} // namespace chtholly
@@ -0,0 +1,768 @@
+#include "MIR/Passes.h"
+#include "MIR/EscapeAnalysis.h"
+#include "MIR/Inliner.h"
+#include "MIR/Mem2Reg.h"
+#include "MIR/ValueTypes.h"
+#include <climits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace chtholly {
+
+namespace {
+
+// The instruction defining each value; null for parameters
+std::vector<MIRInstruction*> definitions(const MIRFunction& func) {
+    std::vector<MIRInstruction*> defs(func.getNumValues(), nullptr);
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getResult() != NoValue) defs[inst->getResult()] = inst.get();
+        }
+    }
+    return defs;
+}
+
+bool isKind(const MIRInstruction* inst, MIRInstructionKind kind) {
+    return inst && inst->getKind() == kind;
+}
+
+// Codegen emits every integer constant as an i32
+std::optional<int64_t> intConstant(const std::vector<MIRInstruction*>& defs, ValueID value) {
+    if (!isKind(defs[value], MIRInstructionKind::ConstInt)) return std::nullopt;
+    return static_cast<int32_t>(static_cast<const ConstIntInst*>(defs[value])->getValue());
+}
+
+void removePhiEdge(BasicBlock& target, const std::string& from) {
+    for (const auto& inst : target.getInstructions()) {
+        if (inst->getKind() != MIRInstructionKind::Phi) break;
+        static_cast<PhiInst&>(*inst).removeIncoming(from);
+    }
+}
+
+std::unique_ptr<MIRInstruction> makeInt(ValueID dest, uint32_t value) {
+    return std::make_unique<ConstIntInst>(dest, static_cast<int32_t>(value));
+}
+
+std::unique_ptr<MIRInstruction> makeBool(ValueID dest, bool value) {
+    return std::make_unique<ConstBoolInst>(dest, value);
+}
+
+std::unique_ptr<MIRInstruction> foldInts(ValueID dest, TokenType op, int32_t l, int32_t r) {
+    uint32_t a = static_cast<uint32_t>(l), b = static_cast<uint32_t>(r);
+    switch (op) {
+        case TokenType::Plus: return makeInt(dest, a + b);
+        case TokenType::Minus: return makeInt(dest, a - b);
+        case TokenType::Star: return makeInt(dest, a * b);
+        case TokenType::Slash:
+            if (r == 0 || (l == INT32_MIN && r == -1)) return nullptr;
+            return makeInt(dest, static_cast<uint32_t>(l / r));
+        case TokenType::Percent:
+            if (r == 0 || (l == INT32_MIN && r == -1)) return nullptr;
+            return makeInt(dest, static_cast<uint32_t>(l % r));
+        case TokenType::ShiftLeft:
+            if (r < 0 || r >= 32) return nullptr;
+            return makeInt(dest, a << r);
+        case TokenType::ShiftRight:
+            if (r < 0 || r >= 32) return nullptr;
+            return makeInt(dest, static_cast<uint32_t>(l >> r));
+        case TokenType::Ampersand: return makeInt(dest, a & b);
+        case TokenType::Pipe: return makeInt(dest, a | b);
+        case TokenType::Caret: return makeInt(dest, a ^ b);
+        case TokenType::EqualEqual: return makeBool(dest, l == r);
+        case TokenType::NotEqual: return makeBool(dest, l != r);
+        case TokenType::Less: return makeBool(dest, l < r);
+        case TokenType::LessEqual: return makeBool(dest, l <= r);
+        case TokenType::Greater: return makeBool(dest, l > r);
+        case TokenType::GreaterEqual: return makeBool(dest, l >= r);
+        default: return nullptr;
+    }
+}
+
+std::unique_ptr<MIRInstruction> foldBools(ValueID dest, TokenType op, bool l, bool r) {
+    switch (op) {
+        case TokenType::EqualEqual: return makeBool(dest, l == r);
+        case TokenType::NotEqual:
+        case TokenType::Caret: return makeBool(dest, l != r);
+        case TokenType::Ampersand: return makeBool(dest, l && r);
+        case TokenType::Pipe: return makeBool(dest, l || r);
+        default: return nullptr;
+    }
+}
+
+// Instructions that only compute their result; unused, they can go
+bool isPure(const MIRInstruction& inst) {
+    switch (inst.getKind()) {
+        case MIRInstructionKind::ConstInt:
+        case MIRInstructionKind::ConstBool:
+        case MIRInstructionKind::ConstString:
+        case MIRInstructionKind::ConstDouble:
+        case MIRInstructionKind::UnaryOp:
+        case MIRInstructionKind::BinOp:
+        case MIRInstructionKind::Load:
+        case MIRInstructionKind::StructElementPtr:
+        case MIRInstructionKind::ArrayElementPtr:
+        case MIRInstructionKind::Sizeof:
+        case MIRInstructionKind::Alignof:
+        case MIRInstructionKind::Offsetof:
+        case MIRInstructionKind::VariantTag:
+        case MIRInstructionKind::VariantExtract:
+        case MIRInstructionKind::Phi:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Bytes the type needs at the least, padding aside; nullopt when the MIR cannot tell
+std::optional<uint64_t> minimumSize(const Type& type) {
+    switch (type.getKind()) {
+        case TypeKind::I8:
+        case TypeKind::U8:
+        case TypeKind::Bool:
+            return 1;
+        case TypeKind::I16:
+        case TypeKind::U16:
+            return 2;
+        case TypeKind::I32:
+        case TypeKind::U32:
+        case TypeKind::F32:
+            return 4;
+        case TypeKind::I64:
+        case TypeKind::U64:
+        case TypeKind::F64:
+        case TypeKind::Pointer:
+            return 8;
+        case TypeKind::Array: {
+            auto& array = static_cast<const ArrayType&>(type);
+            auto element = minimumSize(*array.getBaseType());
+            if (!element || array.getSize() < 0) return std::nullopt;
+            return *element * static_cast<uint64_t>(array.getSize());
+        }
+        case TypeKind::Struct: {
+            auto& fields = static_cast<const StructType&>(type).getFields();
+            if (fields.empty()) return std::nullopt;
+            uint64_t total = 0;
+            for (const auto& field : fields) {
+                auto size = minimumSize(*field.type);
+                if (!size) return std::nullopt;
+                total += *size;
+            }
+            return total;
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+// Whether the block can run more than once per call
+bool inCycle(const DominatorTree& domTree, size_t index) {
+    std::vector<bool> seen(domTree.getNumBlocks(), false);
+    std::vector<size_t> stack(domTree.getSuccessors(index).begin(), domTree.getSuccessors(index).end());
+    while (!stack.empty()) {
+        size_t block = stack.back();
+        stack.pop_back();
+        if (block == index) return true;
+        if (seen[block]) continue;
+        seen[block] = true;
+        for (size_t succ : domTree.getSuccessors(block)) stack.push_back(succ);
+    }
+    return false;
+}
+
+std::string printedName(const MIRFunction& func, ValueID value) {
+    const std::string& name = func.getValueName(value);
+    return name.empty() ? "%" + std::to_string(value) : name;
+}
+
+// Largest value a variable of the type holds; the MIR's untyped integers are i32
+int64_t maxValueOf(const std::shared_ptr<Type>& type) {
+    switch (type ? type->getKind() : TypeKind::I32) {
+        case TypeKind::I8: return INT8_MAX;
+        case TypeKind::U8: return UINT8_MAX;
+        case TypeKind::I16: return INT16_MAX;
+        case TypeKind::U16: return UINT16_MAX;
+        case TypeKind::U32: return UINT32_MAX;
+        case TypeKind::I64:
+        case TypeKind::U64: return INT64_MAX;
+        default: return INT32_MAX;
+    }
+}
+
+// A loop as lowerForStmt leaves it after mem2reg: the header's phi `counter` starts at
+// `init`, arriving from `preheader`, and grows by a positive constant `step` on the
+// back edge; the header branches to `body`, which only it enters, while the counter
+// is below `bound`, or at most `bound` when `inclusive`
+struct CountedLoop {
+    size_t header;
+    size_t body;
+    size_t preheader;
+    ValueID counter;
+    ValueID init;
+    ValueID bound;
+    int64_t step;
+    bool inclusive;
+};
+
+std::vector<CountedLoop> findCountedLoops(const DominatorTree& domTree, const std::vector<MIRInstruction*>& defs) {
+    std::unordered_map<std::string, size_t> byName;
+    for (size_t b = 0; b < domTree.getNumBlocks(); ++b) {
+        byName.emplace(domTree.getBlock(b)->getName(), b);
+    }
+    auto constant = [&](ValueID value) { return intConstant(defs, value); };
+
+    std::vector<CountedLoop> loops;
+    for (size_t h = 0; h < domTree.getNumBlocks(); ++h) {
+        const auto& insts = domTree.getBlock(h)->getInstructions();
+        if (insts.empty() || insts.back()->getKind() != MIRInstructionKind::CondBr) continue;
+        auto& condBr = static_cast<const CondBrInst&>(*insts.back());
+        if (!isKind(defs[condBr.getCond()], MIRInstructionKind::BinOp)) continue;
+        auto& compare = static_cast<const BinOpInst&>(*defs[condBr.getCond()]);
+
+        CountedLoop loop{h, 0, 0, NoValue, NoValue, NoValue, 0, false};
+        switch (compare.getOp()) {
+            case TokenType::Less:
+            case TokenType::LessEqual:
+                loop.counter = compare.getLeft();
+                loop.bound = compare.getRight();
+                loop.inclusive = compare.getOp() == TokenType::LessEqual;
+                break;
+            case TokenType::Greater:
+            case TokenType::GreaterEqual:
+                loop.counter = compare.getRight();
+                loop.bound = compare.getLeft();
+                loop.inclusive = compare.getOp() == TokenType::GreaterEqual;
+                break;
+            default:
+                continue;
+        }
+        const MIRInstruction* phi = defs[loop.counter];
+        if (!isKind(phi, MIRInstructionKind::Phi) || phi->getParent() != domTree.getBlock(h)) continue;
+        auto body = byName.find(condBr.getThenLabel());
+        if (body == byName.end() || body->second == h || domTree.getPredecessors(body->second).size() != 1) continue;
+        loop.body = body->second;
+
+        const auto& incomings = static_cast<const PhiInst*>(phi)->getIncomings();
+        if (incomings.size() != 2) continue;
+        bool entered = false, stepped = false;
+        for (const auto& incoming : incomings) {
+            auto from = byName.find(incoming.block);
+            if (from == byName.end() || incoming.value == NoValue) break;
+            if (!domTree.dominates(h, from->second)) {
+                loop.init = incoming.value;
+                loop.preheader = from->second;
+                entered = true;
+                continue;
+            }
+            if (!isKind(defs[incoming.value], MIRInstructionKind::BinOp)) break;
+            auto& next = static_cast<const BinOpInst&>(*defs[incoming.value]);
+            if (next.getOp() != TokenType::Plus) break;
+            ValueID other = next.getLeft() == loop.counter ? next.getRight() : next.getRight() == loop.counter ? next.getLeft() : NoValue;
+            auto step = other == NoValue ? std::nullopt : constant(other);
+            if (!step || *step <= 0) break;
+            loop.step = *step;
+            stepped = true;
+        }
+        if (entered && stepped) loops.push_back(loop);
+    }
+    return loops;
+}
+
+// The blocks of the loop at `header`: those reaching one of its back edges without
+// passing the header. Also whether the header is the only way out
+struct LoopBlocks {
+    std::vector<bool> contains;
+    std::vector<size_t> latches;
+    bool singleExit = true;
+};
+
+LoopBlocks loopBlocks(const DominatorTree& domTree, size_t header) {
+    LoopBlocks loop;
+    loop.contains.assign(domTree.getNumBlocks(), false);
+    loop.contains[header] = true;
+    std::vector<size_t> stack;
+    for (size_t pred : domTree.getPredecessors(header)) {
+        if (!domTree.dominates(header, pred)) continue;
+        loop.latches.push_back(pred);
+        stack.push_back(pred);
+    }
+    while (!stack.empty()) {
+        size_t block = stack.back();
+        stack.pop_back();
+        if (loop.contains[block]) continue;
+        loop.contains[block] = true;
+        for (size_t pred : domTree.getPredecessors(block)) {
+            if (domTree.dominates(header, pred)) stack.push_back(pred);
+        }
+    }
+    for (size_t block = 0; block < domTree.getNumBlocks(); ++block) {
+        if (!loop.contains[block] || block == header) continue;
+        const auto& insts = domTree.getBlock(block)->getInstructions();
+        if (!insts.empty() && insts.back()->getKind() == MIRInstructionKind::Ret) loop.singleExit = false;
+        for (size_t succ : domTree.getSuccessors(block)) {
+            if (!loop.contains[succ]) loop.singleExit = false;
+        }
+    }
+    return loop;
+}
+
+} // namespace
+
+bool UnreachableBlockElim::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    std::vector<MIRInstruction*> defs = definitions(func);
+    std::unordered_map<std::string, BasicBlock*> byName;
+    for (const auto& block : func.getBlocks()) {
+        byName.emplace(block->getName(), block.get());
+    }
+
+    bool folded = false;
+    for (const auto& block : func.getBlocks()) {
+        const auto& insts = block->getInstructions();
+        if (insts.empty() || insts.back()->getKind() != MIRInstructionKind::CondBr) continue;
+        auto& condBr = static_cast<const CondBrInst&>(*insts.back());
+        const MIRInstruction* cond = defs[condBr.getCond()];
+        if (!isKind(cond, MIRInstructionKind::ConstBool)) continue;
+
+        bool taken = static_cast<const ConstBoolInst*>(cond)->getValue();
+        std::string target = taken ? condBr.getThenLabel() : condBr.getElseLabel();
+        std::string dropped = taken ? condBr.getElseLabel() : condBr.getThenLabel();
+        if (auto it = byName.find(dropped); it != byName.end()) removePhiEdge(*it->second, block->getName());
+        block->replaceInstruction(insts.size() - 1, std::make_unique<BrInst>(target));
+        folded = true;
+    }
+
+    std::optional<DominatorTree> rebuilt;
+    if (folded) rebuilt.emplace(func);
+    const DominatorTree& domTree = folded ? *rebuilt : analyses.getDominatorTree();
+
+    std::unordered_set<const BasicBlock*> unreachable;
+    for (const auto& block : func.getBlocks()) {
+        if (domTree.indexOf(block.get()) == DominatorTree::Unreachable) unreachable.insert(block.get());
+    }
+    for (const BasicBlock* block : unreachable) {
+        for (const auto& name : block->getSuccessorNames()) {
+            auto it = byName.find(name);
+            if (it != byName.end() && !unreachable.count(it->second)) removePhiEdge(*it->second, block->getName());
+        }
+    }
+    func.eraseBlocksIf([&](const BasicBlock& block) { return unreachable.count(&block) > 0; });
+    return folded || !unreachable.empty();
+}
+
+bool Inliner::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    const MIRModule& module = analyses.getModule();
+    const CallGraph& callGraph = analyses.getCallGraph();
+
+    // Only the calls written in this function; those copied in with a callee had their turn in it
+    std::vector<CallInst*> calls;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() == MIRInstructionKind::Call) calls.push_back(static_cast<CallInst*>(inst.get()));
+        }
+    }
+
+    unsigned callerCost = inlineCost(func);
+    bool changed = false;
+    for (CallInst* call : calls) {
+        const MIRFunction* callee = resolveCallee(module, *call);
+        if (!callee || callee == &func || callGraph.inSameSCC(func.getID(), callee->getID())) continue;
+        if (callee->getInlineHint() == InlineHint::Never) continue;
+        if (call->getArgs().size() != callee->getParameters().size() || !isInlinable(*callee)) continue;
+        unsigned cost = inlineCost(*callee);
+        if (callee->getInlineHint() != InlineHint::Always && (cost > threshold || callerCost + cost > MaxCallerCost)) continue;
+        inlineCall(func, *call, *callee);
+        callerCost += cost;
+        changed = true;
+    }
+    return changed;
+}
+
+bool HeapToStack::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    const DominatorTree& domTree = analyses.getDominatorTree();
+    std::unordered_set<const MIRInstruction*> removed;
+    std::vector<std::unique_ptr<MIRInstruction>> allocas;
+    auto whyKept = [&](const HeapAllocation& allocation) -> std::string {
+        if (!allocation.escape.empty()) return allocation.escape;
+        if (!allocation.stackType) return "size is not a constant";
+        size_t blockIndex = domTree.indexOf(allocation.call->getParent());
+        if (blockIndex == DominatorTree::Unreachable) return "never runs";
+        if (inCycle(domTree, blockIndex)) return "allocated in a loop";
+        auto size = minimumSize(*allocation.stackType);
+        if (!size || *size > MaxStackBytes) return "may be larger than " + std::to_string(MaxStackBytes) + " bytes";
+        return "";
+    };
+    for (const HeapAllocation& allocation : analyzeHeapAllocations(func)) {
+        std::string keptBecause = whyKept(allocation);
+        ValueID pointer = allocation.call->getDest();
+        if (remarks) {
+            *remarks << "remark: " << func.getName() << ": malloc " << printedName(func, pointer);
+            if (keptBecause.empty()) *remarks << " moved to the stack as " << allocation.stackType->toString() << "\n";
+            else *remarks << " kept on the heap: " << keptBecause << "\n";
+        }
+        if (!keptBecause.empty()) continue;
+
+        allocas.push_back(std::make_unique<AllocaInst>(pointer, allocation.stackType));
+        removed.insert(allocation.call);
+        removed.insert(allocation.frees.begin(), allocation.frees.end());
+    }
+    if (allocas.empty()) return false;
+
+    for (const auto& block : func.getBlocks()) {
+        block->eraseInstructionsIf([&](const MIRInstruction& inst) { return removed.count(&inst) > 0; });
+    }
+    BasicBlock& entry = *func.getBlocks().front();
+    for (size_t i = 0; i < allocas.size(); ++i) {
+        entry.insertInstruction(i, std::move(allocas[i]));
+    }
+    return true;
+}
+
+bool BoundsCheckElim::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    const DominatorTree& domTree = analyses.getDominatorTree();
+    const auto& types = analyses.getValueTypes();
+    std::vector<MIRInstruction*> defs = definitions(func);
+    auto constant = [&](ValueID value) { return intConstant(defs, value); };
+
+    std::vector<CountedLoop> loops = findCountedLoops(domTree, defs);
+    std::unordered_map<ValueID, const CountedLoop*> byCounter;
+    for (const CountedLoop& loop : loops) {
+        byCounter.emplace(loop.counter, &loop);
+    }
+    std::unordered_map<size_t, LoopBlocks> loopBlocksOf;
+
+    // An index that is a counter plus a constant, e.g. a[i + 1]
+    auto splitOffset = [&](ValueID index) -> std::pair<ValueID, int64_t> {
+        if (!isKind(defs[index], MIRInstructionKind::BinOp)) return {index, 0};
+        auto& binOp = static_cast<const BinOpInst&>(*defs[index]);
+        auto right = constant(binOp.getRight()), left = constant(binOp.getLeft());
+        if (binOp.getOp() == TokenType::Plus && right) return {binOp.getLeft(), *right};
+        if (binOp.getOp() == TokenType::Plus && left) return {binOp.getRight(), *left};
+        if (binOp.getOp() == TokenType::Minus && right) return {binOp.getLeft(), -*right};
+        return {index, 0};
+    };
+    // Every value the counter takes in the body, when the start and bound are constants
+    // and the step cannot wrap it around
+    auto counterRange = [&](const CountedLoop& loop) -> std::optional<std::pair<int64_t, int64_t>> {
+        auto first = constant(loop.init), bound = constant(loop.bound);
+        if (!first || !bound) return std::nullopt;
+        int64_t last = loop.inclusive ? *bound : *bound - 1;
+        if (last + loop.step > maxValueOf(types[loop.counter])) return std::nullopt;
+        return std::make_pair(*first, last);
+    };
+    auto whyNotHoisted = [&](const CountedLoop& loop, size_t block, int64_t offset) -> std::string {
+        if (offset != 0) return "index is offset from the loop counter";
+        if (loop.step != 1 || loop.inclusive) return "loop counter does not step by one up to its bound";
+        if (domTree.getSuccessors(loop.preheader).size() != 1) return "loop has no preheader";
+        const MIRInstruction* boundDef = defs[loop.bound];
+        if (boundDef && !isKind(boundDef, MIRInstructionKind::ConstInt) && !domTree.dominates(domTree.indexOf(boundDef->getParent()), loop.preheader)) {
+            return "loop bound is computed inside the loop";
+        }
+        auto it = loopBlocksOf.find(loop.header);
+        if (it == loopBlocksOf.end()) it = loopBlocksOf.emplace(loop.header, loopBlocks(domTree, loop.header)).first;
+        if (!it->second.singleExit) return "loop can be left early";
+        for (size_t latch : it->second.latches) {
+            if (!domTree.dominates(block, latch)) return "check does not run on every iteration";
+        }
+        return "";
+    };
+
+    std::unordered_set<const MIRInstruction*> removed;
+    // Range checks to put in front of loops, by loop header and array length
+    std::map<std::pair<size_t, int64_t>, const CountedLoop*> hoisted;
+    for (size_t b = 0; b < domTree.getNumBlocks(); ++b) {
+        for (const auto& inst : domTree.getBlock(b)->getInstructions()) {
+            if (inst->getKind() != MIRInstructionKind::BoundsCheck) continue;
+            auto& check = static_cast<const BoundsCheckInst&>(*inst);
+            if (check.getEnd() != NoValue) continue;
+            int64_t length = check.getLength();
+
+            bool kept = true;
+            std::string fate;
+            auto [counter, offset] = splitOffset(check.getIndex());
+            auto loop = byCounter.find(counter);
+            if (auto index = constant(check.getIndex())) {
+                kept = *index < 0 || *index >= length;
+                fate = kept ? "kept: constant index " + std::to_string(*index) + " is out of bounds" : "removed: constant index";
+            } else if (loop == byCounter.end() || !domTree.dominates(loop->second->body, b)) {
+                fate = "kept: index is not a loop counter";
+            } else if (auto range = counterRange(*loop->second);
+                       range && range->first + offset >= 0 && range->second + offset < length) {
+                kept = false;
+                fate = "removed: index stays within [" + std::to_string(range->first + offset) + ", " + std::to_string(range->second + offset) + "]";
+            } else if (!hoist) {
+                fate = range ? "kept: index reaches past the array" : "kept: loop start or bound is not a constant";
+            } else if (std::string why = whyNotHoisted(*loop->second, b, offset); !why.empty()) {
+                fate = "kept: " + why;
+            } else {
+                kept = false;
+                hoisted.emplace(std::make_pair(loop->second->header, length), loop->second);
+                fate = "hoisted in front of loop " + domTree.getBlock(loop->second->header)->getName();
+            }
+
+            if (remarks) *remarks << "remark: " << func.getName() << ": bounds check of " << printedName(func, check.getIndex()) << " against " << length << " " << fate << "\n";
+            if (!kept) removed.insert(inst.get());
+        }
+    }
+    if (removed.empty()) return false;
+
+    for (const auto& block : func.getBlocks()) {
+        block->eraseInstructionsIf([&](const MIRInstruction& inst) { return removed.count(&inst) > 0; });
+    }
+    // Each goes right before the preheader's branch into the loop, checking [init, bound)
+    for (const auto& [key, loop] : hoisted) {
+        BasicBlock& preheader = *domTree.getBlock(loop->preheader);
+        size_t before = preheader.getInstructions().size() - 1;
+        ValueID end = loop->bound;
+        // A constant bound may be defined in the header; the preheader gets a copy of its own
+        if (auto bound = constant(end); bound && !domTree.dominates(domTree.indexOf(defs[end]->getParent()), loop->preheader)) {
+            end = func.createTemp();
+            preheader.insertInstruction(before++, std::make_unique<ConstIntInst>(end, *bound));
+        }
+        preheader.insertInstruction(before, std::make_unique<BoundsCheckInst>(loop->init, key.second, end));
+    }
+    return true;
+}
+
+bool Mem2Reg::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    return promoteAllocas(func, analyses.getDominatorTree(), analyses.getValueTypes()) > 0;
+}
+
+bool ConstantFolding::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    std::vector<MIRInstruction*> defs = definitions(func);
+    // Codegen emits every integer constant as an i32
+    auto intValue = [&](ValueID value) -> std::optional<int32_t> {
+        if (!isKind(defs[value], MIRInstructionKind::ConstInt)) return std::nullopt;
+        return static_cast<int32_t>(static_cast<const ConstIntInst*>(defs[value])->getValue());
+    };
+    auto boolValue = [&](ValueID value) -> std::optional<bool> {
+        if (!isKind(defs[value], MIRInstructionKind::ConstBool)) return std::nullopt;
+        return static_cast<const ConstBoolInst*>(defs[value])->getValue();
+    };
+
+    // Reverse post-order, so a folded operand is seen before the instructions using it
+    bool changed = false;
+    for (BasicBlock* block : emissionOrder(func, analyses.getDominatorTree())) {
+        const auto& insts = block->getInstructions();
+        for (size_t i = 0; i < insts.size(); ++i) {
+            std::unique_ptr<MIRInstruction> folded;
+            if (insts[i]->getKind() == MIRInstructionKind::BinOp) {
+                auto& binOp = static_cast<const BinOpInst&>(*insts[i]);
+                auto l = intValue(binOp.getLeft()), r = intValue(binOp.getRight());
+                if (l && r) folded = foldInts(binOp.getDest(), binOp.getOp(), *l, *r);
+                auto lb = boolValue(binOp.getLeft()), rb = boolValue(binOp.getRight());
+                if (lb && rb) folded = foldBools(binOp.getDest(), binOp.getOp(), *lb, *rb);
+            } else if (insts[i]->getKind() == MIRInstructionKind::UnaryOp) {
+                auto& unaryOp = static_cast<const UnaryOpInst&>(*insts[i]);
+                TokenType op = unaryOp.getOp();
+                if (auto v = intValue(unaryOp.getOperand())) {
+                    uint32_t bits = static_cast<uint32_t>(*v);
+                    if (op == TokenType::Plus) folded = makeInt(unaryOp.getDest(), bits);
+                    else if (op == TokenType::Minus) folded = makeInt(unaryOp.getDest(), 0u - bits);
+                    else if (op == TokenType::Not || op == TokenType::Tilde) folded = makeInt(unaryOp.getDest(), ~bits);
+                } else if (auto b = boolValue(unaryOp.getOperand())) {
+                    if (op == TokenType::Plus) folded = makeBool(unaryOp.getDest(), *b);
+                    else if (op == TokenType::Not || op == TokenType::Tilde) folded = makeBool(unaryOp.getDest(), !*b);
+                }
+            }
+            if (!folded) continue;
+            ValueID dest = folded->getResult();
+            block->replaceInstruction(i, std::move(folded));
+            defs[dest] = insts[i].get();
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool CopyPropagation::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    const DominatorTree& domTree = analyses.getDominatorTree();
+    const auto& types = analyses.getValueTypes();
+    std::vector<MIRInstruction*> defs = definitions(func);
+    std::unordered_map<ValueID, ValueID> replacement;
+    auto resolve = [&](ValueID value) {
+        for (auto it = replacement.find(value); it != replacement.end(); it = replacement.find(value)) value = it->second;
+        return value;
+    };
+
+    // The alloca a pointer points into, or NoValue when it may point anywhere
+    auto rootAlloca = [&](ValueID ptr) {
+        while (isKind(defs[ptr], MIRInstructionKind::StructElementPtr)) ptr = resolve(static_cast<const StructElementPtrInst*>(defs[ptr])->getPtr());
+        return isKind(defs[ptr], MIRInstructionKind::Alloca) ? ptr : NoValue;
+    };
+    // Distinct allocas never overlap, nor do distinct fields of one struct
+    auto disjoint = [&](ValueID a, ValueID b) {
+        if (a == b) return false;
+        auto* fieldA = isKind(defs[a], MIRInstructionKind::StructElementPtr) ? static_cast<const StructElementPtrInst*>(defs[a]) : nullptr;
+        auto* fieldB = isKind(defs[b], MIRInstructionKind::StructElementPtr) ? static_cast<const StructElementPtrInst*>(defs[b]) : nullptr;
+        if (fieldA && fieldB && resolve(fieldA->getPtr()) == resolve(fieldB->getPtr())) return fieldA->getFieldName() != fieldB->getFieldName();
+        ValueID rootA = rootAlloca(a), rootB = rootAlloca(b);
+        return rootA != NoValue && rootB != NoValue && rootA != rootB;
+    };
+
+    // Constants and field addresses are shared down the dominator tree; remembered memory contents only within a block
+    std::map<std::pair<bool, int64_t>, ValueID> constants; // (is bool, value)
+    std::map<std::tuple<ValueID, std::string, std::string>, ValueID> fields; // (struct pointer, struct, field)
+    std::vector<std::vector<std::pair<bool, int64_t>>> definedConstants(domTree.getNumBlocks());
+    std::vector<std::vector<std::tuple<ValueID, std::string, std::string>>> definedFields(domTree.getNumBlocks());
+    std::vector<std::pair<size_t, bool>> walk = {{0, false}};
+    while (!walk.empty()) {
+        auto [b, leaving] = walk.back();
+        walk.pop_back();
+        if (leaving) {
+            for (const auto& key : definedConstants[b]) constants.erase(key);
+            for (const auto& key : definedFields[b]) fields.erase(key);
+            continue;
+        }
+        walk.push_back({b, true});
+
+        std::unordered_map<ValueID, ValueID> memory; // pointer -> value it holds
+        for (const auto& inst : domTree.getBlock(b)->getInstructions()) {
+            switch (inst->getKind()) {
+                case MIRInstructionKind::ConstInt:
+                case MIRInstructionKind::ConstBool: {
+                    bool isBool = inst->getKind() == MIRInstructionKind::ConstBool;
+                    int64_t value = isBool ? static_cast<const ConstBoolInst&>(*inst).getValue()
+                                           : static_cast<int32_t>(static_cast<const ConstIntInst&>(*inst).getValue());
+                    auto [it, inserted] = constants.emplace(std::make_pair(isBool, value), inst->getResult());
+                    if (inserted) definedConstants[b].push_back(it->first);
+                    else replacement[inst->getResult()] = it->second;
+                    break;
+                }
+                case MIRInstructionKind::StructElementPtr: {
+                    auto& sep = static_cast<const StructElementPtrInst&>(*inst);
+                    auto [it, inserted] = fields.emplace(std::make_tuple(resolve(sep.getPtr()), sep.getStructName(), sep.getFieldName()), sep.getDest());
+                    if (inserted) definedFields[b].push_back(it->first);
+                    else replacement[sep.getDest()] = it->second;
+                    break;
+                }
+                case MIRInstructionKind::UnaryOp: {
+                    auto& unaryOp = static_cast<const UnaryOpInst&>(*inst);
+                    if (unaryOp.getOp() == TokenType::Plus) replacement[unaryOp.getDest()] = resolve(unaryOp.getOperand());
+                    break;
+                }
+                case MIRInstructionKind::Phi: {
+                    auto& phi = static_cast<const PhiInst&>(*inst);
+                    ValueID same = NoValue;
+                    bool unique = true;
+                    for (const auto& incoming : phi.getIncomings()) {
+                        ValueID value = incoming.value == NoValue ? NoValue : resolve(incoming.value);
+                        if (value == phi.getDest()) continue;
+                        // An undefined edge means the value need not dominate the phi
+                        if (value == NoValue || (same != NoValue && value != same)) {
+                            unique = false;
+                            break;
+                        }
+                        same = value;
+                    }
+                    if (unique && same != NoValue && sameValueType(types[same], phi.getType())) replacement[phi.getDest()] = same;
+                    break;
+                }
+                case MIRInstructionKind::Load: {
+                    auto& load = static_cast<const LoadInst&>(*inst);
+                    ValueID ptr = resolve(load.getSrc());
+                    auto it = memory.find(ptr);
+                    if (it != memory.end()) replacement[load.getDest()] = it->second;
+                    else memory.emplace(ptr, load.getDest());
+                    break;
+                }
+                case MIRInstructionKind::Store: {
+                    auto& store = static_cast<const StoreInst&>(*inst);
+                    ValueID ptr = resolve(store.getDest());
+                    ValueID value = resolve(store.getSrc());
+                    std::erase_if(memory, [&](const auto& entry) { return !disjoint(entry.first, ptr); });
+                    // A load reads the pointer's type, so only a value of that type can stand in for it
+                    if (sameValueType(types[value], types[ptr])) memory[ptr] = value;
+                    break;
+                }
+                case MIRInstructionKind::Call:
+                case MIRInstructionKind::VariantData:
+                    memory.clear();
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        const auto& children = domTree.getChildren(b);
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            walk.push_back({*it, false});
+        }
+    }
+
+    if (replacement.empty()) return false;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            inst->forEachOperand([&](ValueID& operand) { operand = resolve(operand); });
+        }
+    }
+    return true;
+}
+
+bool DeadCodeElimination::run(MIRFunction& func, FunctionAnalyses& analyses) {
+    (void)analyses;
+    std::vector<MIRInstruction*> defs = definitions(func);
+    std::vector<unsigned> uses(func.getNumValues(), 0), storeUses(func.getNumValues(), 0);
+    std::unordered_map<ValueID, std::vector<MIRInstruction*>> storesTo;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            inst->forEachOperand([&](ValueID& operand) { uses[operand]++; });
+            if (inst->getKind() == MIRInstructionKind::Store) {
+                ValueID dest = static_cast<const StoreInst&>(*inst).getDest();
+                storeUses[dest]++;
+                storesTo[dest].push_back(inst.get());
+            }
+        }
+    }
+
+    std::unordered_set<const MIRInstruction*> dead;
+    std::vector<ValueID> worklist;
+    auto kill = [&](MIRInstruction* inst) {
+        if (!dead.insert(inst).second) return;
+        inst->forEachOperand([&](ValueID& operand) {
+            uses[operand]--;
+            worklist.push_back(operand);
+        });
+        if (inst->getKind() == MIRInstructionKind::Store) storeUses[static_cast<const StoreInst&>(*inst).getDest()]--;
+    };
+    for (ValueID value = 0; value < func.getNumValues(); ++value) {
+        worklist.push_back(value);
+    }
+    while (!worklist.empty()) {
+        ValueID value = worklist.back();
+        worklist.pop_back();
+        MIRInstruction* def = defs[value];
+        if (!def || dead.count(def)) continue;
+        if (isPure(*def) && uses[value] == 0) {
+            kill(def);
+        } else if (def->getKind() == MIRInstructionKind::Alloca && uses[value] == storeUses[value]) {
+            // Memory nothing reads: its stores go with it
+            for (MIRInstruction* store : storesTo[value]) kill(store);
+            kill(def);
+        }
+    }
+
+    if (dead.empty()) return false;
+    for (const auto& block : func.getBlocks()) {
+        block->eraseInstructionsIf([&](const MIRInstruction& inst) { return dead.count(&inst) > 0; });
+    }
+    return true;
+}
+
+void addDefaultPasses(PassManager& passManager, BoundsCheckMode boundsChecks) {
+    passManager.addPass(std::make_unique<UnreachableBlockElim>());
+    passManager.addPass(std::make_unique<Inliner>());
+    // After inlining, so pointers passed to small helpers can be seen not to escape
+    passManager.addPass(std::make_unique<HeapToStack>());
+    passManager.addPass(std::make_unique<Mem2Reg>());
+    passManager.addPass(std::make_unique<CopyPropagation>());
+    passManager.addPass(std::make_unique<ConstantFolding>());
+    // Folded branches leave blocks behind, and folded values repeat constants
+    passManager.addPass(std::make_unique<UnreachableBlockElim>());
+    passManager.addPass(std::make_unique<CopyPropagation>());
+    // Once counters are phis and constants are folded; dce then drops what removed checks used
+    if (boundsChecks != BoundsCheckMode::Off) passManager.addPass(std::make_unique<BoundsCheckElim>(boundsChecks == BoundsCheckMode::Hoisted));
+    passManager.addPass(std::make_unique<DeadCodeElimination>());
+}
+
+} // namespace chtholly
@@ -0,0 +1,99 @@
+#include "MIR/ValueTypes.h"
+
+namespace chtholly {
+
+namespace {
+
+bool isComparison(TokenType op) {
+    switch (op) {
+        case TokenType::EqualEqual:
+        case TokenType::NotEqual:
+        case TokenType::Less:
+        case TokenType::LessEqual:
+        case TokenType::Greater:
+        case TokenType::GreaterEqual:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+bool sameValueType(const std::shared_ptr<Type>& a, const std::shared_ptr<Type>& b) {
+    return a == b || (a && b && a->equals(*b));
+}
+
+std::vector<std::shared_ptr<Type>> inferValueTypes(const MIRFunction& func, const MIRModule& module, const DominatorTree& domTree) {
+    std::vector<std::shared_ptr<Type>> types(func.getNumValues());
+    for (ValueID id = 0; id < func.getNumValues(); ++id) {
+        types[id] = func.getValueType(id);
+    }
+    for (const BasicBlock* block : emissionOrder(func, domTree)) {
+        for (const auto& inst : block->getInstructions()) {
+            switch (inst->getKind()) {
+                case MIRInstructionKind::Alloca:
+                    types[inst->getResult()] = static_cast<const AllocaInst&>(*inst).getType();
+                    break;
+                case MIRInstructionKind::Load:
+                    types[inst->getResult()] = types[static_cast<const LoadInst&>(*inst).getSrc()];
+                    break;
+                case MIRInstructionKind::BinOp: {
+                    auto& binOp = static_cast<const BinOpInst&>(*inst);
+                    types[binOp.getDest()] = isComparison(binOp.getOp()) ? Type::getBool() : types[binOp.getLeft()];
+                    break;
+                }
+                case MIRInstructionKind::UnaryOp:
+                    types[inst->getResult()] = types[static_cast<const UnaryOpInst&>(*inst).getOperand()];
+                    break;
+                case MIRInstructionKind::Call: {
+                    auto& call = static_cast<const CallInst&>(*inst);
+                    if (call.getDest() == NoValue) break;
+                    const MIRFunction* callee = call.getCalleeID() != NoFunction ? module.getFunction(call.getCalleeID()) : module.getFunction(call.getCallee());
+                    if (callee) types[call.getDest()] = callee->getReturnType();
+                    break;
+                }
+                case MIRInstructionKind::ArrayElementPtr:
+                    types[inst->getResult()] = PointerType::get(static_cast<const ArrayElementPtrInst&>(*inst).getElementType());
+                    break;
+                case MIRInstructionKind::VariantExtract:
+                    types[inst->getResult()] = static_cast<const VariantExtractInst&>(*inst).getFieldType();
+                    break;
+                case MIRInstructionKind::VariantTag:
+                case MIRInstructionKind::ConstInt:
+                    types[inst->getResult()] = Type::getI32();
+                    break;
+                case MIRInstructionKind::Sizeof:
+                case MIRInstructionKind::Alignof:
+                case MIRInstructionKind::Offsetof:
+                    types[inst->getResult()] = Type::getI64();
+                    break;
+                case MIRInstructionKind::ConstBool:
+                    types[inst->getResult()] = Type::getBool();
+                    break;
+                case MIRInstructionKind::ConstString:
+                    types[inst->getResult()] = Type::getI8Ptr();
+                    break;
+                case MIRInstructionKind::ConstDouble:
+                    types[inst->getResult()] = Type::getF64();
+                    break;
+                case MIRInstructionKind::Phi:
+                    types[inst->getResult()] = static_cast<const PhiInst&>(*inst).getType();
+                    break;
+                case MIRInstructionKind::StructElementPtr: {
+                    // Typed by the field; an unknown struct leaves the pointer untyped, so nothing matches it
+                    auto& sep = static_cast<const StructElementPtrInst&>(*inst);
+                    auto structTy = std::dynamic_pointer_cast<StructType>(types[sep.getPtr()]);
+                    int field = structTy && structTy->getName() == sep.getStructName() ? structTy->findFieldIndex(sep.getFieldName()) : -1;
+                    types[sep.getDest()] = field >= 0 ? structTy->getFields()[field].type : nullptr;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+    return types;
+}
+
+} // namespace chtholly
@@ -4,8 +4,8 @@
 
 namespace chtholly {
 
-Parser::Parser(std::string_view source) : m_lexer(source) {
-    m_currentToken = m_lexer.nextToken();
+Parser::Parser(std::string_view source) : m_tokens(source) {
+    m_currentToken = m_tokens.token(0);
 }
 
 std::vector<std::unique_ptr<ASTNode>> Parser::parseProgram() {
@@ -17,7 +17,7 @@ std::vector<std::unique_ptr<ASTNode>> Parser::parseProgram() {
             isPublic = true;
         }
 
-        if (peek().type == TokenType::Fn || peek().type == TokenType::Extern) {
+        if (peek().type == TokenType::Fn || peek().type == TokenType::Extern || isInlineModifier(peek().type)) {
             nodes.push_back(parseFunctionDecl(isPublic));
         } else if (peek().type == TokenType::Struct) {
             nodes.push_back(parseStructDecl(isPublic));
@@ -44,7 +44,8 @@ std::vector<std::unique_ptr<ASTNode>> Parser::parseProgram() {
 
 Token Parser::advance() {
     Token old = m_currentToken;
-    m_currentToken = m_lexer.nextToken();
+    if (old.type != TokenType::EndOfFile) ++m_index;
+    m_currentToken = m_tokens.token(m_index);
     return old;
 }
 
@@ -52,6 +53,10 @@ Token Parser::peek() {
     return m_currentToken;
 }
 
+Token Parser::peekNext() {
+    return m_tokens.token(m_index + 1);
+}
+
 bool Parser::match(TokenType type) {
     if (m_currentToken.type == type) {
         advance();
@@ -103,7 +108,7 @@ std::shared_ptr<Type> Parser::parseType() {
 
     while (true) {
         if (match(TokenType::Star)) {
-            baseType = std::make_shared<PointerType>(baseType);
+            baseType = PointerType::get(baseType);
         } else if (peek().type == TokenType::LBracket) {
             if (isGenericContext()) {
                 match(TokenType::LBracket);
@@ -123,7 +128,7 @@ std::shared_ptr<Type> Parser::parseType() {
                 Token sizeToken = consume(TokenType::Integer, "Expected array size");
                 int size = std::stoi(std::string(sizeToken.value));
                 consume(TokenType::RBracket, "Expected ']'");
-                baseType = std::make_shared<ArrayType>(baseType, size);
+                baseType = ArrayType::get(baseType, size);
             }
         } else {
             break;
@@ -162,7 +167,7 @@ std::unique_ptr<Stmt> Parser::parseStatement() {
     if (peek().type == TokenType::Continue) {
         return parseContinueStmt();
     }
-    if (peek().type == TokenType::Fn || peek().type == TokenType::Extern) {
+    if (peek().type == TokenType::Fn || peek().type == TokenType::Extern || isInlineModifier(peek().type)) {
         return parseFunctionDecl(isPublic);
     }
     if (peek().type == TokenType::Struct) {
@@ -191,7 +196,7 @@ std::unique_ptr<Block> Parser::parseBlock() {
     consume(TokenType::LBrace, "Expected '{'");
     std::vector<std::unique_ptr<Stmt>> statements;
     while (!match(TokenType::RBrace)) {
-        if (m_lexer.peekToken().type == TokenType::EndOfFile) {
+        if (peekNext().type == TokenType::EndOfFile) {
             throw std::runtime_error("Unterminated block");
         }
         statements.push_back(parseStatement());
@@ -238,7 +243,14 @@ std::unique_ptr<VarDecl> Parser::parseStructField() {
     return std::make_unique<VarDecl>(name, type, nullptr, isMutable, isPublic);
 }
 
+InlineHint Parser::parseInlineHint() {
+    if (match(TokenType::Inline)) return InlineHint::Always;
+    if (match(TokenType::Noinline)) return InlineHint::Never;
+    return InlineHint::None;
+}
+
 std::unique_ptr<FunctionDecl> Parser::parseFunctionDecl(bool isPublic) {
+    InlineHint inlineHint = parseInlineHint();
     bool isExtern = match(TokenType::Extern);
     consume(TokenType::Fn, "Expected 'fn'");
     Token nameToken = consume(TokenType::Identifier, "Expected identifier");
@@ -274,6 +286,7 @@ std::unique_ptr<FunctionDecl> Parser::parseFunctionDecl(bool isPublic) {
     m_activeGenericParams.pop_back();
     auto decl = std::make_unique<FunctionDecl>(name, returnType, std::move(params), std::move(body), isExtern, isPublic, std::move(genericParams));
     decl->setVarArg(isVarArg);
+    decl->setInlineHint(inlineHint);
     return decl;
 }
 
@@ -374,7 +387,7 @@ std::unique_ptr<ClassDecl> Parser::parseClassDecl(bool isPublic) {
         bool memberPublic = match(TokenType::Pub);
         if (peek().type == TokenType::Let) {
             members.push_back(parseVarDecl(memberPublic));
-        } else if (peek().type == TokenType::Fn) {
+        } else if (peek().type == TokenType::Fn || isInlineModifier(peek().type)) {
             members.push_back(parseMethodDecl(memberPublic));
         } else if (peek().type == TokenType::Tilde) {
             members.push_back(parseMethodDecl(memberPublic));
@@ -411,6 +424,7 @@ std::unique_ptr<ConstructorDecl> Parser::parseConstructorDecl(bool isPublic) {
 }
 
 std::unique_ptr<MethodDecl> Parser::parseMethodDecl(bool isPublic) {
+    InlineHint inlineHint = parseInlineHint();
     match(TokenType::Fn); // Optional 'fn' prefix for destructors
     
     std::string name;
@@ -440,7 +454,7 @@ std::unique_ptr<MethodDecl> Parser::parseMethodDecl(bool isPublic) {
         
         // &self or &mut self
         auto selfType = std::make_shared<StructType>("Self", std::vector<StructType::Field>{});
-        auto ptrType = std::make_shared<PointerType>(selfType);
+        auto ptrType = PointerType::get(selfType);
         params.push_back(std::make_unique<Param>("self", ptrType));
         
         if (peek().type != TokenType::RParen) {
@@ -468,7 +482,9 @@ std::unique_ptr<MethodDecl> Parser::parseMethodDecl(bool isPublic) {
     }
 
     m_activeGenericParams.pop_back();
-    return std::make_unique<MethodDecl>(name, returnType, std::move(params), std::move(body), isPublic, std::move(genericParams));
+    auto decl = std::make_unique<MethodDecl>(name, returnType, std::move(params), std::move(body), isPublic, std::move(genericParams));
+    decl->setInlineHint(inlineHint);
+    return decl;
 }
 
 std::unique_ptr<StructLiteralExpr> Parser::parseStructLiteral(std::unique_ptr<Expr> base) {
@@ -809,7 +825,7 @@ std::unique_ptr<Expr> Parser::parsePostfix() {
             }
             left = std::make_unique<CallExpr>(std::move(left), std::move(args));
         } else if (peek().type == TokenType::LBracket) {
-            if (isGenericContext()) {
+            if (!isIndexStart()) {
                 match(TokenType::LBracket);
                 // It's a generic specialization
                 std::vector<std::shared_ptr<Type>> typeArgs;
@@ -1043,7 +1059,7 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
         }
         
         bool Parser::isGenericContext() {
-    Token next = m_lexer.peekToken();
+    Token next = peekNext();
     if (next.type == TokenType::I8 || next.type == TokenType::I16 || next.type == TokenType::I32 || next.type == TokenType::I64 ||
         next.type == TokenType::U8 || next.type == TokenType::U16 || next.type == TokenType::U32 || next.type == TokenType::U64 ||
         next.type == TokenType::F32 || next.type == TokenType::F64 || next.type == TokenType::Bool || next.type == TokenType::Void ||
@@ -1053,6 +1069,24 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
     return false;
 }
 
+bool Parser::isIndexStart() {
+    if (!isGenericContext()) return true;
+    Token name = peekNext();
+    if (name.type != TokenType::Identifier) return false;
+    // A lone name is a type argument when it is a generic parameter or a call,
+    // struct literal or path follows: add[T](x), Point[T] { ... }, Vec[Item]::new()
+    TokenType after = m_tokens.token(m_index + 2).type;
+    if (after == TokenType::RBracket) {
+        for (const auto& params : m_activeGenericParams) {
+            if (params.count(std::string(name.value))) return false;
+        }
+        TokenType follow = m_tokens.token(m_index + 3).type;
+        return follow != TokenType::LParen && follow != TokenType::LBrace && follow != TokenType::ColonColon;
+    }
+    // a[i + 1]; a type argument is followed by `]`, `,` or more of the type
+    return after == TokenType::Plus || after == TokenType::Minus || after == TokenType::Slash || after == TokenType::Percent;
+}
+
 std::vector<GenericParam> Parser::parseGenericParams() {
     std::vector<GenericParam> params;
     if (match(TokenType::LBracket)) {
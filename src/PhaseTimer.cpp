@@ -0,0 +1,98 @@
+#include "PhaseTimer.h"
+#include <llvm/Support/Error.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace chtholly {
+
+namespace {
+
+struct PhaseTotal {
+    std::string name;
+    double seconds = 0;
+    unsigned count = 0;
+};
+
+std::atomic<bool> reportEnabled{false};
+std::atomic<bool> traceEnabled{false};
+unsigned traceGranularity = 0;
+
+std::mutex totalsMutex;
+// Kept in first-seen order so the report reads like the pipeline
+std::vector<PhaseTotal> totals;
+
+} // namespace
+
+PhaseTimer::PhaseTimer(llvm::StringRef phase, llvm::StringRef detail)
+    : phase(phase), timed(reportEnabled), trace(phase, detail) {
+    if (timed) start = std::chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!timed) return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    for (auto& total : totals) {
+        if (total.name == phase) {
+            total.seconds += seconds;
+            total.count++;
+            return;
+        }
+    }
+    totals.push_back({phase.str(), seconds, 1});
+}
+
+void PhaseTimer::enableReport() {
+    reportEnabled = true;
+}
+
+void PhaseTimer::enableTrace(unsigned granularityUs) {
+    traceGranularity = granularityUs;
+    llvm::timeTraceProfilerInitialize(traceGranularity, "chtholly");
+    traceEnabled = true;
+}
+
+bool PhaseTimer::isTraceEnabled() {
+    return traceEnabled;
+}
+
+void PhaseTimer::beginThread() {
+    if (traceEnabled) llvm::timeTraceProfilerInitialize(traceGranularity, "chtholly");
+}
+
+void PhaseTimer::endThread() {
+    if (traceEnabled) llvm::timeTraceProfilerFinishThread();
+}
+
+void PhaseTimer::finish(const std::string& traceFile) {
+    if (reportEnabled) {
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        auto& os = llvm::errs();
+        os << "===-------------------------------------------------------------------------===\n";
+        os << "                          Chtholly compile time report\n";
+        os << "===-------------------------------------------------------------------------===\n";
+        os << "  Nested phases are included in their parents; worker threads are summed.\n\n";
+        os << "   Wall (ms)    Count  Phase\n";
+        for (const auto& total : totals) {
+            os << llvm::format("%12.3f %8u  ", total.seconds * 1000.0, total.count) << total.name << "\n";
+        }
+        os.flush();
+        // A long-lived compiler reports each build on its own
+        totals.clear();
+        reportEnabled = false;
+    }
+
+    if (traceEnabled) {
+        if (auto err = llvm::timeTraceProfilerWrite(traceFile, "chtholly.json")) {
+            llvm::errs() << "Could not write time trace: " << llvm::toString(std::move(err)) << "\n";
+        }
+        llvm::timeTraceProfilerCleanup();
+        traceEnabled = false;
+    }
+}
+
+} // namespace chtholly
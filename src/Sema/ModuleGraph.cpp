@@ -0,0 +1,422 @@
+#include "Sema/ModuleGraph.h"
+#include "Parser.h"
+#include "PhaseTimer.h"
+#include "SourceManager.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace chtholly {
+
+namespace {
+
+// Runs body(0..count-1) on up to `jobs` threads, the caller included, and rethrows the first failure by index
+void parallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& body) {
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> next{0};
+    auto drain = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                body(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min<size_t>(jobs, count); ++t) {
+        workers.emplace_back([&drain] {
+            PhaseTimer::beginThread();
+            drain();
+            PhaseTimer::endThread();
+        });
+    }
+    drain();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+std::vector<ModuleGraph::ImportRef> collectImports(const std::vector<std::unique_ptr<ASTNode>>& nodes) {
+    std::vector<ModuleGraph::ImportRef> refs;
+    for (const auto& node : nodes) {
+        if (node->getKind() != ASTNodeKind::ImportDecl) continue;
+        auto* import = static_cast<const ImportDecl*>(node.get());
+        if (!import->isStd) refs.push_back({import->path, importModuleName(*import)});
+    }
+    return refs;
+}
+
+std::string interfacePath(const std::string& dir, uint64_t sourceHash) {
+    return (std::filesystem::path(dir) / ModuleInterface::fileName(sourceHash)).string();
+}
+
+} // namespace
+
+std::string importModuleName(const ImportDecl& decl) {
+    if (!decl.alias.empty()) return decl.alias;
+    size_t lastSlash = decl.path.find_last_of("/\\");
+    std::string filename = (lastSlash == std::string::npos) ? decl.path : decl.path.substr(lastSlash + 1);
+    size_t dot = filename.find_last_of(".");
+    return (dot == std::string::npos) ? filename : filename.substr(0, dot);
+}
+
+void mangleModuleDecl(ASTNode* node, const std::string& moduleName) {
+    switch (node->getKind()) {
+        case ASTNodeKind::FunctionDecl:
+            static_cast<FunctionDecl*>(node)->setName(moduleName + "_" + static_cast<FunctionDecl*>(node)->getName());
+            break;
+        case ASTNodeKind::StructDecl:
+            static_cast<StructDecl*>(node)->setName(moduleName + "_" + static_cast<StructDecl*>(node)->getName());
+            break;
+        case ASTNodeKind::EnumDecl:
+            static_cast<EnumDecl*>(node)->setName(moduleName + "_" + static_cast<EnumDecl*>(node)->getName());
+            break;
+        case ASTNodeKind::ClassDecl:
+            static_cast<ClassDecl*>(node)->setName(moduleName + "_" + static_cast<ClassDecl*>(node)->getName());
+            break;
+        default:
+            break;
+    }
+}
+
+ModuleGraph::ModuleGraph(unsigned jobs) : jobs(std::max(1u, jobs)) {}
+
+ModuleGraph::~ModuleGraph() = default;
+
+ModuleGraph::Module* ModuleGraph::addModule(const std::string& path) {
+    auto it = byPath.find(path);
+    if (it != byPath.end()) return it->second;
+    modules.push_back(std::make_shared<Module>());
+    Module* module = modules.back().get();
+    module->path = path;
+    module->arena = std::make_unique<ASTArena>();
+    byPath.emplace(path, module);
+    return module;
+}
+
+// Records the importer's edges and returns the modules seen for the first time
+std::vector<ModuleGraph::Module*> ModuleGraph::linkImports(Module* importer, const std::vector<ImportRef>& refs) {
+    std::vector<Module*> discovered;
+    auto& edges = importer ? importer->imports : rootImports;
+    for (const auto& ref : refs) {
+        bool isNew = !byPath.count(ref.path);
+        Module* module = addModule(ref.path);
+        if (isNew) discovered.push_back(module);
+        if (std::find(edges.begin(), edges.end(), module) == edges.end()) edges.push_back(module);
+    }
+    return discovered;
+}
+
+void ModuleGraph::build(const std::vector<std::unique_ptr<ASTNode>>& program) {
+    std::vector<ImportRef> rootRefs = collectImports(program);
+    std::vector<Module*> batch = linkImports(nullptr, rootRefs);
+    while (!batch.empty()) {
+        parseAll(batch, true);
+        std::vector<Module*> next;
+        for (Module* module : batch) {
+            auto discovered = linkImports(module, module->importRefs);
+            next.insert(next.end(), discovered.begin(), discovered.end());
+        }
+        batch = std::move(next);
+    }
+    // An interface or cached module records its imports as written, so discovery is complete; only staleness is left
+    std::vector<Module*> stale = dropStaleInterfaces();
+    if (!stale.empty()) parseAll(stale, false);
+
+    // Name each module after the first import that reaches it depth-first, as sequential loading did
+    std::unordered_set<const Module*> named;
+    std::function<void(const std::vector<ImportRef>&)> nameImports = [&](const std::vector<ImportRef>& refs) {
+        for (const auto& ref : refs) {
+            Module* module = byPath.at(ref.path);
+            if (!named.insert(module).second) continue;
+            module->name = ref.name;
+            nameImports(module->importRefs);
+        }
+    };
+    nameImports(rootRefs);
+
+    // Names are part of what a cached module was analyzed under
+    stale = dropStaleCachedModules();
+    if (!stale.empty()) parseAll(stale, false);
+
+    analyzeAll();
+    if (cache) storeInCache();
+}
+
+// Without `reuse` every module is parsed, even when a cache or interface could stand in for it
+void ModuleGraph::parseAll(const std::vector<Module*>& batch, bool reuse) {
+    bool useInterfaces = reuse && declarationsOnly && !interfaceDir.empty();
+    // SourceManager is not thread-safe, so files are mapped here and only parsed on the workers.
+    // Without a compilation-wide manager the mappings only need to outlive the parses below
+    SourceManager localSources;
+    SourceManager& sources = SourceManager::current() ? *SourceManager::current() : localSources;
+    std::vector<std::string_view> texts;
+    for (Module* module : batch) {
+        std::optional<std::string_view> source = sources.load(module->path);
+        if (!source) {
+            throw std::runtime_error("Could not open imported file: " + module->path);
+        }
+        texts.push_back(*source);
+    }
+
+    parallelFor(batch.size(), jobs, [&](size_t i) {
+        Module& module = *batch[i];
+        if (!interfaceDir.empty() || cache) {
+            module.sourceHash = ModuleInterface::hashSource(texts[i]);
+            if (reuse && cache && takeCached(module)) return;
+            if (useInterfaces && loadInterface(module)) return;
+        }
+        ASTArena::Scope arenaScope(*module.arena);
+        PhaseTimer timer("Lex/Parse", module.path);
+        Parser parser(texts[i]);
+        module.nodes = parser.parseProgram();
+        module.importRefs = collectImports(module.nodes);
+    });
+}
+
+// Takes the interface written for exactly this source, if there is one
+bool ModuleGraph::loadInterface(Module& module) {
+    auto interface = ModuleInterface::read(interfacePath(interfaceDir, module.sourceHash));
+    if (!interface || interface->sourceHash != module.sourceHash) return false;
+    module.importRefs.clear();
+    for (const auto& import : interface->imports) {
+        module.importRefs.push_back({import.path, import.name});
+    }
+    module.interface = std::move(interface);
+    return true;
+}
+
+// Takes the module an earlier build analyzed from exactly this source, if the cache still has it
+bool ModuleGraph::takeCached(Module& module) {
+    auto it = cache->entries.find(module.path);
+    if (it == cache->entries.end() || it->second.module->sourceHash != module.sourceHash) return false;
+    module.cached = it->second.module;
+    module.importRefs = module.cached->importRefs;
+    return true;
+}
+
+// An interface stays only if each import still has the contents it was built against and keeps its own
+std::vector<ModuleGraph::Module*> ModuleGraph::dropStaleInterfaces() {
+    std::unordered_map<const Module*, bool> fresh;
+    std::function<bool(Module*)> isFresh = [&](Module* module) {
+        if (!module->interface) return false;
+        auto [it, inserted] = fresh.emplace(module, false);
+        if (!inserted) return it->second;
+        bool upToDate = true;
+        for (const auto& import : module->interface->imports) {
+            Module* dependency = byPath.at(import.path);
+            if (dependency->sourceHash != import.sourceHash || !isFresh(dependency)) {
+                upToDate = false;
+                break;
+            }
+        }
+        fresh[module] = upToDate;
+        return upToDate;
+    };
+
+    std::vector<Module*> stale;
+    for (const auto& module : modules) {
+        if (module->interface && !isFresh(module.get())) stale.push_back(module.get());
+    }
+    for (Module* module : stale) {
+        module->interface.reset();
+    }
+    return stale;
+}
+
+// A cached module stays only under the same name, with each import being the very module it was analyzed against
+std::vector<ModuleGraph::Module*> ModuleGraph::dropStaleCachedModules() {
+    std::unordered_map<const Module*, bool> fresh;
+    std::function<bool(Module*)> isFresh = [&](Module* module) {
+        if (!module->cached) return false;
+        auto [it, inserted] = fresh.emplace(module, false);
+        if (!inserted) return it->second;
+        const ModuleCache::Entry& entry = cache->entries.at(module->path);
+        bool upToDate = module->name == module->cached->name && module->imports.size() == entry.imports.size();
+        for (size_t i = 0; upToDate && i < module->imports.size(); ++i) {
+            Module* dependency = module->imports[i];
+            upToDate = isFresh(dependency) && dependency->cached == entry.imports[i];
+        }
+        fresh[module] = upToDate;
+        return upToDate;
+    };
+
+    std::vector<Module*> stale;
+    for (const auto& module : modules) {
+        if (module->cached && !isFresh(module.get())) stale.push_back(module.get());
+    }
+    for (Module* module : stale) {
+        module->cached.reset();
+    }
+    return stale;
+}
+
+void ModuleGraph::analyzeAll() {
+    std::unordered_map<const Module*, size_t> waitingOn;
+    std::unordered_map<const Module*, std::vector<Module*>> dependents;
+    std::deque<Module*> ready;
+    for (const auto& module : modules) {
+        waitingOn[module.get()] = module->imports.size();
+        for (Module* dependency : module->imports) {
+            dependents[dependency].push_back(module.get());
+        }
+        if (module->imports.empty()) ready.push_back(module.get());
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    size_t running = 0;
+    size_t finished = 0;
+    std::exception_ptr error;
+
+    // Each worker takes a module whose imports are all analyzed; finishing it may release its importers
+    auto work = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return !ready.empty() || running == 0 || error; });
+            if (error || ready.empty()) break;
+            Module* module = ready.front();
+            ready.pop_front();
+            running++;
+
+            lock.unlock();
+            std::exception_ptr failure;
+            try {
+                analyzeModule(*module);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            lock.lock();
+
+            running--;
+            if (failure) {
+                if (!error) error = failure;
+            } else {
+                finished++;
+                for (Module* dependent : dependents[module]) {
+                    if (--waitingOn[dependent] == 0) ready.push_back(dependent);
+                }
+            }
+            wake.notify_all();
+        }
+        wake.notify_all();
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min<size_t>(jobs, modules.size()); ++t) {
+        workers.emplace_back([&work] {
+            PhaseTimer::beginThread();
+            work();
+            PhaseTimer::endThread();
+        });
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (error) std::rethrow_exception(error);
+    if (finished < modules.size()) {
+        for (const auto& module : modules) {
+            if (!module->symbols) throw std::runtime_error("Import cycle involving " + module->path);
+        }
+    }
+}
+
+void ModuleGraph::analyzeModule(Module& module) {
+    if (module.cached) {
+        module.symbols = module.cached->symbols;
+        return;
+    }
+    ASTArena::Scope arenaScope(*module.arena);
+    if (module.interface) {
+        PhaseTimer timer("Load interface", module.path);
+        module.symbols = module.interface->toSymbolTable(module.nodes);
+        return;
+    }
+    PhaseTimer timer("Sema module", module.path);
+
+    module.sema = std::make_unique<Sema>();
+    module.sema->setModuleGraph(this);
+    for (auto& node : module.nodes) {
+        module.sema->analyze(node.get());
+    }
+    // Imports are resolved; a cached module outlives this graph
+    module.sema->setModuleGraph(nullptr);
+    // Written before mangling: interfaces hold the names as declared, like the symbol table
+    if (!interfaceDir.empty()) writeInterface(module);
+    // Importers analyzed later see the mangled names, as they did when modules were loaded inline
+    for (auto& node : module.nodes) {
+        mangleModuleDecl(node.get(), module.name);
+    }
+    module.symbols = std::make_shared<SymbolTable>(std::move(module.sema->getSymbolTable()));
+}
+
+void ModuleGraph::writeInterface(const Module& module) {
+    auto interface = ModuleInterface::fromSymbolTable(module.sourceHash, module.sema->getSymbolTable());
+    if (!interface) return; // the module is simply analyzed again next time
+    for (const auto& ref : module.importRefs) {
+        interface->imports.push_back({ref.path, ref.name, byPath.at(ref.path)->sourceHash});
+    }
+    // A cache that cannot be written only costs the next build its reuse
+    interface->write(interfacePath(interfaceDir, module.sourceHash));
+}
+
+// Keeps each module analyzed from source for later builds; one bound from an interface has no body to lower
+void ModuleGraph::storeInCache() {
+    std::unordered_map<const Module*, std::shared_ptr<const Module>> analyzed;
+    for (const auto& module : modules) {
+        if (module->interface) continue;
+        analyzed[module.get()] = module->cached ? module->cached : module;
+    }
+    for (const auto& module : modules) {
+        if (module->interface || module->cached) continue;
+        ModuleCache::Entry entry{module, {}};
+        for (Module* dependency : module->imports) {
+            auto it = analyzed.find(dependency);
+            if (it == analyzed.end()) break;
+            entry.imports.push_back(it->second);
+        }
+        if (entry.imports.size() == module->imports.size()) cache->entries[module->path] = std::move(entry);
+    }
+}
+
+const ModuleGraph::Module* ModuleGraph::find(const std::string& path) const {
+    auto it = byPath.find(path);
+    return it == byPath.end() ? nullptr : it->second;
+}
+
+void ModuleGraph::collectNodes(std::vector<ASTNode*>& nodes) const {
+    std::unordered_set<const Module*> visited;
+    std::function<void(const Module*)> visit = [&](const Module* module) {
+        if (!visited.insert(module).second) return;
+        for (const Module* dependency : module->imports) visit(dependency);
+
+        const Module& analyzed = module->cached ? *module->cached : *module;
+        if (analyzed.sema) {
+            for (const auto& node : analyzed.sema->getAnalyzedNodes()) {
+                nodes.push_back(node.get());
+            }
+        }
+        for (const auto& node : analyzed.nodes) {
+            nodes.push_back(node.get());
+        }
+    };
+    for (const Module* module : rootImports) visit(module);
+}
+
+} // namespace chtholly
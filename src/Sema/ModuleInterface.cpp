@@ -0,0 +1,467 @@
+#include "Sema/ModuleInterface.h"
+#include "AST/ASTArena.h"
+#include "AST/Declarations.h"
+#include "Parser.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace chtholly {
+
+namespace {
+
+constexpr char Magic[4] = {'C', 'N', 'S', 'I'};
+constexpr uint32_t Version = 1;
+
+// Type tags beyond the TypeKind values
+constexpr uint8_t NullTag = 0xFF;
+constexpr uint8_t NominalRefTag = 0xFE;
+
+// Generic declarations are instantiated by the importer, so their AST travels with the interface
+bool needsDecl(const ASTNode* decl, const std::shared_ptr<Type>& type) {
+    if (!decl) return false;
+    if (!type) return true;
+    switch (decl->getKind()) {
+        case ASTNodeKind::FunctionDecl: return !static_cast<const FunctionDecl*>(decl)->getGenericParams().empty();
+        case ASTNodeKind::StructDecl: return !static_cast<const StructDecl*>(decl)->getGenericParams().empty();
+        case ASTNodeKind::ClassDecl: return !static_cast<const ClassDecl*>(decl)->getGenericParams().empty();
+        case ASTNodeKind::EnumDecl: return !static_cast<const EnumDecl*>(decl)->getGenericParams().empty();
+        default: return false;
+    }
+}
+
+// Parses declaration source back into nodes; empty unless it yields exactly one node of `kind`
+std::unique_ptr<ASTNode> parseDecl(const std::string& text, ASTNodeKind kind) {
+    try {
+        Parser parser(text);
+        auto nodes = parser.parseProgram();
+        if (nodes.size() != 1 || nodes[0]->getKind() != kind) return nullptr;
+        return std::move(nodes[0]);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+class Writer {
+public:
+    void u8(uint8_t v) { out.push_back(static_cast<char>(v)); }
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) u8(static_cast<uint8_t>(v >> (i * 8)));
+    }
+    void u64(uint64_t v) {
+        for (int i = 0; i < 8; ++i) u8(static_cast<uint8_t>(v >> (i * 8)));
+    }
+    void str(const std::string& s) {
+        u32(static_cast<uint32_t>(s.size()));
+        out += s;
+    }
+
+    void type(const std::shared_ptr<Type>& t) {
+        if (!t) {
+            u8(NullTag);
+            return;
+        }
+        // Structs and enums can reach themselves through methods and pointers, so each is written once
+        if (t->isStruct() || t->isEnum()) {
+            auto it = nominal.find(t.get());
+            if (it != nominal.end()) {
+                u8(NominalRefTag);
+                u32(it->second);
+                return;
+            }
+            nominal.emplace(t.get(), static_cast<uint32_t>(nominal.size()));
+        }
+
+        u8(static_cast<uint8_t>(t->getKind()));
+        switch (t->getKind()) {
+            case TypeKind::Pointer:
+                type(std::static_pointer_cast<PointerType>(t)->getBaseType());
+                break;
+            case TypeKind::Array: {
+                auto array = std::static_pointer_cast<ArrayType>(t);
+                u32(static_cast<uint32_t>(array->getSize()));
+                type(array->getBaseType());
+                break;
+            }
+            case TypeKind::Function: {
+                auto fn = std::static_pointer_cast<FunctionType>(t);
+                u32(static_cast<uint32_t>(fn->getParamTypes().size()));
+                for (const auto& param : fn->getParamTypes()) type(param);
+                type(fn->getReturnType());
+                u8(fn->isVarArg());
+                break;
+            }
+            case TypeKind::Struct: {
+                auto st = std::static_pointer_cast<StructType>(t);
+                str(st->getName());
+                u8(st->isClass());
+                fields(st->getFields());
+                u32(static_cast<uint32_t>(st->getMethods().size()));
+                for (const auto& method : st->getMethods()) {
+                    str(method.name);
+                    type(method.type);
+                    u8(method.isPublic);
+                }
+                break;
+            }
+            case TypeKind::Enum: {
+                auto en = std::static_pointer_cast<EnumType>(t);
+                str(en->getName());
+                u32(static_cast<uint32_t>(en->getVariants().size()));
+                for (const auto& variant : en->getVariants()) {
+                    str(variant.name);
+                    u8(static_cast<uint8_t>(variant.kind));
+                    u32(static_cast<uint32_t>(variant.tupleTypes.size()));
+                    for (const auto& tuple : variant.tupleTypes) type(tuple);
+                    fields(variant.structFields);
+                }
+                break;
+            }
+            case TypeKind::TypeParameter: {
+                auto param = std::static_pointer_cast<TypeParameterType>(t);
+                str(param->getName());
+                str(param->getConstraintName());
+                break;
+            }
+            default:
+                break; // primitives are fully described by their tag
+        }
+    }
+
+    std::string out;
+
+private:
+    void fields(const std::vector<StructType::Field>& fs) {
+        u32(static_cast<uint32_t>(fs.size()));
+        for (const auto& field : fs) {
+            str(field.name);
+            type(field.type);
+            u8(field.isPublic);
+        }
+    }
+
+    std::unordered_map<const Type*, uint32_t> nominal;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data(data) {}
+
+    bool ok() const { return valid; }
+    bool atEnd() const { return pos == data.size(); }
+
+    uint8_t u8() {
+        if (pos >= data.size()) return fail();
+        return static_cast<uint8_t>(data[pos++]);
+    }
+    uint32_t u32() {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(u8()) << (i * 8);
+        return v;
+    }
+    uint64_t u64() {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(u8()) << (i * 8);
+        return v;
+    }
+    std::string str() {
+        uint32_t size = u32();
+        if (size > data.size() - pos) return fail(), std::string();
+        std::string s(data.substr(pos, size));
+        pos += size;
+        return s;
+    }
+    // Element counts are bounded by the bytes left, so a corrupt count cannot allocate unboundedly
+    uint32_t count() {
+        uint32_t n = u32();
+        if (n > data.size() - pos) return fail();
+        return n;
+    }
+
+    std::shared_ptr<Type> type() {
+        if (!valid) return nullptr;
+        uint8_t tag = u8();
+        if (tag == NullTag) return nullptr;
+        if (tag == NominalRefTag) {
+            uint32_t index = u32();
+            if (index >= nominal.size()) return fail(), nullptr;
+            if (nominal[index].type) return nominal[index].type;
+            // Still being read: refer to it by name, as Sema does for a struct inside its own fields
+            if (nominal[index].isEnum) return std::make_shared<EnumType>(nominal[index].name, std::vector<EnumType::Variant>{});
+            return std::make_shared<StructType>(nominal[index].name, std::vector<StructType::Field>{});
+        }
+
+        switch (static_cast<TypeKind>(tag)) {
+            case TypeKind::I8: return Type::getI8();
+            case TypeKind::I16: return Type::getI16();
+            case TypeKind::I32: return Type::getI32();
+            case TypeKind::I64: return Type::getI64();
+            case TypeKind::U8: return Type::getU8();
+            case TypeKind::U16: return Type::getU16();
+            case TypeKind::U32: return Type::getU32();
+            case TypeKind::U64: return Type::getU64();
+            case TypeKind::F32: return Type::getF32();
+            case TypeKind::F64: return Type::getF64();
+            case TypeKind::Bool: return Type::getBool();
+            case TypeKind::Void: return Type::getVoid();
+            case TypeKind::Pointer: {
+                auto base = type();
+                if (!base) return fail(), nullptr;
+                return PointerType::get(base);
+            }
+            case TypeKind::Array: {
+                int size = static_cast<int>(u32());
+                auto base = type();
+                if (!base) return fail(), nullptr;
+                return ArrayType::get(base, size);
+            }
+            case TypeKind::Function: {
+                std::vector<std::shared_ptr<Type>> params(count());
+                for (auto& param : params) {
+                    param = type();
+                    if (!param) return fail(), nullptr;
+                }
+                auto returnType = type();
+                bool isVariadic = u8() != 0;
+                if (!returnType) return fail(), nullptr;
+                return FunctionType::get(params, returnType, isVariadic);
+            }
+            case TypeKind::Struct: {
+                size_t index = beginNominal(str(), false);
+                bool isClass = u8() != 0;
+                auto fs = fields();
+                auto st = std::make_shared<StructType>(nominal[index].name, std::move(fs));
+                st->setInternalIsClass(isClass);
+                nominal[index].type = st;
+                // Methods take self by pointer, so they are read once the struct itself exists
+                std::vector<StructType::Method> methods(count());
+                for (auto& method : methods) {
+                    method.name = str();
+                    method.type = type();
+                    method.isPublic = u8() != 0;
+                }
+                st->setMethods(std::move(methods));
+                return st;
+            }
+            case TypeKind::Enum: {
+                size_t index = beginNominal(str(), true);
+                std::vector<EnumType::Variant> variants(count());
+                for (auto& variant : variants) {
+                    variant.name = str();
+                    uint8_t kind = u8();
+                    if (kind > static_cast<uint8_t>(EnumType::Variant::Kind::Struct)) return fail(), nullptr;
+                    variant.kind = static_cast<EnumType::Variant::Kind>(kind);
+                    variant.tupleTypes.resize(count());
+                    for (auto& tuple : variant.tupleTypes) tuple = type();
+                    variant.structFields = fields();
+                }
+                auto en = std::make_shared<EnumType>(nominal[index].name, std::move(variants));
+                nominal[index].type = en;
+                return en;
+            }
+            case TypeKind::TypeParameter: {
+                std::string name = str();
+                std::string constraint = str();
+                return std::make_shared<TypeParameterType>(name, constraint);
+            }
+            default:
+                return fail(), nullptr;
+        }
+    }
+
+private:
+    struct Nominal {
+        std::string name;
+        bool isEnum;
+        std::shared_ptr<Type> type;
+    };
+
+    uint32_t fail() {
+        valid = false;
+        pos = data.size();
+        return 0;
+    }
+
+    size_t beginNominal(std::string name, bool isEnum) {
+        nominal.push_back({std::move(name), isEnum, nullptr});
+        return nominal.size() - 1;
+    }
+
+    std::vector<StructType::Field> fields() {
+        std::vector<StructType::Field> fs(count());
+        for (auto& field : fs) {
+            field.name = str();
+            field.type = type();
+            field.isPublic = u8() != 0;
+        }
+        return fs;
+    }
+
+    std::string_view data;
+    size_t pos = 0;
+    bool valid = true;
+    std::vector<Nominal> nominal;
+};
+
+} // namespace
+
+uint64_t ModuleInterface::hashSource(std::string_view source) {
+    return llvm::xxHash64(llvm::StringRef(source.data(), source.size()));
+}
+
+std::string ModuleInterface::fileName(uint64_t sourceHash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.cnsi", static_cast<unsigned long long>(sourceHash));
+    return name;
+}
+
+std::optional<ModuleInterface> ModuleInterface::fromSymbolTable(uint64_t sourceHash, const SymbolTable& table) {
+    ModuleInterface interface;
+    interface.sourceHash = sourceHash;
+
+    // Round-trip each generic declaration now, so a bad print fails the write rather than a later import
+    ASTArena scratch;
+    ASTArena::Scope scratchScope(scratch);
+    auto addDecl = [&](const ASTNode* decl) -> int32_t {
+        std::string text = decl->toString();
+        if (!parseDecl(text, decl->getKind())) return -2;
+        interface.genericDecls.push_back(std::move(text));
+        return static_cast<int32_t>(interface.genericDecls.size() - 1);
+    };
+
+    for (const auto& [name, symbol] : table.getPublicSymbols()) {
+        Entry entry{name, symbol->type, symbol->isMutable};
+        if (needsDecl(symbol->decl, symbol->type) && (entry.decl = addDecl(symbol->decl)) < 0) return std::nullopt;
+        interface.symbols.push_back(std::move(entry));
+    }
+    for (const auto& [name, type] : table.getPublicTypes()) {
+        Entry entry{name, type};
+        ASTNode* decl = table.lookupTypeDecl(name);
+        if (needsDecl(decl, type) && (entry.decl = addDecl(decl)) < 0) return std::nullopt;
+        interface.types.push_back(std::move(entry));
+    }
+
+    // The tables are hashed, so sort for byte-identical files from identical modules
+    auto byName = [](const Entry& a, const Entry& b) { return a.name < b.name; };
+    std::sort(interface.symbols.begin(), interface.symbols.end(), byName);
+    std::sort(interface.types.begin(), interface.types.end(), byName);
+    return interface;
+}
+
+std::shared_ptr<SymbolTable> ModuleInterface::toSymbolTable(std::vector<std::unique_ptr<ASTNode>>& decls) const {
+    std::vector<ASTNode*> parsed;
+    for (const auto& text : genericDecls) {
+        Parser parser(text);
+        auto nodes = parser.parseProgram();
+        if (nodes.size() != 1) throw std::runtime_error("Malformed generic declaration in module interface");
+        parsed.push_back(nodes[0].get());
+        decls.push_back(std::move(nodes[0]));
+    }
+    auto declAt = [&](int32_t index) { return index < 0 ? nullptr : parsed.at(index); };
+
+    auto table = std::make_shared<SymbolTable>();
+    for (const auto& entry : symbols) {
+        table->insertGlobal(entry.name, entry.type, entry.isMutable, true, declAt(entry.decl));
+    }
+    for (const auto& entry : types) {
+        table->insertTypeGlobal(entry.name, entry.type, true, declAt(entry.decl));
+    }
+    return table;
+}
+
+std::string ModuleInterface::serialize() const {
+    Writer w;
+    w.out.append(Magic, sizeof(Magic));
+    w.u32(Version);
+    w.u64(sourceHash);
+
+    w.u32(static_cast<uint32_t>(imports.size()));
+    for (const auto& import : imports) {
+        w.str(import.path);
+        w.str(import.name);
+        w.u64(import.sourceHash);
+    }
+    w.u32(static_cast<uint32_t>(genericDecls.size()));
+    for (const auto& decl : genericDecls) w.str(decl);
+
+    for (const auto* entries : {&symbols, &types}) {
+        w.u32(static_cast<uint32_t>(entries->size()));
+        for (const auto& entry : *entries) {
+            w.str(entry.name);
+            w.type(entry.type);
+            w.u8(entry.isMutable);
+            w.u32(static_cast<uint32_t>(entry.decl));
+        }
+    }
+    return std::move(w.out);
+}
+
+std::optional<ModuleInterface> ModuleInterface::deserialize(std::string_view data) {
+    if (data.size() < sizeof(Magic) || std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) return std::nullopt;
+    Reader r(data.substr(sizeof(Magic)));
+    if (r.u32() != Version) return std::nullopt;
+
+    ModuleInterface interface;
+    interface.sourceHash = r.u64();
+    interface.imports.resize(r.count());
+    for (auto& import : interface.imports) {
+        import.path = r.str();
+        import.name = r.str();
+        import.sourceHash = r.u64();
+    }
+    interface.genericDecls.resize(r.count());
+    for (auto& decl : interface.genericDecls) decl = r.str();
+
+    for (auto* entries : {&interface.symbols, &interface.types}) {
+        entries->resize(r.count());
+        for (auto& entry : *entries) {
+            entry.name = r.str();
+            entry.type = r.type();
+            entry.isMutable = r.u8() != 0;
+            entry.decl = static_cast<int32_t>(r.u32());
+            if (entry.decl < -1 || entry.decl >= static_cast<int32_t>(interface.genericDecls.size())) return std::nullopt;
+        }
+    }
+
+    if (!r.ok() || !r.atEnd()) return std::nullopt;
+    return interface;
+}
+
+bool ModuleInterface::write(const std::string& path) const {
+    std::error_code ec;
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) std::filesystem::create_directories(target.parent_path(), ec);
+
+    llvm::SmallString<128> tempPath;
+    if (llvm::sys::fs::createUniqueFile(path + "-%%%%%%%%.tmp", tempPath)) return false;
+    std::string data = serialize();
+    {
+        std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            std::filesystem::remove(tempPath.c_str(), ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath.c_str(), target, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath.c_str(), ec);
+        return false;
+    }
+    return true;
+}
+
+std::optional<ModuleInterface> ModuleInterface::read(const std::string& path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) return std::nullopt;
+    return deserialize(std::string_view((*buffer)->getBufferStart(), (*buffer)->getBufferSize()));
+}
+
+} // namespace chtholly
@@ -2,20 +2,35 @@
 #include "AST/Patterns.h"
 #include "AST/ImportDecl.h"
 #include "Parser.h"
+#include "PhaseTimer.h"
+#include "SourceManager.h"
+#include "Sema/ModuleGraph.h"
 #include <stdexcept>
 #include <iostream>
-#include <fstream>
 #include <sstream>
 
 namespace chtholly {
 
+namespace {
+
+// Built-in declarations, parsed once per process into an arena of their own; each Sema analyzes a copy
+const std::vector<std::unique_ptr<ASTNode>>& builtinDecls() {
+    static ASTArena arena;
+    static const std::vector<std::unique_ptr<ASTNode>> decls = [] {
+        ASTArena::Scope arenaScope(arena);
+        Parser parser("enum Result[T, E] { Ok(T), Err(E) }");
+        return parser.parseProgram();
+    }();
+    return decls;
+}
+
+} // namespace
+
 Sema::Sema() {
     // Inject built-in Result enum: enum Result[T, E] { Ok(T), Err(E) }
     if (!symbolTable.lookupType("Result")) {
-        std::string resultSource = "enum Result[T, E] { Ok(T), Err(E) }";
-        Parser parser(resultSource);
-        auto program = parser.parseProgram();
-        for (auto& node : program) {
+        for (const auto& builtin : builtinDecls()) {
+            auto node = builtin->clone();
             analyze(node.get());
             analyzedNodes.push_back(std::move(node));
         }
@@ -24,27 +39,25 @@ Sema::Sema() {
 
 std::shared_ptr<Type> Sema::resolveType(std::shared_ptr<Type> type) {
     if (!type) return nullptr;
-    std::string name = type->toString();
-    
-    // Fast path for primitives and common pointer types
-    if (name == "i8" || name == "i16" || name == "i32" || name == "i64" ||
-        name == "u8" || name == "u16" || name == "u32" || name == "u64" ||
-        name == "f32" || name == "f64" || name == "bool" || name == "void" || 
-        name == "i8*" || name == "i16*" || name == "i32*" || name == "i64*" ||
-        name == "u8*" || name == "u16*" || name == "u32*" || name == "u64*" ||
-        name == "f32*" || name == "f64*" || name == "bool*" || name == "char" || name == "char*") {
-        return type;
-    }
+
+    // Primitives are singletons and derived types are uniqued, so an unchanged component means an unchanged type
+    if (type->isPrimitive()) return type;
 
     if (type->isPointer()) {
         auto ptr = std::static_pointer_cast<PointerType>(type);
-        return std::make_shared<PointerType>(resolveType(ptr->getBaseType()));
+        auto base = resolveType(ptr->getBaseType());
+        if (base == ptr->getBaseType()) return type;
+        return PointerType::get(base);
     }
     if (type->isArray()) {
         auto arr = std::static_pointer_cast<ArrayType>(type);
-        return std::make_shared<ArrayType>(resolveType(arr->getBaseType()), arr->getSize());
+        auto base = resolveType(arr->getBaseType());
+        if (base == arr->getBaseType()) return type;
+        return ArrayType::get(base, arr->getSize());
     }
 
+    std::string name = type->toString();
+
     if (type->isStruct() || type->isEnum() || type->getKind() == TypeKind::TypeParameter) {
         // Only try to resolve if it looks like a generic specialization "Base[...]"
         size_t bracketPos = name.find('[');
@@ -90,7 +103,7 @@ std::shared_ptr<Type> Sema::resolveType(std::shared_ptr<Type> type) {
                     else if (arg == "i8*") argTy = Type::getI8Ptr();
                     else if (arg.back() == '*') {
                          std::string base = arg.substr(0, arg.size()-1);
-                         argTy = std::make_shared<PointerType>(resolveType(std::make_shared<StructType>(base, std::vector<StructType::Field>{})));
+                         argTy = PointerType::get(resolveType(std::make_shared<StructType>(base, std::vector<StructType::Field>{})));
                     } else {
                          argTy = resolveType(std::make_shared<StructType>(arg, std::vector<StructType::Field>{}));
                     }
@@ -490,13 +503,14 @@ void Sema::analyzeEnumDecl(EnumDecl* decl) {
 
 void Sema::analyzeFunctionDecl(FunctionDecl* decl) {
     if (!decl) return;
+    PhaseTimer timer("Sema function", decl->getName());
     std::vector<std::shared_ptr<Type>> paramTypes;
     for (const auto& param : decl->getParams()) {
         param->setType(resolveType(param->getType()));
         paramTypes.push_back(param->getType());
     }
     decl->setReturnType(resolveType(decl->getReturnType()));
-    auto funcType = std::make_shared<FunctionType>(std::move(paramTypes), decl->getReturnType(), decl->getVarArg());
+    auto funcType = FunctionType::get(std::move(paramTypes), decl->getReturnType(), decl->getVarArg());
     
     if (!symbolTable.insertGlobal(decl->getName(), funcType, false, decl->getIsPublic(), decl)) {
         // If it's already there and has the same type, it's fine (monomorphization cache)
@@ -623,7 +637,7 @@ std::shared_ptr<Type> Sema::checkArrayLiteral(ArrayLiteralExpr* expr) {
             throw std::runtime_error("Array literal elements must have the same type");
         }
     }
-    return std::make_shared<ArrayType>(baseType, (int)expr->getElements().size());
+    return ArrayType::get(baseType, (int)expr->getElements().size());
 }
 
 std::shared_ptr<Type> Sema::checkIndexing(IndexingExpr* expr) {
@@ -645,7 +659,7 @@ std::shared_ptr<Type> Sema::checkIndexing(IndexingExpr* expr) {
 
 std::shared_ptr<Type> Sema::checkAddressOf(AddressOfExpr* expr) {
     auto opType = checkExpr(const_cast<Expr*>(expr->getOperand()));
-    return std::make_shared<PointerType>(opType);
+    return PointerType::get(opType);
 }
 
 std::shared_ptr<Type> Sema::checkDereference(DereferenceExpr* expr) {
@@ -668,7 +682,7 @@ std::shared_ptr<Type> Sema::checkIntrinsic(IntrinsicExpr* expr) {
             return Type::getI64();
         case IntrinsicExpr::IntrinsicKind::Malloc:
         case IntrinsicExpr::IntrinsicKind::Alloca:
-            return std::make_shared<PointerType>(expr->getTypeArg());
+            return PointerType::get(expr->getTypeArg());
         case IntrinsicExpr::IntrinsicKind::Free:
             return Type::getVoid();
     }
@@ -682,7 +696,7 @@ std::shared_ptr<Type> Sema::checkLiteralExpr(LiteralExpr* expr) {
         if constexpr (std::is_same_v<T, bool>) return Type::getBool();
         else if constexpr (std::is_same_v<T, std::string>) return Type::getI8Ptr();
         else if constexpr (std::is_same_v<T, double>) return Type::getF64();
-        else if constexpr (std::is_same_v<T, std::nullptr_t>) return std::make_shared<PointerType>(Type::getVoid());
+        else if constexpr (std::is_same_v<T, std::nullptr_t>) return PointerType::get(Type::getVoid());
         else return Type::getI32();
     }, expr->getValue());
 }
@@ -1091,14 +1105,14 @@ void Sema::analyzeClassDecl(ClassDecl* decl) {
                      auto ptrType = std::static_pointer_cast<PointerType>(pType);
                      auto base = ptrType->getBaseType();
                      if (base->isStruct() && std::static_pointer_cast<StructType>(base)->getName() == "Self") {
-                         pType = std::make_shared<PointerType>(classType);
+                         pType = PointerType::get(classType);
                          p->setType(pType); // Update AST
                      }
                  }
                  paramTypes.push_back(pType);
              }
              method->setReturnType(resolveType(method->getReturnType()));
-             auto funcType = std::make_shared<FunctionType>(std::move(paramTypes), method->getReturnType());
+             auto funcType = FunctionType::get(std::move(paramTypes), method->getReturnType());
              methods.push_back({method->getName(), funcType, method->isPublic()});
              std::cout << "Added method " << method->getName() << " to class " << decl->getName() << std::endl;
         }
@@ -1171,7 +1185,7 @@ void Sema::analyzeConstructorDecl(ConstructorDecl* decl) {
     }
     
     // Add 'self' to constructor scope
-    auto selfType = std::make_shared<PointerType>(currentClass);
+    auto selfType = PointerType::get(currentClass);
     symbolTable.insert("self", selfType, false);
     
     if (decl->getBody()) {
@@ -1183,67 +1197,76 @@ void Sema::analyzeConstructorDecl(ConstructorDecl* decl) {
     currentFunction = oldFunc;
 }
 
+void Sema::adoptModules(const ModuleGraph& graph) {
+    setModuleGraph(&graph);
+    moduleNodes.clear();
+    graph.collectNodes(moduleNodes);
+}
+
+void Sema::moveNodesInto(std::vector<std::unique_ptr<ASTArena>>& arenas, std::vector<std::unique_ptr<ASTNode>>& nodes) {
+    for (auto& arena : moduleArenas) {
+        arenas.push_back(std::move(arena));
+    }
+    moduleArenas.clear();
+    for (auto& node : analyzedNodes) {
+        nodes.push_back(std::move(node));
+    }
+    analyzedNodes.clear();
+}
+
 void Sema::analyzeImportDecl(ImportDecl* decl) {
     if (decl->isStd) {
         return;
     }
 
     std::string filePath = decl->path;
-    if (loadedModules.count(filePath)) return;
-    loadedModules.insert(filePath);
+    std::string moduleName = importModuleName(*decl);
 
-    std::string moduleName;
-    if (!decl->alias.empty()) {
-        moduleName = decl->alias;
-    } else {
-        size_t lastSlash = filePath.find_last_of("/\\");
-        std::string filename = (lastSlash == std::string::npos) ? filePath : filePath.substr(lastSlash + 1);
-        size_t dot = filename.find_last_of(".");
-        moduleName = (dot == std::string::npos) ? filename : filename.substr(0, dot);
+    if (moduleGraph) {
+        const ModuleGraph::Module* module = moduleGraph->find(filePath);
+        if (!module || !module->symbols) {
+            throw std::runtime_error("Import was not loaded by the module graph: " + filePath);
+        }
+        modules[moduleName] = module->symbols;
+        return;
     }
 
+    if (loadedModules.count(filePath)) return;
+    loadedModules.insert(filePath);
 
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
+    // Without a compilation-wide manager the mapping only needs to outlive the parse
+    SourceManager localSources;
+    SourceManager& sources = SourceManager::current() ? *SourceManager::current() : localSources;
+    std::optional<std::string_view> source = sources.load(filePath);
+    if (!source) {
         throw std::runtime_error("Could not open imported file: " + filePath);
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
+    moduleArenas.push_back(std::make_unique<ASTArena>());
+    ASTArena::Scope arenaScope(*moduleArenas.back());
 
-    Parser parser(source);
-    auto nodes = parser.parseProgram();
+    std::vector<std::unique_ptr<ASTNode>> nodes;
+    {
+        PhaseTimer timer("Lex/Parse", filePath);
+        Parser parser(*source);
+        nodes = parser.parseProgram();
+    }
 
     Sema subSema;
     subSema.loadedModules = this->loadedModules;
-    for (auto& node : nodes) {
-        subSema.analyze(node.get());
+    {
+        PhaseTimer timer("Sema module", filePath);
+        for (auto& node : nodes) {
+            subSema.analyze(node.get());
+        }
     }
     this->loadedModules = subSema.loadedModules;
 
     // Collect all nodes from sub-analysis
-    for (auto& node : subSema.analyzedNodes) {
-        this->analyzedNodes.push_back(std::move(node));
-    }
+    subSema.moveNodesInto(this->moduleArenas, this->analyzedNodes);
     // Collect top-level nodes from this module and mangle their names
     for (auto& node : nodes) {
-        switch (node->getKind()) {
-            case ASTNodeKind::FunctionDecl:
-                static_cast<FunctionDecl*>(node.get())->setName(moduleName + "_" + static_cast<FunctionDecl*>(node.get())->getName());
-                break;
-            case ASTNodeKind::StructDecl:
-                static_cast<StructDecl*>(node.get())->setName(moduleName + "_" + static_cast<StructDecl*>(node.get())->getName());
-                break;
-            case ASTNodeKind::EnumDecl:
-                static_cast<EnumDecl*>(node.get())->setName(moduleName + "_" + static_cast<EnumDecl*>(node.get())->getName());
-                break;
-            case ASTNodeKind::ClassDecl:
-                static_cast<ClassDecl*>(node.get())->setName(moduleName + "_" + static_cast<ClassDecl*>(node.get())->getName());
-                break;
-            default:
-                break;
-        }
+        mangleModuleDecl(node.get(), moduleName);
         this->analyzedNodes.push_back(std::move(node));
     }
 
@@ -1324,6 +1347,8 @@ FunctionDecl* Sema::monomorphizeFunction(FunctionDecl* decl, const std::vector<s
         throw std::runtime_error("Generic argument count mismatch for function " + decl->getName());
     }
 
+    PhaseTimer timer("Monomorphize", mangledName);
+
     std::map<std::string, std::shared_ptr<Type>> mapping;
     for (size_t i = 0; i < decl->getGenericParams().size(); ++i) {
         mapping[decl->getGenericParams()[i].name] = typeArgs[i];
@@ -1362,6 +1387,8 @@ FunctionDecl* Sema::monomorphizeMethod(ClassDecl* clDecl, MethodDecl* method, co
         throw std::runtime_error("Generic argument count mismatch for method " + method->getName());
     }
 
+    PhaseTimer timer("Monomorphize", mangledName);
+
     std::map<std::string, std::shared_ptr<Type>> mapping;
     for (size_t i = 0; i < method->getGenericParams().size(); ++i) {
         mapping[method->getGenericParams()[i].name] = typeArgs[i];
@@ -1424,6 +1451,8 @@ std::shared_ptr<StructType> Sema::monomorphizeStruct(StructDecl* decl, const std
         throw std::runtime_error("Generic argument count mismatch for struct " + decl->getName());
     }
 
+    PhaseTimer timer("Monomorphize", mangledName);
+
     std::map<std::string, std::shared_ptr<Type>> mapping;
     for (size_t i = 0; i < decl->getGenericParams().size(); ++i) {
         mapping[decl->getGenericParams()[i].name] = typeArgs[i];
@@ -1463,6 +1492,8 @@ std::shared_ptr<StructType> Sema::monomorphizeClass(ClassDecl* decl, const std::
         throw std::runtime_error("Generic argument count mismatch for class " + decl->getName());
     }
 
+    PhaseTimer timer("Monomorphize", mangledName);
+
     std::map<std::string, std::shared_ptr<Type>> mapping;
     for (size_t i = 0; i < decl->getGenericParams().size(); ++i) {
         mapping[decl->getGenericParams()[i].name] = typeArgs[i];
@@ -1503,6 +1534,8 @@ std::shared_ptr<EnumType> Sema::monomorphizeEnum(EnumDecl* decl, const std::vect
         throw std::runtime_error("Generic argument count mismatch for enum " + decl->getName());
     }
 
+    PhaseTimer timer("Monomorphize", mangledName);
+
     std::map<std::string, std::shared_ptr<Type>> mapping;
     for (size_t i = 0; i < decl->getGenericParams().size(); ++i) {
         mapping[decl->getGenericParams()[i].name] = typeArgs[i];
@@ -1670,7 +1703,7 @@ void Sema::checkConstraint(const std::string& requestName, std::shared_ptr<Type>
              
              std::vector<std::shared_ptr<Type>> paramTypes;
              for(const auto& p : reqMethod->getParams()) paramTypes.push_back(p->getType());
-             auto reqFuncType = std::make_shared<FunctionType>(paramTypes, reqMethod->getReturnType());
+             auto reqFuncType = FunctionType::get(paramTypes, reqMethod->getReturnType());
              
              auto expectedType = reqFuncType->substitute(reqMapping);
              
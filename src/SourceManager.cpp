@@ -0,0 +1,41 @@
+#include "SourceManager.h"
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace chtholly {
+
+namespace {
+
+thread_local SourceManager* currentManager = nullptr;
+
+} // namespace
+
+SourceManager::SourceManager() = default;
+SourceManager::~SourceManager() = default;
+
+std::optional<std::string_view> SourceManager::load(const std::string& path) {
+    auto it = files.find(path);
+    if (it != files.end()) return it->second.text;
+
+    // LLVM maps the file when it is large enough to be worth it and reads it otherwise;
+    // the lexer never looks past the end, so no null terminator is needed
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) return std::nullopt;
+
+    std::string_view text((*buffer)->getBufferStart(), (*buffer)->getBufferSize());
+    files.emplace(path, File{std::move(*buffer), text});
+    return text;
+}
+
+SourceManager* SourceManager::current() {
+    return currentManager;
+}
+
+SourceManager::Scope::Scope(SourceManager& manager) : previous(currentManager) {
+    currentManager = &manager;
+}
+
+SourceManager::Scope::~Scope() {
+    currentManager = previous;
+}
+
+} // namespace chtholly
@@ -1,121 +1,385 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <filesystem>
+#include <thread>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/Target/TargetMachine.h>
 #include "Parser.h"
+#include "PhaseTimer.h"
+#include "SourceManager.h"
+#include "AST/ASTArena.h"
 #include "Sema/Sema.h"
+#include "Sema/ModuleGraph.h"
 #include "MIR/MIRBuilder.h"
+#include "MIR/Passes.h"
 #include "Backend/CodeGenerator.h"
+#include "Backend/ParallelCodeGen.h"
+#include "Backend/ObjectCache.h"
 #include "Backend/Linker.h"
+#include "Backend/JIT.h"
 
 using namespace chtholly;
 
-int main(int argc, char **argv)
+static const char *const usageOptions = "[-o <out_file>] [-O0|-O1|-O2|-O3] [-mcpu=<cpu|native>|-march=native] [-mattr=<+feat,-feat>] [-j<N>] [-ftime-report] [-ftime-trace[=<file>]] [-ftime-trace-granularity=<us>] [-fsyntax-only] [-fmodule-cache=<dir>] [-fobject-cache=<dir>] [-print-after=<pass>|-print-after-all] [-Rpass=<pass>] [--bounds-checks=off|on|hoisted] [-run]";
+
+struct CompileOptions
 {
-    if (argc < 2)
+    std::string sourcePath;
+    std::string outPath;
+    bool shouldRun = false;
+    OptLevel optLevel = OptLevel::O0;
+    std::string targetCPU;
+    std::string targetFeatures;
+    unsigned jobs = 1;
+    bool timeReport = false;
+    bool timeTrace = false;
+    std::string traceFile;
+    unsigned traceGranularity = 0;
+    bool syntaxOnly = false;
+    std::string moduleCache;
+    std::string objectCacheDir;
+    // MIR passes whose output is dumped to stderr; "all" for every pass
+    std::vector<std::string> printAfter;
+    // MIR passes that explain their decisions on stderr; "all" for every pass
+    std::vector<std::string> remarks;
+    BoundsCheckMode boundsChecks = BoundsCheckMode::On;
+};
+
+// What a --serve process keeps warm between requests
+struct ServerState
+{
+    ModuleCache modules;
+    // Keyed by resolved CPU, features and optimization level; only the single-module path shares one
+    std::map<std::string, std::shared_ptr<llvm::TargetMachine>> targetMachines;
+};
+
+// Links the emitted objects, one per codegen partition, into the final executable
+static int linkObjects(const std::vector<llvm::SmallVector<char, 0>> &objects, const std::string &outPath)
+{
+    std::string exePath = outPath;
+#ifdef _WIN32
+    if (!exePath.ends_with(".exe")) exePath += ".exe";
+#endif
+
+    PhaseTimer timer("Link", exePath);
+    Linker linker;
+    if (!linker.invoke(objects, exePath))
     {
-        std::cerr << "Usage: " << argv[0] << " <source_file> [-o <out_file>] [-run]" << std::endl;
+        std::cerr << "Linking failed." << std::endl;
         return 1;
     }
+    std::cout << "Successfully linked " << exePath << std::endl;
+    return 0;
+}
 
-    std::string sourcePath = argv[1];
-    std::string outPath;
-    bool shouldRun = false;
+// args[0] is the source file; the rest are options. Reports the first bad option and returns false
+static bool parseOptions(const std::vector<std::string> &args, CompileOptions &options)
+{
+    options.sourcePath = args[0];
 
-    for (int i = 2; i < argc; ++i)
+    for (size_t i = 1; i < args.size(); ++i)
     {
-        if (std::string(argv[i]) == "-o" && i + 1 < argc)
+        const std::string &arg = args[i];
+        if (arg == "-o" && i + 1 < args.size())
+        {
+            options.outPath = args[++i];
+        }
+        else if (arg == "-run")
+        {
+            options.shouldRun = true;
+        }
+        else if (arg == "-O0")
+        {
+            options.optLevel = OptLevel::O0;
+        }
+        else if (arg == "-O1")
+        {
+            options.optLevel = OptLevel::O1;
+        }
+        else if (arg == "-O2")
+        {
+            options.optLevel = OptLevel::O2;
+        }
+        else if (arg == "-O3")
+        {
+            options.optLevel = OptLevel::O3;
+        }
+        else if (arg.starts_with("-mcpu="))
+        {
+            options.targetCPU = arg.substr(6);
+        }
+        else if (arg == "-march=native")
+        {
+            options.targetCPU = "native";
+        }
+        else if (arg.starts_with("-march="))
+        {
+            // The target architecture always follows the host triple; only the CPU can be chosen
+            std::cerr << "Unsupported option " << arg << ": only -march=native is accepted, use -mcpu=<cpu> to pick a CPU" << std::endl;
+            return false;
+        }
+        else if (arg.starts_with("-mattr="))
+        {
+            options.targetFeatures = arg.substr(7);
+        }
+        else if (arg.starts_with("-j"))
+        {
+            std::string count = arg.substr(2);
+            if (count.empty() && i + 1 < args.size()) count = args[++i];
+            // -j0 uses every hardware thread
+            options.jobs = static_cast<unsigned>(std::strtoul(count.c_str(), nullptr, 10));
+            if (options.jobs == 0) options.jobs = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (arg == "-ftime-report")
+        {
+            options.timeReport = true;
+        }
+        else if (arg == "-ftime-trace")
+        {
+            options.timeTrace = true;
+        }
+        else if (arg.starts_with("-ftime-trace="))
+        {
+            options.timeTrace = true;
+            options.traceFile = arg.substr(13);
+        }
+        else if (arg.starts_with("-ftime-trace-granularity="))
+        {
+            options.traceGranularity = static_cast<unsigned>(std::strtoul(arg.c_str() + 25, nullptr, 10));
+        }
+        else if (arg == "-fsyntax-only")
         {
-            outPath = argv[++i];
+            options.syntaxOnly = true;
         }
-        else if (std::string(argv[i]) == "-run")
+        else if (arg.starts_with("-fmodule-cache="))
         {
-            shouldRun = true;
+            options.moduleCache = arg.substr(15);
+        }
+        else if (arg.starts_with("-fobject-cache="))
+        {
+            options.objectCacheDir = arg.substr(15);
+        }
+        else if (arg.starts_with("-print-after="))
+        {
+            options.printAfter.push_back(arg.substr(13));
+        }
+        else if (arg == "-print-after-all")
+        {
+            options.printAfter.push_back("all");
+        }
+        else if (arg.starts_with("-Rpass="))
+        {
+            options.remarks.push_back(arg.substr(7));
+        }
+        else if (arg.starts_with("--bounds-checks="))
+        {
+            std::string mode = arg.substr(16);
+            if (mode == "off") options.boundsChecks = BoundsCheckMode::Off;
+            else if (mode == "on") options.boundsChecks = BoundsCheckMode::On;
+            else if (mode == "hoisted") options.boundsChecks = BoundsCheckMode::Hoisted;
+            else
+            {
+                std::cerr << "Unsupported option " << arg << ": expected off, on or hoisted" << std::endl;
+                return false;
+            }
         }
     }
 
-    if (outPath.empty()) {
-        std::filesystem::path p(sourcePath);
-        outPath = p.stem().string() + ".exe";
+    if (options.outPath.empty()) {
+        std::filesystem::path p(options.sourcePath);
+#ifdef _WIN32
+        options.outPath = p.stem().string() + ".exe";
+#else
+        options.outPath = p.stem().string();
+#endif
     }
 
-    std::string objPath = outPath + ".obj";
-    if (outPath.ends_with(".obj")) {
-        objPath = outPath;
-    }
+    if (options.timeTrace && options.traceFile.empty()) options.traceFile = options.outPath + ".json";
+    return true;
+}
+
+// Compiles one program; a server passes its warm state, a one-shot run passes nullptr
+static int compile(const CompileOptions &options, ServerState *server)
+{
+    const std::string &sourcePath = options.sourcePath;
+    const std::string &outPath = options.outPath;
+    unsigned jobs = options.jobs;
 
-    std::ifstream file(sourcePath);
-    if (!file.is_open())
+    if (options.timeReport) PhaseTimer::enableReport();
+    if (options.timeTrace) PhaseTimer::enableTrace(options.traceGranularity);
+    // Runs on every exit path, after all phase timers in the try block have closed
+    auto reportTimes = llvm::make_scope_exit([&] { PhaseTimer::finish(options.traceFile); });
+
+    // Maps the main file and every import for the whole compilation; tokens point into the mappings
+    SourceManager sourceManager;
+    SourceManager::Scope sourceManagerScope(sourceManager);
+    std::optional<std::string_view> source = sourceManager.load(sourcePath);
+    if (!source)
     {
         std::cerr << "Could not open file: " << sourcePath << std::endl;
         return 1;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
+    // Owns every AST node of the main module; it must outlive the parser's and Sema's node lists
+    ASTArena astArena;
+    ASTArena::Scope astArenaScope(astArena);
+    // Interns the pointer, array and function types built while compiling this program
+    TypeContext typeContext;
+    TypeContext::Scope typeContextScope(typeContext);
 
     try
     {
-        Parser parser(source);
-        auto program = parser.parseProgram();
+        std::vector<std::unique_ptr<ASTNode>> program;
+        {
+            PhaseTimer timer("Lex/Parse", sourcePath);
+            Parser parser(*source);
+            program = parser.parseProgram();
+        }
+
+        // Parses and analyzes every imported module up front, -j of them at a time.
+        // -fsyntax-only lowers nothing, so unchanged imports can come from their cached interfaces;
+        // a server also reuses the imports it analyzed for earlier requests. Owns their nodes until lowering is done
+        ModuleGraph moduleGraph(jobs);
+        moduleGraph.setInterfaceDir(options.moduleCache);
+        moduleGraph.setDeclarationsOnly(options.syntaxOnly);
+        if (server) moduleGraph.setModuleCache(&server->modules);
+        moduleGraph.build(program);
 
         Sema sema;
-        for (auto const &node : program)
+        sema.adoptModules(moduleGraph);
         {
-            sema.analyze(node.get());
+            PhaseTimer timer("Sema module", sourcePath);
+            for (auto const &node : program)
+            {
+                sema.analyze(node.get());
+            }
         }
         std::cout << "Semantic analysis passed!" << std::endl;
+        if (options.syntaxOnly) return 0;
 
         MIRModule module;
-        MIRBuilder mirBuilder(module);
-
-        for (auto const &[name, table] : sema.getModules())
         {
-            mirBuilder.addModuleName(name);
-        }
+            PhaseTimer timer("MIR lowering");
+            MIRBuilder mirBuilder(module);
+            mirBuilder.setBoundsChecks(options.boundsChecks != BoundsCheckMode::Off);
 
-        // Lower nodes from specialized generics first (analyzedNodes)
-        for (auto const &node : sema.getAnalyzedNodes())
+            for (auto const &[name, table] : sema.getModules())
+            {
+                mirBuilder.addModuleName(name);
+            }
+
+            // Lower imported modules, then nodes from specialized generics (analyzedNodes)
+            for (ASTNode *node : sema.getModuleNodes())
+            {
+                mirBuilder.lower(node);
+            }
+
+            for (auto const &node : sema.getAnalyzedNodes())
+            {
+                mirBuilder.lower(node.get());
+            }
+
+            for (auto const &node : program)
+            {
+                mirBuilder.lower(node.get());
+            }
+        }
         {
-            mirBuilder.lower(node.get());
+            PhaseTimer timer("MIR optimization");
+            PassManager passManager;
+            addDefaultPasses(passManager, options.boundsChecks);
+            for (const std::string &pass : options.printAfter)
+            {
+                passManager.printAfter(pass);
+            }
+            for (const std::string &pass : options.remarks)
+            {
+                passManager.reportRemarks(pass);
+            }
+            passManager.run(module);
         }
+        std::cout << "MIR lowering successful!" << std::endl;
+
+        bool objectOutput = outPath.ends_with(".obj") || outPath.ends_with(".o");
 
-        for (auto const &node : program)
+        // Several partitions only pay off when a linker joins them; -run and -o <obj> need one module.
+        // -fobject-cache emits one object per function and recompiles only the changed ones
+        bool incremental = !options.objectCacheDir.empty();
+        if ((jobs > 1 || incremental) && !options.shouldRun && !objectOutput)
         {
-            mirBuilder.lower(node.get());
+            ObjectCache objectCache(options.objectCacheDir);
+            ParallelCodeGen parallel(module, jobs);
+            parallel.setOptLevel(options.optLevel);
+            parallel.setTargetCPU(options.targetCPU);
+            parallel.setTargetFeatures(options.targetFeatures);
+            if (incremental) parallel.setObjectCache(&objectCache);
+
+            std::vector<llvm::SmallVector<char, 0>> objects;
+            if (!parallel.emitObjects(objects))
+            {
+                std::cerr << "Object emission failed." << std::endl;
+                return 1;
+            }
+            if (incremental)
+            {
+                std::cout << "LLVM IR generation successful! (" << parallel.getNumReused() << " of " << parallel.getNumFunctions() << " functions reused)" << std::endl;
+            }
+            else
+            {
+                std::cout << "LLVM IR generation successful! (" << objects.size() << " partitions)" << std::endl;
+            }
+
+            return linkObjects(objects, outPath);
         }
-        std::cout << "MIR lowering successful!" << std::endl;
 
         CodeGenerator codegen(module);
+        codegen.setOptLevel(options.optLevel);
+        codegen.setTargetCPU(options.targetCPU);
+        codegen.setTargetFeatures(options.targetFeatures);
         codegen.generate();
         std::cout << "LLVM IR generation successful!" << std::endl;
 
-        codegen.emitObjectFile(objPath);
-        if (std::filesystem::exists(objPath))
+        // A server builds one target machine per setting and hands it to every later request
+        std::string targetKey;
+        if (server)
         {
-            std::cout << "Successfully emitted " << objPath << std::endl;
+            targetKey = codegen.resolveTargetCPU() + "|" + codegen.resolveTargetFeatures() + "|" + std::to_string(static_cast<int>(options.optLevel));
+            auto it = server->targetMachines.find(targetKey);
+            if (it != server->targetMachines.end()) codegen.setTargetMachine(it->second);
         }
+        auto keepTargetMachine = llvm::make_scope_exit([&] {
+            if (server && codegen.shareTargetMachine()) server->targetMachines.emplace(targetKey, codegen.shareTargetMachine());
+        });
 
-        // 4. Automated Linking
-        if (outPath.ends_with(".exe") || !outPath.ends_with(".obj")) {
-            std::string exePath = outPath;
-            if (!exePath.ends_with(".exe")) exePath += ".exe";
+        // -run compiles and executes main in-process; nothing is written to disk
+        if (options.shouldRun)
+        {
+            JIT jit;
+            return jit.runMain(codegen, sourcePath);
+        }
 
-            Linker linker;
-            if (linker.invoke(objPath, exePath)) {
-                std::cout << "Successfully linked " << exePath << std::endl;
-                
-                if (shouldRun) {
-                    std::cout << "Running " << exePath << "..." << std::endl;
-                    std::string runCmd = ".\\" + exePath;
-                    std::system(runCmd.c_str());
-                }
-            } else {
-                std::cerr << "Linking failed." << std::endl;
+        if (objectOutput)
+        {
+            if (!codegen.emitObjectFile(outPath))
+            {
+                std::cerr << "Object emission failed." << std::endl;
                 return 1;
             }
+            std::cout << "Successfully emitted " << outPath << std::endl;
+            return 0;
         }
+
+        std::vector<llvm::SmallVector<char, 0>> objects(1);
+        if (!codegen.emitObjectToBuffer(objects[0]))
+        {
+            std::cerr << "Object emission failed." << std::endl;
+            return 1;
+        }
+
+        return linkObjects(objects, outPath);
     }
     catch (const std::exception &e)
     {
@@ -124,4 +388,70 @@ int main(int argc, char **argv)
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Splits a request line into arguments at whitespace; double quotes group an argument containing spaces
+static std::vector<std::string> splitRequest(const std::string &line)
+{
+    std::vector<std::string> args;
+    std::string current;
+    bool inArg = false;
+    bool quoted = false;
+    for (char c : line)
+    {
+        if (c == '"')
+        {
+            quoted = !quoted;
+            inArg = true;
+        }
+        else if (!quoted && std::isspace(static_cast<unsigned char>(c)))
+        {
+            if (inArg) args.push_back(current);
+            current.clear();
+            inArg = false;
+        }
+        else
+        {
+            current += c;
+            inArg = true;
+        }
+    }
+    if (inArg) args.push_back(current);
+    return args;
+}
+
+// Reads one request per line from stdin, each the arguments of a one-shot run, and answers
+// with that run's output followed by "exit <code>". Imports whose contents are unchanged stay
+// analyzed between requests, as do target machines; the main file is always compiled afresh
+static int serve()
+{
+    ServerState server;
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        std::vector<std::string> args = splitRequest(line);
+        if (args.empty()) continue;
+
+        CompileOptions options;
+        int exitCode = parseOptions(args, options) ? compile(options, &server) : 1;
+        std::cerr.flush();
+        std::cout << "exit " << exitCode << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <source_file> " << usageOptions << std::endl;
+        std::cerr << "       " << argv[0] << " --serve    (one request per line on stdin: <source_file> [options])" << std::endl;
+        return 1;
+    }
+
+    if (std::string(argv[1]) == "--serve") return serve();
+
+    CompileOptions options;
+    if (!parseOptions(std::vector<std::string>(argv + 1, argv + argc), options)) return 1;
+    return compile(options, nullptr);
+}
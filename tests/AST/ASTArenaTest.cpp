@@ -0,0 +1,57 @@
+#include "AST/ASTArena.h"
+#include "Parser.h"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+using namespace chtholly;
+
+void testNodesComeFromArena() {
+    ASTArena arena;
+    std::vector<std::unique_ptr<ASTNode>> program;
+    {
+        ASTArena::Scope scope(arena);
+        Parser parser("fn add(a: i32, b: i32): i32 { return a + b; }");
+        program = parser.parseProgram();
+    }
+
+    assert(program.size() == 1);
+    assert(arena.getBytesAllocated() > 0);
+    assert(arena.getBytesReserved() >= arena.getBytesAllocated());
+
+    // Clones made outside the scope go to the heap and are independent of the arena
+    [[maybe_unused]] size_t before = arena.getBytesAllocated();
+    auto copy = program[0]->clone();
+    assert(arena.getBytesAllocated() == before);
+    assert(copy->toString() == program[0]->toString());
+
+    program.clear();
+    std::cout << "testNodesComeFromArena passed!" << std::endl;
+}
+
+void testNestedScopesAndLargeAllocations() {
+    ASTArena outer;
+    ASTArena inner;
+    ASTArena::Scope outerScope(outer);
+    assert(ASTArena::current() == &outer);
+    {
+        ASTArena::Scope innerScope(inner);
+        assert(ASTArena::current() == &inner);
+    }
+    assert(ASTArena::current() == &outer);
+
+    [[maybe_unused]] void* big = outer.allocate(1 << 20, 16);
+    assert(big != nullptr);
+    assert(reinterpret_cast<std::uintptr_t>(big) % 16 == 0);
+    [[maybe_unused]] void* small = outer.allocate(24, 8);
+    assert(reinterpret_cast<std::uintptr_t>(small) % 8 == 0);
+
+    std::cout << "testNestedScopesAndLargeAllocations passed!" << std::endl;
+}
+
+int main() {
+    testNodesComeFromArena();
+    testNestedScopesAndLargeAllocations();
+    assert(ASTArena::current() == nullptr);
+    return 0;
+}
@@ -42,6 +42,17 @@ void testArrayPointerParser() {
         assert(bin->getLeft()->getKind() == ASTNodeKind::IndexingExpr);
     }
 
+    // 3b. Indexing by a variable, unlike specializing a call or struct literal
+    {
+        std::string source = "let x = a[i]; let y = a[i + 1]; let z = add[T](x); let p = Point[T] { x: 1 };";
+        Parser parser(source);
+        for (auto expected : {ASTNodeKind::IndexingExpr, ASTNodeKind::IndexingExpr, ASTNodeKind::CallExpr, ASTNodeKind::StructLiteralExpr}) {
+            auto stmt = parser.parseStatement();
+            assert(stmt->getKind() == ASTNodeKind::VarDecl);
+            assert(static_cast<VarDecl*>(stmt.get())->getInitializer()->getKind() == expected);
+        }
+    }
+
     // 4. Unary & and *
     {
         std::string source = "let p = &x; let v = *p;";
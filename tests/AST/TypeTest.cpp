@@ -20,7 +20,68 @@ void testPrimitiveTypes() {
     std::cout << "testPrimitiveTypes passed!" << std::endl;
 }
 
+void testInternedTypes() {
+    TypeContext context;
+    TypeContext::Scope scope(context);
+
+    auto i32Ptr = PointerType::get(Type::getI32());
+    assert(i32Ptr == PointerType::get(Type::getI32()));
+    assert(i32Ptr != PointerType::get(Type::getI64()));
+    assert(Type::getI8Ptr() == PointerType::get(Type::getI8()));
+
+    auto arr = ArrayType::get(i32Ptr, 4);
+    assert(arr == ArrayType::get(PointerType::get(Type::getI32()), 4));
+    assert(arr != ArrayType::get(i32Ptr, 5));
+
+    auto fn = FunctionType::get({Type::getI32(), i32Ptr}, Type::getBool());
+    assert(fn == FunctionType::get({Type::getI32(), PointerType::get(Type::getI32())}, Type::getBool()));
+    assert(fn != FunctionType::get({Type::getI32(), i32Ptr}, Type::getBool(), true));
+
+    std::cout << "testInternedTypes passed!" << std::endl;
+}
+
+void testSubstituteKeepsUnchangedNodes() {
+    TypeContext context;
+    TypeContext::Scope scope(context);
+
+    auto t = std::make_shared<TypeParameterType>("T");
+    std::map<std::string, std::shared_ptr<Type>> mapping = {{"T", Type::getI32()}};
+
+    auto concrete = FunctionType::get({PointerType::get(Type::getI64())}, Type::getVoid());
+    assert(concrete->substitute(mapping) == concrete);
+
+    auto generic = FunctionType::get({PointerType::get(t)}, t);
+    auto substituted = generic->substitute(mapping);
+    assert(substituted == FunctionType::get({PointerType::get(Type::getI32())}, Type::getI32()));
+
+    std::cout << "testSubstituteKeepsUnchangedNodes passed!" << std::endl;
+}
+
+void testUninternedTypes() {
+    // Outside a TypeContext every call builds a new node; equality stays structural
+    auto a = PointerType::get(Type::getI32());
+    auto b = PointerType::get(Type::getI32());
+    assert(a != b);
+    assert(a->equals(*b));
+
+    // Struct components are nominal, so their derived types are distinct nodes even within one context
+    TypeContext context;
+    TypeContext::Scope scope(context);
+    auto point1 = std::make_shared<StructType>("Point", std::vector<StructType::Field>{});
+    auto point2 = std::make_shared<StructType>("Point", std::vector<StructType::Field>{});
+    auto p1 = PointerType::get(point1);
+    auto p2 = PointerType::get(point2);
+    assert(p1 != p2);
+    assert(p1->equals(*p2));
+    assert(p1 == PointerType::get(point1));
+
+    std::cout << "testUninternedTypes passed!" << std::endl;
+}
+
 int main() {
     testPrimitiveTypes();
+    testInternedTypes();
+    testSubstituteKeepsUnchangedNodes();
+    testUninternedTypes();
     return 0;
 }
@@ -17,14 +17,18 @@ void testArrayNative() {
     // %t2 = load %t1
     // ret %t2
     auto mirFunc = std::make_unique<MIRFunction>("test_array", Type::getI32());
+    ValueID aVal = mirFunc->createValue("%a");
+    ValueID t0 = mirFunc->createTemp();
+    ValueID t1 = mirFunc->createTemp();
+    ValueID t2 = mirFunc->createTemp();
     auto entry = std::make_unique<BasicBlock>("entry");
     
-    auto arrayType = std::make_shared<ArrayType>(Type::getI32(), 10);
-    entry->appendInstruction(std::make_unique<AllocaInst>("%a", arrayType));
-    entry->appendInstruction(std::make_unique<ConstIntInst>("%t0", 1));
-    entry->appendInstruction(std::make_unique<ArrayElementPtrInst>("%t1", "%a", "%t0", Type::getI32()));
-    entry->appendInstruction(std::make_unique<LoadInst>("%t2", "%t1"));
-    entry->appendInstruction(std::make_unique<ReturnInst>("%t2"));
+    auto arrayType = ArrayType::get(Type::getI32(), 10);
+    entry->appendInstruction(std::make_unique<AllocaInst>(aVal, arrayType));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(t0, 1));
+    entry->appendInstruction(std::make_unique<ArrayElementPtrInst>(t1, aVal, t0, Type::getI32()));
+    entry->appendInstruction(std::make_unique<LoadInst>(t2, t1));
+    entry->appendInstruction(std::make_unique<ReturnInst>(t2));
     
     mirFunc->appendBlock(std::move(entry));
     mirModule.appendFunction(std::move(mirFunc));
@@ -68,11 +72,13 @@ void testMallocNative() {
     mirModule.appendFunction(std::move(freeFunc));
 
     auto mainFunc = std::make_unique<MIRFunction>("test_malloc", Type::getVoid());
+    ValueID sizeVal = mainFunc->createValue("%size");
+    ValueID p = mainFunc->createValue("%p");
     auto entry = std::make_unique<BasicBlock>("entry");
     
-    entry->appendInstruction(std::make_unique<ConstIntInst>("%size", 40));
-    entry->appendInstruction(std::make_unique<CallInst>("%p", "malloc", std::vector<std::string>{"%size"}));
-    entry->appendInstruction(std::make_unique<CallInst>("", "free", std::vector<std::string>{"%p"}));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(sizeVal, 40));
+    entry->appendInstruction(std::make_unique<CallInst>(p, "malloc", std::vector<ValueID>{sizeVal}));
+    entry->appendInstruction(std::make_unique<CallInst>(NoValue, "free", std::vector<ValueID>{p}));
     entry->appendInstruction(std::make_unique<ReturnInst>());
     
     mainFunc->appendBlock(std::move(entry));
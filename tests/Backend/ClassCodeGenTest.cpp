@@ -35,7 +35,7 @@ void testClassCodeGen() {
     // Method sum
     std::vector<std::unique_ptr<Param>> methodParams;
     auto selfType = std::make_shared<StructType>("Point", std::vector<StructType::Field>{}); // Placeholder name
-    auto selfPtrType = std::make_shared<PointerType>(selfType);
+    auto selfPtrType = PointerType::get(selfType);
     // Note: MIRBuilder relies on ptrTypeMap populated from type info. 
     // Here we construct AST manually.
     // MIRBuilder::lowerConstructorDecl will inject "self" into varMap and ptrTypeMap.
@@ -0,0 +1,76 @@
+#include "Backend/JIT.h"
+#include <cassert>
+#include <iostream>
+
+using namespace chtholly;
+
+void testExitCode() {
+    MIRModule mirModule;
+    auto mirFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID t0 = mirFunc->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 42));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    mirFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mirFunc));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "exit_code");
+    assert(exitCode == 42);
+
+    std::cout << "testExitCode passed!" << std::endl;
+}
+
+void testHostSymbols() {
+    MIRModule mirModule;
+
+    auto printfFunc = std::make_unique<MIRFunction>("printf", Type::getI32());
+    printfFunc->addParameter("fmt", Type::getI8Ptr());
+    printfFunc->setVarArg(true);
+    mirModule.appendFunction(std::move(printfFunc));
+
+    // fn add(a: i32, b: i32): i32 { return a + b; }
+    auto addFunc = std::make_unique<MIRFunction>("add", Type::getI32());
+    addFunc->addParameter("a", Type::getI32());
+    addFunc->addParameter("b", Type::getI32());
+    ValueID addT0 = addFunc->createTemp();
+    auto addBlock = std::make_unique<BasicBlock>("entry");
+    addBlock->appendInstruction(std::make_unique<BinOpInst>(addT0, addFunc->getParameterValue(0), addFunc->getParameterValue(1), TokenType::Plus));
+    addBlock->appendInstruction(std::make_unique<ReturnInst>(addT0));
+    addFunc->appendBlock(std::move(addBlock));
+    mirModule.appendFunction(std::move(addFunc));
+
+    auto mainFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID fmtVal = mainFunc->createValue("%fmt");
+    ValueID mainT0 = mainFunc->createTemp();
+    ValueID t1 = mainFunc->createTemp();
+    ValueID t2 = mainFunc->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstStringInst>(fmtVal, "Hello from the JIT\n"));
+    block->appendInstruction(std::make_unique<CallInst>(NoValue, "printf", std::vector<ValueID>{fmtVal}));
+    block->appendInstruction(std::make_unique<ConstIntInst>(mainT0, 3));
+    block->appendInstruction(std::make_unique<ConstIntInst>(t1, 4));
+    block->appendInstruction(std::make_unique<CallInst>(t2, "add", std::vector<ValueID>{mainT0, t1}));
+    block->appendInstruction(std::make_unique<ReturnInst>(t2));
+    mainFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mainFunc));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.setOptLevel(OptLevel::O2);
+    codeGen.generate();
+
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "host_symbols");
+    assert(exitCode == 7);
+
+    std::cout << "testHostSymbols passed!" << std::endl;
+}
+
+int main() {
+    testExitCode();
+    testHostSymbols();
+    return 0;
+}
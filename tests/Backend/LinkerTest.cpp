@@ -0,0 +1,89 @@
+#include "Backend/CodeGenerator.h"
+#include "Backend/Linker.h"
+#include <llvm/Support/Program.h>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+
+using namespace chtholly;
+
+void testObjectToBuffer() {
+    MIRModule mirModule;
+    auto mirFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID t0 = mirFunc->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 0));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    mirFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mirFunc));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+
+    llvm::SmallVector<char, 0> object;
+    bool emitted = codeGen.emitObjectToBuffer(object);
+    assert(emitted);
+    assert(!object.empty());
+
+    std::cout << "testObjectToBuffer passed!" << std::endl;
+}
+
+void testLinkFromMemory() {
+#ifndef _WIN32
+    MIRModule mirModule;
+    auto mirFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID t0 = mirFunc->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 9));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    mirFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mirFunc));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+
+    llvm::SmallVector<char, 0> object;
+    bool emitted = codeGen.emitObjectToBuffer(object);
+    assert(emitted);
+
+    std::string exePath = std::filesystem::absolute("linked_from_memory").string();
+    Linker linker;
+    bool linked = linker.invoke(object, exePath);
+    assert(linked);
+    assert(std::filesystem::exists(exePath));
+
+    llvm::StringRef args[] = {exePath};
+    int exitCode = llvm::sys::ExecuteAndWait(exePath, args);
+    assert(exitCode == 9);
+#endif
+
+    std::cout << "testLinkFromMemory passed!" << std::endl;
+}
+
+void testObjectFileFailure() {
+    MIRModule mirModule;
+    auto mirFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID t0 = mirFunc->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 0));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    mirFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mirFunc));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+
+    std::string objPath = (std::filesystem::temp_directory_path() / "no_such_dir" / "out.o").string();
+    bool emitted = codeGen.emitObjectFile(objPath);
+    assert(!emitted);
+    assert(!std::filesystem::exists(objPath));
+
+    std::cout << "testObjectFileFailure passed!" << std::endl;
+}
+
+int main() {
+    testObjectToBuffer();
+    testObjectFileFailure();
+    testLinkFromMemory();
+    return 0;
+}
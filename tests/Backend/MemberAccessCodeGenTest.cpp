@@ -25,12 +25,15 @@ void testMemberAccessCodeGen() {
     //   ret %t1
     // }
     auto mirFunc = std::make_unique<MIRFunction>("test", Type::getI32());
+    ValueID pVal = mirFunc->createValue("%p");
+    ValueID t0 = mirFunc->createTemp();
+    ValueID t1 = mirFunc->createTemp();
     auto entry = std::make_unique<BasicBlock>("entry");
     
-    entry->appendInstruction(std::make_unique<AllocaInst>("%p", pointType));
-    entry->appendInstruction(std::make_unique<StructElementPtrInst>("%t0", "%p", "Point", "y"));
-    entry->appendInstruction(std::make_unique<LoadInst>("%t1", "%t0"));
-    entry->appendInstruction(std::make_unique<ReturnInst>("%t1"));
+    entry->appendInstruction(std::make_unique<AllocaInst>(pVal, pointType));
+    entry->appendInstruction(std::make_unique<StructElementPtrInst>(t0, pVal, "Point", "y"));
+    entry->appendInstruction(std::make_unique<LoadInst>(t1, t0));
+    entry->appendInstruction(std::make_unique<ReturnInst>(t1));
     
     mirFunc->appendBlock(std::move(entry));
     mirModule.appendFunction(std::move(mirFunc));
@@ -8,10 +8,11 @@ int testNativeMain() {
     
     MIRModule mirModule;
     auto mirFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID t0 = mirFunc->createTemp();
     auto block = std::make_unique<BasicBlock>("entry");
     
-    block->appendInstruction(std::make_unique<ConstIntInst>("%t0", 42));
-    block->appendInstruction(std::make_unique<ReturnInst>("%t0"));
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 42));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
     
     mirFunc->appendBlock(std::move(block));
     mirModule.appendFunction(std::move(mirFunc));
@@ -44,12 +45,14 @@ void testHelloWorld() {
     
     // fn main(): i32 { printf("Hello, Chtholly!\n"); return 0; }
     auto mainFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID fmtVal = mainFunc->createValue("%fmt");
+    ValueID t0 = mainFunc->createTemp();
     auto block = std::make_unique<BasicBlock>("entry");
     
-    block->appendInstruction(std::make_unique<ConstStringInst>("%fmt", "Hello, Chtholly!\n"));
-    block->appendInstruction(std::make_unique<CallInst>("", "printf", std::vector<std::string>{"%fmt"}));
-    block->appendInstruction(std::make_unique<ConstIntInst>("%t0", 0));
-    block->appendInstruction(std::make_unique<ReturnInst>("%t0"));
+    block->appendInstruction(std::make_unique<ConstStringInst>(fmtVal, "Hello, Chtholly!\n"));
+    block->appendInstruction(std::make_unique<CallInst>(NoValue, "printf", std::vector<ValueID>{fmtVal}));
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 0));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
     
     mainFunc->appendBlock(std::move(block));
     mirModule.appendFunction(std::move(mainFunc));
@@ -0,0 +1,142 @@
+#include "Backend/ObjectCache.h"
+#include "Backend/ParallelCodeGen.h"
+#include "Backend/Linker.h"
+#include <llvm/Support/Program.h>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+
+using namespace chtholly;
+
+// fn <name>(): <type> { return <value>; }
+static void addConstFunction(MIRModule& mirModule, const std::string& name, int value, std::shared_ptr<Type> type = Type::getI32()) {
+    auto func = std::make_unique<MIRFunction>(name, type);
+    ValueID t0 = func->createTemp(type);
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, value));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+}
+
+// fn main(): i32 { return one() + two() + <third>(); }
+static void buildModule(MIRModule& mirModule, int third) {
+    addConstFunction(mirModule, "one", 1);
+    addConstFunction(mirModule, "two", 2);
+    addConstFunction(mirModule, "third", third);
+
+    auto mainFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = mainFunc.get();
+    ValueID t0 = f->createTemp();
+    ValueID t1 = f->createTemp();
+    ValueID t2 = f->createTemp();
+    ValueID t3 = f->createTemp();
+    ValueID t4 = f->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<CallInst>(t0, "one", std::vector<ValueID>{}));
+    block->appendInstruction(std::make_unique<CallInst>(t1, "two", std::vector<ValueID>{}));
+    block->appendInstruction(std::make_unique<CallInst>(t2, "third", std::vector<ValueID>{}));
+    block->appendInstruction(std::make_unique<BinOpInst>(t3, t0, t1, TokenType::Plus));
+    block->appendInstruction(std::make_unique<BinOpInst>(t4, t3, t2, TokenType::Plus));
+    block->appendInstruction(std::make_unique<ReturnInst>(t4));
+    mainFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mainFunc));
+}
+
+// fn probe(): i32 { let p: Point; return 0; } with Point { x: <fieldType> }
+static uint64_t fingerprintWithPoint(std::shared_ptr<Type> fieldType) {
+    MIRModule mirModule;
+    auto point = std::make_shared<StructType>("Point", std::vector<StructType::Field>{{"x", fieldType, true}});
+    auto func = std::make_unique<MIRFunction>("probe", Type::getI32());
+    ValueID p = func->createValue("%p", PointerType::get(point));
+    ValueID zero = func->createTemp(Type::getI32());
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<AllocaInst>(p, point));
+    block->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    block->appendInstruction(std::make_unique<ReturnInst>(zero));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+    return FunctionFingerprinter(mirModule, "").fingerprint(*mirModule.getFunction("probe"));
+}
+
+void testFingerprints() {
+    MIRModule base, changedBody, changedSignature;
+    buildModule(base, 4);
+    buildModule(changedBody, 5);
+    addConstFunction(changedSignature, "one", 1);
+    addConstFunction(changedSignature, "two", 2);
+    addConstFunction(changedSignature, "third", 4, Type::getI64());
+
+    FunctionFingerprinter a(base, "O0"), b(changedBody, "O0"), again(base, "O0"), other(base, "O2");
+    auto key = [](const FunctionFingerprinter& f, MIRModule& m, const std::string& name) {
+        return f.fingerprint(*m.getFunction(name));
+    };
+
+    assert(key(a, base, "main") == key(again, base, "main"));
+    assert(key(a, base, "one") != key(a, base, "two"));
+    assert(key(a, base, "main") != key(other, base, "main"));
+
+    // Editing a callee's body dirties only the callee
+    assert(key(a, base, "third") != key(b, changedBody, "third"));
+    assert(key(a, base, "main") == key(b, changedBody, "main"));
+    assert(key(a, base, "one") == key(b, changedBody, "one"));
+
+    // Editing a callee's signature dirties its callers
+    buildModule(changedSignature, 4);
+    FunctionFingerprinter c(changedSignature, "O0");
+    assert(key(a, base, "main") != c.fingerprint(*changedSignature.getFunctions().back()));
+
+    // So does the layout of a struct the function only reaches through a type
+    assert(fingerprintWithPoint(Type::getI32()) == fingerprintWithPoint(Type::getI32()));
+    assert(fingerprintWithPoint(Type::getI32()) != fingerprintWithPoint(Type::getI64()));
+
+    std::cout << "testFingerprints passed!" << std::endl;
+}
+
+void testIncrementalBuild() {
+    std::string dir = std::filesystem::absolute("object_cache_test").string();
+    std::filesystem::remove_all(dir);
+    ObjectCache cache(dir);
+
+    auto build = [&](int third, size_t expectReused, int expectExit) {
+        MIRModule mirModule;
+        buildModule(mirModule, third);
+        ParallelCodeGen parallel(mirModule, 2);
+        parallel.setObjectCache(&cache);
+        std::vector<llvm::SmallVector<char, 0>> objects;
+        bool emitted = parallel.emitObjects(objects);
+        assert(emitted);
+        assert(objects.size() == 4 && parallel.getNumFunctions() == 4);
+        assert(parallel.getNumReused() == expectReused);
+
+#ifndef _WIN32
+        std::string exePath = std::filesystem::absolute("object_cache_linked").string();
+        Linker linker;
+        bool linked = linker.invoke(objects, exePath);
+        assert(linked);
+
+        llvm::StringRef args[] = {exePath};
+        int exitCode = llvm::sys::ExecuteAndWait(exePath, args);
+        assert(exitCode == expectExit);
+#endif
+        (void)expectExit;
+    };
+
+    build(4, 0, 7);
+    build(4, 4, 7);
+    // Only the edited function is compiled again
+    build(5, 3, 8);
+    build(4, 4, 7);
+
+    llvm::SmallVector<char, 0> object;
+    assert(!cache.lookup(0, object));
+
+    std::filesystem::remove_all(dir);
+    std::cout << "testIncrementalBuild passed!" << std::endl;
+}
+
+int main() {
+    testFingerprints();
+    testIncrementalBuild();
+    return 0;
+}
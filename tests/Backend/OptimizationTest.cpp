@@ -0,0 +1,135 @@
+#include "Backend/CodeGenerator.h"
+#include <llvm/IR/Instructions.h>
+#include <cassert>
+#include <iostream>
+
+using namespace chtholly;
+
+// fn sum(n: i32): i32 { let mut s = 0; let mut i = 0; while (i < n) { s = s + i; i = i + 1; } return s; }
+static void buildSumLoop(MIRModule& mirModule) {
+    auto func = std::make_unique<MIRFunction>("sum", Type::getI32());
+    func->addParameter("n", Type::getI32());
+    ValueID nAddr = func->createValue("%n.addr");
+    ValueID s = func->createValue("%s");
+    ValueID i = func->createValue("%i");
+    ValueID t0 = func->createTemp();
+    ValueID t1 = func->createTemp();
+    ValueID t2 = func->createTemp();
+    ValueID t3 = func->createTemp();
+    ValueID t4 = func->createTemp();
+    ValueID t5 = func->createTemp();
+    ValueID t6 = func->createTemp();
+    ValueID t7 = func->createTemp();
+    ValueID t8 = func->createTemp();
+    ValueID t9 = func->createTemp();
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<AllocaInst>(nAddr, Type::getI32()));
+    entry->appendInstruction(std::make_unique<StoreInst>(func->getParameterValue(0), nAddr));
+    entry->appendInstruction(std::make_unique<AllocaInst>(s, Type::getI32()));
+    entry->appendInstruction(std::make_unique<AllocaInst>(i, Type::getI32()));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(t0, 0));
+    entry->appendInstruction(std::make_unique<StoreInst>(t0, s));
+    entry->appendInstruction(std::make_unique<StoreInst>(t0, i));
+    entry->appendInstruction(std::make_unique<BrInst>("cond"));
+
+    auto cond = std::make_unique<BasicBlock>("cond");
+    cond->appendInstruction(std::make_unique<LoadInst>(t1, i));
+    cond->appendInstruction(std::make_unique<LoadInst>(t2, nAddr));
+    cond->appendInstruction(std::make_unique<BinOpInst>(t3, t1, t2, TokenType::Less));
+    cond->appendInstruction(std::make_unique<CondBrInst>(t3, "body", "exit"));
+
+    auto body = std::make_unique<BasicBlock>("body");
+    body->appendInstruction(std::make_unique<LoadInst>(t4, s));
+    body->appendInstruction(std::make_unique<LoadInst>(t5, i));
+    body->appendInstruction(std::make_unique<BinOpInst>(t6, t4, t5, TokenType::Plus));
+    body->appendInstruction(std::make_unique<StoreInst>(t6, s));
+    body->appendInstruction(std::make_unique<ConstIntInst>(t7, 1));
+    body->appendInstruction(std::make_unique<BinOpInst>(t8, t5, t7, TokenType::Plus));
+    body->appendInstruction(std::make_unique<StoreInst>(t8, i));
+    body->appendInstruction(std::make_unique<BrInst>("cond"));
+
+    auto exit = std::make_unique<BasicBlock>("exit");
+    exit->appendInstruction(std::make_unique<LoadInst>(t9, s));
+    exit->appendInstruction(std::make_unique<ReturnInst>(t9));
+
+    func->appendBlock(std::move(entry));
+    func->appendBlock(std::move(cond));
+    func->appendBlock(std::move(body));
+    func->appendBlock(std::move(exit));
+    mirModule.appendFunction(std::move(func));
+}
+
+static size_t countAllocas(llvm::Function* func) {
+    size_t count = 0;
+    for (auto& bb : *func) {
+        for (auto& inst : bb) {
+            if (llvm::isa<llvm::AllocaInst>(inst)) count++;
+        }
+    }
+    return count;
+}
+
+void testO0KeepsAllocas() {
+    MIRModule mirModule;
+    buildSumLoop(mirModule);
+
+    CodeGenerator codeGen(mirModule);
+    assert(codeGen.getOptLevel() == OptLevel::O0);
+    codeGen.generate();
+    codeGen.emitObjectFile("opt_o0.obj");
+
+    auto* func = codeGen.getLLVMModule().getFunction("sum");
+    assert(func != nullptr);
+    assert(countAllocas(func) == 3);
+
+    std::cout << "testO0KeepsAllocas passed!" << std::endl;
+}
+
+void testO2PromotesAllocas() {
+    MIRModule mirModule;
+    buildSumLoop(mirModule);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.setOptLevel(OptLevel::O2);
+    codeGen.generate();
+    codeGen.emitObjectFile("opt_o2.obj");
+
+    auto* func = codeGen.getLLVMModule().getFunction("sum");
+    assert(func != nullptr);
+    assert(countAllocas(func) == 0);
+
+    std::cout << "testO2PromotesAllocas passed!" << std::endl;
+}
+
+void testLoopAllocaHoistedToEntry() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("loop_local", Type::getVoid());
+    ValueID tmp = func->createValue("%tmp");
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<BrInst>("body"));
+
+    auto body = std::make_unique<BasicBlock>("body");
+    body->appendInstruction(std::make_unique<AllocaInst>(tmp, Type::getI32()));
+    body->appendInstruction(std::make_unique<ReturnInst>());
+
+    func->appendBlock(std::move(entry));
+    func->appendBlock(std::move(body));
+    mirModule.appendFunction(std::move(func));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+
+    auto* llvmFunc = codeGen.getLLVMModule().getFunction("loop_local");
+    assert(llvm::isa<llvm::AllocaInst>(llvmFunc->getEntryBlock().front()));
+
+    std::cout << "testLoopAllocaHoistedToEntry passed!" << std::endl;
+}
+
+int main() {
+    testO0KeepsAllocas();
+    testO2PromotesAllocas();
+    testLoopAllocaHoistedToEntry();
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "Backend/ParallelCodeGen.h"
+#include "Backend/Linker.h"
+#include <llvm/Support/Program.h>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+
+using namespace chtholly;
+
+// fn <name>(): i32 { return <value>; }
+static void addConstFunction(MIRModule& mirModule, const std::string& name, int value) {
+    auto func = std::make_unique<MIRFunction>(name, Type::getI32());
+    ValueID t0 = func->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, value));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+}
+
+// fn main(): i32 { return one() + two() + four(); }
+static void buildModule(MIRModule& mirModule) {
+    addConstFunction(mirModule, "one", 1);
+    addConstFunction(mirModule, "two", 2);
+    addConstFunction(mirModule, "four", 4);
+
+    auto mainFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = mainFunc.get();
+    ValueID t0 = f->createTemp();
+    ValueID t1 = f->createTemp();
+    ValueID t2 = f->createTemp();
+    ValueID t3 = f->createTemp();
+    ValueID t4 = f->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<CallInst>(t0, "one", std::vector<ValueID>{}));
+    block->appendInstruction(std::make_unique<CallInst>(t1, "two", std::vector<ValueID>{}));
+    block->appendInstruction(std::make_unique<CallInst>(t2, "four", std::vector<ValueID>{}));
+    block->appendInstruction(std::make_unique<BinOpInst>(t3, t0, t1, TokenType::Plus));
+    block->appendInstruction(std::make_unique<BinOpInst>(t4, t3, t2, TokenType::Plus));
+    block->appendInstruction(std::make_unique<ReturnInst>(t4));
+    mainFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mainFunc));
+}
+
+void testPartition() {
+    MIRModule mirModule;
+    buildModule(mirModule);
+
+    ParallelCodeGen parallel(mirModule, 2);
+    auto partitions = parallel.partition();
+    assert(partitions.size() == 2);
+    // main is the heaviest body and gets a partition to itself
+    assert(partitions[0].size() == 1);
+    assert((*partitions[0].begin())->getName() == "main");
+    assert(partitions[1].size() == 3);
+
+    ParallelCodeGen wide(mirModule, 16);
+    assert(wide.partition().size() == 4);
+
+    std::cout << "testPartition passed!" << std::endl;
+}
+
+void testParallelLink() {
+    MIRModule mirModule;
+    buildModule(mirModule);
+
+    ParallelCodeGen parallel(mirModule, 3);
+    parallel.setOptLevel(OptLevel::O2);
+    std::vector<llvm::SmallVector<char, 0>> objects;
+    bool emitted = parallel.emitObjects(objects);
+    assert(emitted);
+    assert(objects.size() == 3);
+    for (const auto& object : objects) {
+        assert(!object.empty());
+    }
+
+#ifndef _WIN32
+    std::string exePath = std::filesystem::absolute("parallel_linked").string();
+    Linker linker;
+    bool linked = linker.invoke(objects, exePath);
+    assert(linked);
+
+    llvm::StringRef args[] = {exePath};
+    int exitCode = llvm::sys::ExecuteAndWait(exePath, args);
+    assert(exitCode == 7);
+#endif
+
+    std::cout << "testParallelLink passed!" << std::endl;
+}
+
+int main() {
+    testPartition();
+    testParallelLink();
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "Backend/CodeGenerator.h"
+#include <llvm/TargetParser/Host.h>
+#include <cassert>
+#include <iostream>
+
+using namespace chtholly;
+
+static void buildMain(MIRModule& mirModule) {
+    auto mirFunc = std::make_unique<MIRFunction>("main", Type::getI32());
+    ValueID t0 = mirFunc->createTemp();
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(t0, 0));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    mirFunc->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(mirFunc));
+}
+
+void testDefaultIsGeneric() {
+    MIRModule mirModule;
+    buildMain(mirModule);
+
+    CodeGenerator codeGen(mirModule);
+    assert(codeGen.resolveTargetCPU() == "generic");
+    assert(codeGen.resolveTargetFeatures().empty());
+
+    codeGen.generate();
+    codeGen.emitObjectFile("target_generic.obj");
+    auto* func = codeGen.getLLVMModule().getFunction("main");
+    assert(!func->hasFnAttribute("target-cpu"));
+
+    std::cout << "testDefaultIsGeneric passed!" << std::endl;
+}
+
+void testNativeCPU() {
+    MIRModule mirModule;
+    buildMain(mirModule);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.setTargetCPU("native");
+    assert(codeGen.resolveTargetCPU() == llvm::sys::getHostCPUName().str());
+
+    codeGen.generate();
+    codeGen.emitObjectFile("target_native.obj");
+    auto* func = codeGen.getLLVMModule().getFunction("main");
+    assert(func->getFnAttribute("target-cpu").getValueAsString() == llvm::sys::getHostCPUName());
+
+    std::cout << "testNativeCPU passed!" << std::endl;
+}
+
+void testExplicitFeatures() {
+    MIRModule mirModule;
+    CodeGenerator codeGen(mirModule);
+    codeGen.setTargetFeatures("avx2,-avx512f,+bmi2");
+    assert(codeGen.resolveTargetFeatures() == "+avx2,-avx512f,+bmi2");
+
+    // Explicit features are appended after the detected host set so they take precedence
+    codeGen.setTargetCPU("native");
+    std::string features = codeGen.resolveTargetFeatures();
+    assert(features.size() >= 20);
+    assert(features.substr(features.size() - 20) == "+avx2,-avx512f,+bmi2");
+
+    std::cout << "testExplicitFeatures passed!" << std::endl;
+}
+
+void testInvalidTargetRejected() {
+    MIRModule cpuModule;
+    buildMain(cpuModule);
+    CodeGenerator badCPU(cpuModule);
+    badCPU.setTargetCPU("no-such-cpu");
+    badCPU.generate();
+    llvm::SmallVector<char, 0> object;
+    bool emitted = badCPU.emitObjectToBuffer(object);
+    assert(!emitted);
+
+    MIRModule featureModule;
+    buildMain(featureModule);
+    CodeGenerator badFeature(featureModule);
+    badFeature.setTargetFeatures("+no-such-feature");
+    badFeature.generate();
+    emitted = badFeature.emitObjectToBuffer(object);
+    assert(!emitted);
+
+    std::cout << "testInvalidTargetRejected passed!" << std::endl;
+}
+
+int main() {
+    testDefaultIsGeneric();
+    testNativeCPU();
+    testExplicitFeatures();
+    testInvalidTargetRejected();
+    return 0;
+}
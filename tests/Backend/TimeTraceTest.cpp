@@ -0,0 +1,55 @@
+#include "Backend/CodeGenerator.h"
+#include "PhaseTimer.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace chtholly;
+
+void testTraceRecordsFunctions() {
+    std::string traceFile = (std::filesystem::temp_directory_path() / "chtholly_time_trace_test.json").string();
+    PhaseTimer::enableReport();
+    PhaseTimer::enableTrace(0);
+    assert(PhaseTimer::isTraceEnabled());
+
+    {
+        MIRModule mirModule;
+        auto mirFunc = std::make_unique<MIRFunction>("traced_main", Type::getI32());
+        ValueID t0 = mirFunc->createTemp();
+        auto block = std::make_unique<BasicBlock>("entry");
+        block->appendInstruction(std::make_unique<ConstIntInst>(t0, 0));
+        block->appendInstruction(std::make_unique<ReturnInst>(t0));
+        mirFunc->appendBlock(std::move(block));
+        mirModule.appendFunction(std::move(mirFunc));
+
+        CodeGenerator codeGen(mirModule);
+        codeGen.setOptLevel(OptLevel::O1);
+        codeGen.generate();
+        llvm::SmallVector<char, 0> object;
+        bool emitted = codeGen.emitObjectToBuffer(object);
+        assert(emitted);
+    }
+
+    PhaseTimer::finish(traceFile);
+    assert(!PhaseTimer::isTraceEnabled());
+
+    std::ifstream in(traceFile);
+    assert(in.is_open());
+    std::stringstream json;
+    json << in.rdbuf();
+    std::string trace = json.str();
+    assert(trace.find("\"traceEvents\"") != std::string::npos);
+    assert(trace.find("LLVM IR function") != std::string::npos);
+    assert(trace.find("traced_main") != std::string::npos);
+    assert(trace.find("Object emission") != std::string::npos);
+    std::filesystem::remove(traceFile);
+
+    std::cout << "testTraceRecordsFunctions passed!" << std::endl;
+}
+
+int main() {
+    testTraceRecordsFunctions();
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "CharScan.h"
+#include "TokenStream.h"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace chtholly;
+
+namespace {
+
+const charscan::ScanImpl allImpls[] = {charscan::ScanImpl::Scalar, charscan::ScanImpl::SSE2, charscan::ScanImpl::AVX2};
+
+// Random text biased towards the characters the kernels classify, including bytes >= 0x80
+std::string randomText(std::mt19937& rng, size_t length) {
+    static const std::string alphabet = "aZz_09 \t\r\n*/\"\\'@[`{\x80\xff";
+    std::string text(length, ' ');
+    for (auto& c : text) {
+        c = rng() % 4 == 0 ? alphabet[rng() % alphabet.size()] : "ab_ "[rng() % 4];
+    }
+    return text;
+}
+
+} // namespace
+
+void testKernelsAgreeWithScalar() {
+    std::mt19937 rng(1234);
+    for (int round = 0; round < 2000; ++round) {
+        std::string text = randomText(rng, rng() % 100);
+        const char* end = text.data() + text.size();
+        for (size_t start = 0; start < text.size(); start += 7) {
+            const char* p = text.data() + start;
+            charscan::setImpl(charscan::ScanImpl::Scalar);
+            size_t ident = charscan::identifierRun(p, end);
+            size_t blank = charscan::blankRun(p, end);
+            size_t comment = charscan::blockCommentRun(p, end);
+            size_t body = charscan::stringBodyRun(p, end);
+            for (auto impl : allImpls) {
+                if (!charscan::setImpl(impl)) continue;
+                assert(charscan::identifierRun(p, end) == ident);
+                assert(charscan::blankRun(p, end) == blank);
+                assert(charscan::blockCommentRun(p, end) == comment);
+                assert(charscan::stringBodyRun(p, end) == body);
+            }
+        }
+    }
+
+    std::string longRun(100, 'x');
+    longRun += '-';
+    for (auto impl : allImpls) {
+        if (!charscan::setImpl(impl)) continue;
+        assert(charscan::identifierRun(longRun.data(), longRun.data() + longRun.size()) == 100);
+        assert(charscan::lineCommentRun(longRun.data(), longRun.data() + longRun.size()) == 101);
+    }
+
+    std::cout << "testKernelsAgreeWithScalar passed!" << std::endl;
+}
+
+void testLexingIsImplIndependent() {
+    std::string source =
+        "/* header /* nested */ still comment */\n"
+        "fn a_very_long_identifier_name_that_spans_vectors(x: i32): i32 {\n"
+        "\t\t\t\t    // trailing comment with \"quotes\" and *stars*\n"
+        "    let s = \"a string body longer than thirty-two bytes \\\" with escape\";\n"
+        "    return x;\r\n"
+        "}\n";
+    charscan::setImpl(charscan::ScanImpl::Scalar);
+    TokenStream expected(source);
+    for (auto impl : allImpls) {
+        if (!charscan::setImpl(impl)) continue;
+        TokenStream actual(source);
+        assert(actual.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            assert(actual.kind(i) == expected.kind(i));
+            assert(actual.text(i) == expected.text(i));
+            assert(actual.line(i) == expected.line(i));
+            assert(actual.column(i) == expected.column(i));
+        }
+    }
+    assert(expected.kind(0) == TokenType::Fn);
+    assert(expected.line(0) == 2);
+
+    std::cout << "testLexingIsImplIndependent passed!" << std::endl;
+}
+
+int main() {
+    testKernelsAgreeWithScalar();
+    testLexingIsImplIndependent();
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "Lexer.h"
+#include <cassert>
+#include <iostream>
+#include <string_view>
+
+using namespace chtholly;
+
+namespace {
+
+// Token values point into the source, so it must outlive the returned token
+Token lexOne(std::string_view source) {
+    Lexer lexer(source);
+    return lexer.nextToken();
+}
+
+} // namespace
+
+void testEveryKeyword() {
+    for (const auto& keyword : KEYWORDS) {
+        Token token = lexOne(keyword.spelling);
+        assert(token.type == keyword.type);
+        assert(token.value == keyword.spelling);
+    }
+
+    std::cout << "testEveryKeyword passed!" << std::endl;
+}
+
+void testNearMissesAreIdentifiers() {
+    const char* names[] = {"fnn", "Fn", "f", "le", "lets", "SELF", "i128", "i3", "u", "__",
+                           "fallthrougH", "fallthroughs", "offsetoff", "a_very_long_identifier_name",
+                           "printf", "main", "x"};
+    for (const char* name : names) {
+        Token token = lexOne(name);
+        assert(token.type == TokenType::Identifier);
+        assert(token.value == name);
+    }
+
+    std::cout << "testNearMissesAreIdentifiers passed!" << std::endl;
+}
+
+void testNumberSuffixes() {
+    assert(lexOne("42i64").value == "42i64");
+    assert(lexOne("42_u8").value == "42_u8");
+    assert(lexOne("1.5f32").type == TokenType::Float);
+    // Keywords that are not numeric types are not suffixes
+    assert(lexOne("42fn").value == "42");
+    assert(lexOne("42bool").value == "42");
+
+    std::cout << "testNumberSuffixes passed!" << std::endl;
+}
+
+int main() {
+    testEveryKeyword();
+    testNearMissesAreIdentifiers();
+    testNumberSuffixes();
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "SourceManager.h"
+#include "Sema/Sema.h"
+#include "Parser.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace chtholly;
+
+void testLoadOnce() {
+    std::string small = "fn main(): i32 { return 0; }\n";
+    // Large enough that the file is mapped rather than read
+    std::string large;
+    while (large.size() < 256 * 1024) large += "fn f(): void {}\n";
+    std::ofstream("source_small.cns", std::ios::binary) << small;
+    std::ofstream("source_large.cns", std::ios::binary) << large;
+    std::ofstream("source_empty.cns", std::ios::binary);
+
+    SourceManager manager;
+    auto first = manager.load("source_small.cns");
+    assert(first && *first == small);
+    auto again = manager.load("source_small.cns");
+    assert(again && again->data() == first->data());
+
+    auto mapped = manager.load("source_large.cns");
+    assert(mapped && *mapped == large);
+    auto empty = manager.load("source_empty.cns");
+    assert(empty && empty->empty());
+    assert(manager.getNumFiles() == 3);
+
+    assert(!manager.load("source_missing.cns"));
+    assert(manager.getNumFiles() == 3);
+
+    // The text stays valid for the manager's lifetime, so tokens can point into it
+    Parser parser(*mapped);
+    auto nodes = parser.parseProgram();
+    assert(nodes.size() == large.size() / std::string("fn f(): void {}\n").size());
+
+    std::filesystem::remove("source_small.cns");
+    std::filesystem::remove("source_large.cns");
+    std::filesystem::remove("source_empty.cns");
+
+    std::cout << "testLoadOnce passed!" << std::endl;
+}
+
+void testImportsUseActiveManager() {
+    std::ofstream("source_import.cns", std::ios::binary) << "pub fn one(): i32 { return 1; }\n";
+
+    SourceManager manager;
+    assert(SourceManager::current() == nullptr);
+    {
+        SourceManager::Scope scope(manager);
+        assert(SourceManager::current() == &manager);
+
+        std::string source = "import \"source_import.cns\";\n";
+        Parser parser(source);
+        auto nodes = parser.parseProgram();
+        Sema sema;
+        for (auto& node : nodes) sema.analyze(node.get());
+        assert(manager.getNumFiles() == 1);
+
+        std::string missing = "import \"source_nowhere.cns\";\n";
+        Parser missingParser(missing);
+        auto missingNodes = missingParser.parseProgram();
+        bool threw = false;
+        try {
+            sema.analyze(missingNodes[0].get());
+        } catch (const std::runtime_error& e) {
+            threw = std::string(e.what()).find("Could not open imported file") != std::string::npos;
+        }
+        assert(threw);
+    }
+    assert(SourceManager::current() == nullptr);
+
+    std::filesystem::remove("source_import.cns");
+
+    std::cout << "testImportsUseActiveManager passed!" << std::endl;
+}
+
+int main() {
+    testLoadOnce();
+    testImportsUseActiveManager();
+    return 0;
+}
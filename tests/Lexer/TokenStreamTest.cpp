@@ -0,0 +1,72 @@
+#include "TokenStream.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+using namespace chtholly;
+
+void testMatchesLexer() {
+    std::string source = "fn main(): i32 {\n    let s = \"a\\\"b\";\n    /* c */ return 0x1F + 2.5e3;\n}\n";
+    TokenStream tokens(source);
+    Lexer lexer(source);
+    size_t i = 0;
+    while (true) {
+        Token expected = lexer.nextToken();
+        Token actual = tokens.token(i);
+        assert(actual.type == expected.type);
+        assert(actual.value == expected.value);
+        assert(actual.line == expected.line);
+        assert(actual.column == expected.column);
+        ++i;
+        if (expected.type == TokenType::EndOfFile) break;
+    }
+    assert(i == tokens.size());
+
+    std::cout << "testMatchesLexer passed!" << std::endl;
+}
+
+void testLookaheadAndLocations() {
+    std::string source = "let x\n\n  = 1;";
+    TokenStream tokens(source);
+    assert(tokens.size() == 6);
+    assert(tokens.kind(3) == TokenType::Integer);
+    assert(tokens.text(3) == "1");
+    assert(tokens.offset(3) == 11);
+
+    // Locations resolve in any order, not just sequentially
+    assert(tokens.line(3) == 3 && tokens.column(3) == 5);
+    assert(tokens.line(0) == 1 && tokens.column(0) == 1);
+    assert(tokens.line(2) == 3 && tokens.column(2) == 3);
+    assert(tokens.line(1) == 1 && tokens.column(1) == 5);
+
+    // Lookahead past the end keeps returning EndOfFile
+    assert(tokens.kind(5) == TokenType::EndOfFile);
+    assert(tokens.kind(100) == TokenType::EndOfFile);
+    assert(tokens.text(100).empty());
+
+    std::cout << "testLookaheadAndLocations passed!" << std::endl;
+}
+
+void testParserErrorLine() {
+    std::string source = "fn f(): void {\n    let x: = 1;\n}";
+    Parser parser(source);
+    bool threw = false;
+    try {
+        parser.parseProgram();
+    } catch (const std::runtime_error& e) {
+        threw = true;
+        assert(std::string(e.what()).find("line 2") != std::string::npos);
+    }
+    assert(threw);
+
+    std::cout << "testParserErrorLine passed!" << std::endl;
+}
+
+int main() {
+    testMatchesLexer();
+    testLookaheadAndLocations();
+    testParserErrorLine();
+    return 0;
+}
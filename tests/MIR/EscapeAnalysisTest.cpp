@@ -0,0 +1,196 @@
+#include "MIR/Passes.h"
+#include "MIR/EscapeAnalysis.h"
+#include "Backend/JIT.h"
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+using namespace chtholly;
+
+static size_t countCalls(const MIRFunction& func, const std::string& callee) {
+    size_t count = 0;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() == MIRInstructionKind::Call && static_cast<const CallInst&>(*inst).getCallee() == callee) ++count;
+        }
+    }
+    return count;
+}
+
+static std::unique_ptr<CallInst> mallocCall(MIRModule& mirModule, ValueID dest, ValueID size) {
+    return std::make_unique<CallInst>(dest, "malloc", std::vector<ValueID>{size}, mirModule.getFunctionID("malloc"));
+}
+
+static std::unique_ptr<CallInst> freeCall(MIRModule& mirModule, ValueID ptr) {
+    return std::make_unique<CallInst>(NoValue, "free", std::vector<ValueID>{ptr}, mirModule.getFunctionID("free"));
+}
+
+void testLocalAllocationMoved() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID size = f->createTemp(), p = f->createValue("%p"), answer = f->createTemp(), result = f->createTemp();
+
+    // let p = malloc[i32](); *p = 42; let result = *p; free(p); return result;
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<SizeofInst>(size, Type::getI32()));
+    entry->appendInstruction(mallocCall(mirModule, p, size));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(answer, 42));
+    entry->appendInstruction(std::make_unique<StoreInst>(answer, p));
+    entry->appendInstruction(std::make_unique<LoadInst>(result, p));
+    entry->appendInstruction(freeCall(mirModule, p));
+    entry->appendInstruction(std::make_unique<ReturnInst>(result));
+    f->appendBlock(std::move(entry));
+    mirModule.appendFunction(std::move(func));
+
+    auto allocations = analyzeHeapAllocations(*f);
+    assert(allocations.size() == 1);
+    assert(allocations[0].escape.empty());
+    assert(allocations[0].frees.size() == 1);
+    assert(allocations[0].stackType->isI32());
+
+    std::ostringstream remarks;
+    PassManager passManager;
+    passManager.addPass(std::make_unique<HeapToStack>());
+    passManager.reportRemarks("heap-to-stack");
+    passManager.setPrintStream(remarks);
+    bool changed = passManager.run(mirModule);
+    assert(changed);
+    assert(remarks.str() == "remark: main: malloc %p moved to the stack as i32\n");
+
+    const MIRFunction& moved = *mirModule.getFunction("main");
+    assert(countCalls(moved, "malloc") == 0 && countCalls(moved, "free") == 0);
+    const MIRInstruction& first = *moved.getBlocks().front()->getInstructions().front();
+    assert(first.getKind() == MIRInstructionKind::Alloca && first.getResult() == p);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "heap_to_stack");
+    assert(exitCode == 42);
+
+    std::cout << "testLocalAllocationMoved passed!" << std::endl;
+}
+
+void testPointerVariables() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    auto i32Ptr = PointerType::get(Type::getI32());
+    ValueID size = f->createTemp(), p = f->createValue("%p"), q = f->createValue("%q"), other = f->createValue("%other");
+    ValueID slot = f->createValue("%slot"), shared = f->createValue("%shared");
+    ValueID loaded = f->createTemp(), copy = f->createTemp(), same = f->createTemp(), zero = f->createTemp();
+
+    // p reaches free through a variable and a copy; q and other share one variable
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<SizeofInst>(size, Type::getI32()));
+    entry->appendInstruction(mallocCall(mirModule, p, size));
+    entry->appendInstruction(mallocCall(mirModule, q, size));
+    entry->appendInstruction(mallocCall(mirModule, other, size));
+    entry->appendInstruction(std::make_unique<AllocaInst>(slot, i32Ptr));
+    entry->appendInstruction(std::make_unique<AllocaInst>(shared, i32Ptr));
+    entry->appendInstruction(std::make_unique<StoreInst>(p, slot));
+    entry->appendInstruction(std::make_unique<LoadInst>(loaded, slot));
+    entry->appendInstruction(std::make_unique<UnaryOpInst>(copy, loaded, TokenType::Plus));
+    entry->appendInstruction(std::make_unique<BinOpInst>(same, copy, p, TokenType::EqualEqual));
+    entry->appendInstruction(freeCall(mirModule, copy));
+    entry->appendInstruction(std::make_unique<StoreInst>(q, shared));
+    entry->appendInstruction(std::make_unique<StoreInst>(other, shared));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    entry->appendInstruction(std::make_unique<ReturnInst>(zero));
+    f->appendBlock(std::move(entry));
+    mirModule.appendFunction(std::move(func));
+
+    auto allocations = analyzeHeapAllocations(*f);
+    assert(allocations.size() == 3);
+    assert(allocations[0].escape.empty() && allocations[0].frees.size() == 1);
+    assert(allocations[1].escape == "shares a variable with another pointer");
+    assert(allocations[2].escape == "shares a variable with another pointer");
+
+    PassManager passManager;
+    passManager.addPass(std::make_unique<HeapToStack>());
+    bool changed = passManager.run(mirModule);
+    assert(changed);
+    assert(countCalls(*f, "malloc") == 2 && countCalls(*f, "free") == 0);
+
+    std::cout << "testPointerVariables passed!" << std::endl;
+}
+
+void testEscapingAllocationsKept() {
+    MIRModule mirModule;
+    auto sink = std::make_unique<MIRFunction>("sink", Type::getVoid());
+    sink->addParameter("ptr", PointerType::get(Type::getI32()));
+    auto sinkEntry = std::make_unique<BasicBlock>("entry");
+    sinkEntry->appendInstruction(std::make_unique<ReturnInst>());
+    sink->appendBlock(std::move(sinkEntry));
+    mirModule.appendFunction(std::move(sink));
+
+    auto func = std::make_unique<MIRFunction>("make", PointerType::get(Type::getI32()));
+    auto* f = func.get();
+    f->addParameter("out", PointerType::get(PointerType::get(Type::getI32())));
+    f->addParameter("n", Type::getI64());
+    ValueID out = f->getParameterValue(0), n = f->getParameterValue(1);
+    ValueID size = f->createTemp(), returned = f->createValue("%returned"), passed = f->createValue("%passed");
+    ValueID stored = f->createValue("%stored"), dynamic = f->createValue("%dynamic"), looped = f->createValue("%looped");
+    ValueID huge = f->createTemp(), big = f->createValue("%big"), cond = f->createTemp();
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<SizeofInst>(size, Type::getI32()));
+    entry->appendInstruction(mallocCall(mirModule, returned, size));
+    entry->appendInstruction(mallocCall(mirModule, passed, size));
+    entry->appendInstruction(std::make_unique<CallInst>(NoValue, "sink", std::vector<ValueID>{passed}, mirModule.getFunctionID("sink")));
+    entry->appendInstruction(mallocCall(mirModule, stored, size));
+    entry->appendInstruction(std::make_unique<StoreInst>(stored, out));
+    entry->appendInstruction(mallocCall(mirModule, dynamic, n));
+    entry->appendInstruction(freeCall(mirModule, dynamic));
+    entry->appendInstruction(std::make_unique<SizeofInst>(huge, ArrayType::get(Type::getI64(), 1024)));
+    entry->appendInstruction(mallocCall(mirModule, big, huge));
+    entry->appendInstruction(freeCall(mirModule, big));
+    entry->appendInstruction(std::make_unique<BrInst>("loop"));
+
+    auto loop = std::make_unique<BasicBlock>("loop");
+    loop->appendInstruction(mallocCall(mirModule, looped, size));
+    loop->appendInstruction(freeCall(mirModule, looped));
+    loop->appendInstruction(std::make_unique<ConstBoolInst>(cond, false));
+    loop->appendInstruction(std::make_unique<CondBrInst>(cond, "loop", "exit"));
+
+    auto exit = std::make_unique<BasicBlock>("exit");
+    exit->appendInstruction(std::make_unique<ReturnInst>(returned));
+
+    f->appendBlock(std::move(entry));
+    f->appendBlock(std::move(loop));
+    f->appendBlock(std::move(exit));
+    mirModule.appendFunction(std::move(func));
+
+    auto allocations = analyzeHeapAllocations(*f);
+    assert(allocations.size() == 6);
+    assert(allocations[0].escape == "returned");
+    assert(allocations[1].escape == "passed to sink");
+    assert(allocations[2].escape == "stored through a pointer");
+    assert(allocations[3].escape.empty() && !allocations[3].stackType);
+    assert(allocations[4].escape.empty() && allocations[4].stackType);
+    assert(allocations[5].escape.empty() && allocations[5].frees.size() == 1);
+
+    std::ostringstream remarks;
+    PassManager passManager;
+    passManager.addPass(std::make_unique<HeapToStack>());
+    passManager.reportRemarks("all");
+    passManager.setPrintStream(remarks);
+    bool changed = passManager.run(mirModule);
+    assert(!changed);
+    assert(countCalls(*f, "malloc") == 6 && countCalls(*f, "free") == 3);
+    const std::string report = remarks.str();
+    assert(report.find("remark: make: malloc %returned kept on the heap: returned\n") != std::string::npos);
+    assert(report.find("malloc %dynamic kept on the heap: size is not a constant\n") != std::string::npos);
+    assert(report.find("malloc %big kept on the heap: may be larger than 4096 bytes\n") != std::string::npos);
+    assert(report.find("malloc %looped kept on the heap: allocated in a loop\n") != std::string::npos);
+
+    std::cout << "testEscapingAllocationsKept passed!" << std::endl;
+}
+
+int main() {
+    testLocalAllocationMoved();
+    testPointerVariables();
+    testEscapingAllocationsKept();
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "MIR/Passes.h"
+#include "MIR/Inliner.h"
+#include "MIR/MIRBuilder.h"
+#include "Parser.h"
+#include "Sema/Sema.h"
+#include "Backend/JIT.h"
+#include <cassert>
+#include <iostream>
+
+using namespace chtholly;
+
+static size_t countCalls(const MIRFunction& func, const std::string& callee) {
+    size_t count = 0;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() == MIRInstructionKind::Call && static_cast<const CallInst&>(*inst).getCallee() == callee) ++count;
+        }
+    }
+    return count;
+}
+
+static void lowerSource(const std::string& source, MIRModule& mirModule) {
+    Parser parser(source);
+    auto nodes = parser.parseProgram();
+    Sema sema;
+    for (auto& node : nodes) {
+        sema.analyze(node.get());
+    }
+    MIRBuilder mirBuilder(mirModule);
+    for (auto& node : nodes) {
+        mirBuilder.lower(node.get());
+    }
+}
+
+// fn <name>() calling each of `callees`, then returning 0
+static void addCaller(MIRModule& mirModule, const std::string& name, const std::vector<std::string>& callees) {
+    auto func = std::make_unique<MIRFunction>(name, Type::getI32());
+    auto block = std::make_unique<BasicBlock>("entry");
+    for (const auto& callee : callees) {
+        block->appendInstruction(std::make_unique<CallInst>(func->createTemp(), callee, std::vector<ValueID>{}, mirModule.getFunctionID(callee)));
+    }
+    ValueID zero = func->createTemp();
+    block->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    block->appendInstruction(std::make_unique<ReturnInst>(zero));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+}
+
+void testCallGraph() {
+    MIRModule mirModule;
+    addCaller(mirModule, "main", {"even", "leaf"});
+    addCaller(mirModule, "even", {"odd"});
+    addCaller(mirModule, "odd", {"even", "leaf"});
+    addCaller(mirModule, "leaf", {"malloc"});
+    addCaller(mirModule, "self", {"self"});
+
+    CallGraph callGraph(mirModule);
+    FunctionID main = mirModule.findFunctionID("main"), even = mirModule.findFunctionID("even");
+    FunctionID odd = mirModule.findFunctionID("odd"), leaf = mirModule.findFunctionID("leaf");
+    FunctionID self = mirModule.findFunctionID("self"), malloc = mirModule.findFunctionID("malloc");
+    assert(callGraph.getCallees(main).size() == 2);
+    assert(callGraph.getCallees(leaf).empty()); // malloc has no function behind its ID
+    assert(callGraph.inSameSCC(even, odd));
+    assert(!callGraph.inSameSCC(main, even));
+    assert(callGraph.isRecursive(even) && callGraph.isRecursive(self));
+    assert(!callGraph.isRecursive(main) && !callGraph.isRecursive(leaf));
+
+    // Callees first: leaf before even/odd before main
+    std::vector<size_t> position(mirModule.getNumFunctionIDs());
+    const auto& sccs = callGraph.getSCCs();
+    for (size_t i = 0; i < sccs.size(); ++i) {
+        for (FunctionID id : sccs[i]) position[id] = i;
+    }
+    assert(position[leaf] < position[even] && position[even] < position[main]);
+    assert(position[even] == position[odd]);
+    assert(position[malloc] != position[leaf]);
+
+    std::cout << "testCallGraph passed!" << std::endl;
+}
+
+void testInlineStraightLine() {
+    MIRModule mirModule;
+    lowerSource(R"(
+        fn add(a: i32, b: i32): i32 { return a + b; }
+        fn twice(x: i32): i32 { return add(x, x); }
+        fn main(): i32 { return twice(add(1, 2)) + 1; }
+    )", mirModule);
+
+    PassManager passManager;
+    addDefaultPasses(passManager);
+    bool changed = passManager.run(mirModule);
+    assert(changed);
+
+    // twice was optimized with add already inlined, then both went into main and folded away
+    const MIRFunction& twice = *mirModule.getFunction("twice");
+    assert(countCalls(twice, "add") == 0);
+    const MIRFunction& main = *mirModule.getFunction("main");
+    assert(countCalls(main, "add") == 0 && countCalls(main, "twice") == 0);
+    assert(main.getBlocks().size() == 1);
+    // The callees stay behind for other callers
+    assert(mirModule.getFunction("add")->getBlocks().size() == 1);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "inline_straight_line");
+    assert(exitCode == 7);
+
+    std::cout << "testInlineStraightLine passed!" << std::endl;
+}
+
+void testInlineMultipleReturns() {
+    MIRModule mirModule;
+    lowerSource(R"(
+        fn clamp(x: i32): i32 {
+            if x > 10 {
+                return 10;
+            }
+            return x;
+        }
+        fn main(): i32 {
+            let mut s: i32 = 0;
+            let mut i: i32 = 0;
+            while i < 5 {
+                s = s + clamp(i * 4);
+                i = i + 1;
+            }
+            return s;
+        }
+    )", mirModule);
+
+    PassManager passManager;
+    passManager.addPass(std::make_unique<Inliner>());
+    bool changed = passManager.run(mirModule);
+    assert(changed);
+
+    // The call's block is split and both returns branch to the second half, where a phi picks the result
+    const MIRFunction& main = *mirModule.getFunction("main");
+    assert(countCalls(main, "clamp") == 0);
+    bool merged = false;
+    for (const auto& block : main.getBlocks()) {
+        if (block->getName().rfind("clamp.exit", 0) != 0) continue;
+        const auto& phi = static_cast<const PhiInst&>(*block->getInstructions().front());
+        assert(phi.getKind() == MIRInstructionKind::Phi);
+        assert(phi.getIncomings().size() == 2);
+        merged = true;
+    }
+    assert(merged);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "inline_multiple_returns");
+    assert(exitCode == 32); // 0 + 4 + 8 + 10 + 10
+
+    std::cout << "testInlineMultipleReturns passed!" << std::endl;
+}
+
+void testHintsAndRecursion() {
+    MIRModule mirModule;
+    lowerSource(R"(
+        noinline fn one(): i32 { return 1; }
+        fn three(x: i32): i32 { return x + 2; }
+        inline fn sum(a: i32, b: i32, c: i32): i32 { return a + b + c; }
+        inline fn fact(n: i32): i32 {
+            if n <= 1 {
+                return 1;
+            }
+            return n * fact(n - 1);
+        }
+        fn main(): i32 { return sum(one(), three(1), fact(4)); }
+    )", mirModule);
+
+    // With a threshold of zero only the hints and free bodies get inlined
+    PassManager passManager;
+    passManager.addPass(std::make_unique<Inliner>(0));
+    passManager.run(mirModule);
+
+    const MIRFunction& main = *mirModule.getFunction("main");
+    assert(mirModule.getFunction("sum")->getInlineHint() == InlineHint::Always);
+    assert(mirModule.getFunction("one")->getInlineHint() == InlineHint::Never);
+    assert(countCalls(main, "sum") == 0);
+    assert(countCalls(main, "one") == 1);
+    assert(countCalls(main, "three") == 1);
+    // fact calls itself, so neither main nor fact gets a copy of it despite the hint
+    assert(countCalls(main, "fact") == 1);
+    assert(countCalls(*mirModule.getFunction("fact"), "fact") == 1);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "inline_hints");
+    assert(exitCode == 28);
+
+    std::cout << "testHintsAndRecursion passed!" << std::endl;
+}
+
+int main() {
+    testCallGraph();
+    testInlineStraightLine();
+    testInlineMultipleReturns();
+    testHintsAndRecursion();
+    return 0;
+}
@@ -24,22 +24,22 @@ void testLowerFunction() {
     
     // Instructions should be:
     // %x = alloca i32
-    // %t0 = const 1
-    // %t1 = const 2
-    // %t2 = add %t0, %t1
-    // store %t2, %x
-    // %t3 = load %x
-    // ret %t3
+    // %1 = const 1
+    // %2 = const 2
+    // %3 = add %1, %2
+    // store %3, %x
+    // %4 = load %x
+    // ret %4
     
     auto& insts = blocks[0]->getInstructions();
     assert(insts.size() == 7);
     assert(insts[0]->toString() == "%x = alloca i32");
-    assert(insts[1]->toString() == "%t0 = const 1");
-    assert(insts[2]->toString() == "%t1 = const 2");
-    assert(insts[3]->toString() == "%t2 = add %t0, %t1");
-    assert(insts[4]->toString() == "store %t2, %x");
-    assert(insts[5]->toString() == "%t3 = load %x");
-        assert(insts[6]->toString() == "ret %t3");
+    assert(insts[1]->toString() == "%1 = const 1");
+    assert(insts[2]->toString() == "%2 = const 2");
+    assert(insts[3]->toString() == "%3 = add %1, %2");
+    assert(insts[4]->toString() == "store %3, %x");
+    assert(insts[5]->toString() == "%4 = load %x");
+        assert(insts[6]->toString() == "ret %4");
     
         std::cout << "testLowerFunction passed!" << std::endl;
     }
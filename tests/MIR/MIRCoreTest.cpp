@@ -5,13 +5,17 @@
 void testMIRCore() {
     using namespace chtholly;
     
+    auto func = std::make_unique<MIRFunction>("main", Type::getVoid());
     auto block = std::make_unique<BasicBlock>("entry");
     assert(block->getName() == "entry");
     
     // Test Instruction
-    block->appendInstruction(std::make_unique<AllocaInst>("x", Type::getI32()));
+    block->appendInstruction(std::make_unique<AllocaInst>(func->createValue("x"), Type::getI32()));
     assert(block->getInstructions().size() == 1);
-    assert(block->getInstructions()[0]->toString() == "x = alloca i32");
+    assert(block->getInstructions()[0]->toString() == "%0 = alloca i32");
+
+    func->appendBlock(std::move(block));
+    assert(func->getBlocks()[0]->getInstructions()[0]->toString() == "x = alloca i32");
     
     std::cout << "testMIRCore passed!" << std::endl;
 }
@@ -28,19 +32,74 @@ void testMIRFunction() {
     std::cout << "testMIRFunction passed!" << std::endl;
 }
 
+void testMIRValueTable() {
+    using namespace chtholly;
+    auto func = std::make_unique<MIRFunction>("f", Type::getI32());
+    func->addParameter("a", Type::getI32());
+    assert(func->getNumValues() == 1);
+    assert(func->getValueName(func->getParameterValue(0)) == "%a");
+    assert(func->getValueType(func->getParameterValue(0)) == Type::getI32());
+
+    // Temporaries are anonymous: no name, no lookup entry
+    ValueID t0 = func->createTemp();
+    assert(t0 == 1);
+    assert(func->getValueName(t0).empty());
+    assert(func->lookupValue("%a") == func->getParameterValue(0));
+    assert(!func->lookupValue("%t0"));
+
+    // Shadowed locals reuse a name but must get a distinct value
+    ValueID x = func->createValue("%x", Type::getI32());
+    ValueID shadow = func->createValue("%x", Type::getBool());
+    assert(x != shadow);
+    assert(func->getValueName(shadow) == "%x.1");
+    assert(func->getValueType(shadow) == Type::getBool());
+
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<BinOpInst>(t0, func->getParameterValue(0), x, TokenType::Plus));
+    block->appendInstruction(std::make_unique<ReturnInst>(t0));
+    func->appendBlock(std::move(block));
+    const auto& insts = func->getBlocks()[0]->getInstructions();
+    assert(insts[0]->toString() == "%1 = binop " + std::to_string((int)TokenType::Plus) + " %a, %x");
+    assert(insts[1]->toString() == "ret %1");
+
+    std::cout << "testMIRValueTable passed!" << std::endl;
+}
+
 void testMIRModule() {
     using namespace chtholly;
     MIRModule module;
     auto func = std::make_unique<MIRFunction>("test", Type::getVoid());
     module.appendFunction(std::move(func));
     assert(module.getFunctions().size() == 1);
-    
+
+    // A call lowered before its callee reserves the ID the callee fills later
+    FunctionID later = module.getFunctionID("later");
+    assert(module.getFunction(later) == nullptr);
+    module.appendFunction(std::make_unique<MIRFunction>("later", Type::getI32()));
+    assert(module.getFunction(later) == module.getFunction("later"));
+    assert(module.getFunction(later)->getID() == later);
+    assert(module.getFunction("test")->getID() != later);
+
+    // Externals keep an empty slot; unknown names have no ID
+    FunctionID external = module.getFunctionID("malloc");
+    assert(module.getFunction(external) == nullptr);
+    assert(module.findFunctionID("missing") == NoFunction);
+    assert(module.getFunction("missing") == nullptr);
+
+    // A duplicate name gets an ID of its own; lookups by name find the first
+    auto* first = module.getFunction("later");
+    module.appendFunction(std::make_unique<MIRFunction>("later", Type::getI32()));
+    auto* duplicate = module.getFunctions().back().get();
+    assert(duplicate->getID() != later && module.getFunction(duplicate->getID()) == duplicate);
+    assert(module.getFunction("later") == first);
+
     std::cout << "testMIRModule passed!" << std::endl;
 }
 
 int main() {
     testMIRCore();
     testMIRFunction();
+    testMIRValueTable();
     testMIRModule();
     return 0;
 }
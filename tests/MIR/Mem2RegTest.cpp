@@ -0,0 +1,210 @@
+#include "MIR/Mem2Reg.h"
+#include "MIR/Dominators.h"
+#include "Backend/JIT.h"
+#include <cassert>
+#include <iostream>
+
+using namespace chtholly;
+
+static size_t countKind(const MIRFunction& func, MIRInstructionKind kind) {
+    size_t count = 0;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() == kind) ++count;
+        }
+    }
+    return count;
+}
+
+// fn main(): i32 { let s = 0; let i = 0; while (i < 10) { s = s + i; i = i + 1; } return s; }
+static void buildLoop(MIRModule& mirModule) {
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID s = f->createValue("%s", Type::getI32());
+    ValueID i = f->createValue("%i", Type::getI32());
+    ValueID zero = f->createTemp(), ten = f->createTemp(), one = f->createTemp();
+    ValueID t1 = f->createTemp(), t2 = f->createTemp(), t3 = f->createTemp();
+    ValueID t4 = f->createTemp(), t5 = f->createTemp(), t6 = f->createTemp(), t7 = f->createTemp();
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<AllocaInst>(s, Type::getI32()));
+    entry->appendInstruction(std::make_unique<AllocaInst>(i, Type::getI32()));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    entry->appendInstruction(std::make_unique<StoreInst>(zero, s));
+    entry->appendInstruction(std::make_unique<StoreInst>(zero, i));
+    entry->appendInstruction(std::make_unique<BrInst>("cond"));
+
+    // Laid out before the loop it follows, so codegen must not emit blocks in layout order
+    auto exit = std::make_unique<BasicBlock>("exit");
+    exit->appendInstruction(std::make_unique<LoadInst>(t7, s));
+    exit->appendInstruction(std::make_unique<ReturnInst>(t7));
+
+    auto cond = std::make_unique<BasicBlock>("cond");
+    cond->appendInstruction(std::make_unique<LoadInst>(t1, i));
+    cond->appendInstruction(std::make_unique<ConstIntInst>(ten, 10));
+    cond->appendInstruction(std::make_unique<BinOpInst>(t2, t1, ten, TokenType::Less));
+    cond->appendInstruction(std::make_unique<CondBrInst>(t2, "body", "exit"));
+
+    auto body = std::make_unique<BasicBlock>("body");
+    body->appendInstruction(std::make_unique<LoadInst>(t3, s));
+    body->appendInstruction(std::make_unique<LoadInst>(t4, i));
+    body->appendInstruction(std::make_unique<BinOpInst>(t5, t3, t4, TokenType::Plus));
+    body->appendInstruction(std::make_unique<StoreInst>(t5, s));
+    body->appendInstruction(std::make_unique<ConstIntInst>(one, 1));
+    body->appendInstruction(std::make_unique<BinOpInst>(t6, t4, one, TokenType::Plus));
+    body->appendInstruction(std::make_unique<StoreInst>(t6, i));
+    body->appendInstruction(std::make_unique<BrInst>("cond"));
+
+    f->appendBlock(std::move(entry));
+    f->appendBlock(std::move(exit));
+    f->appendBlock(std::move(cond));
+    f->appendBlock(std::move(body));
+    mirModule.appendFunction(std::move(func));
+}
+
+void testDominators() {
+    MIRModule mirModule;
+    buildLoop(mirModule);
+    DominatorTree domTree(*mirModule.getFunction("main"));
+
+    // Blocks are numbered in reverse post-order, whatever their layout
+    assert(domTree.getNumBlocks() == 4);
+    assert(domTree.getBlock(0)->getName() == "entry");
+    size_t cond = domTree.indexOf(mirModule.getFunction("main")->getBlocks()[2].get());
+    size_t body = domTree.indexOf(mirModule.getFunction("main")->getBlocks()[3].get());
+    assert(domTree.getIdom(cond) == 0 && domTree.getIdom(body) == cond);
+    assert(domTree.dominates(cond, body) && !domTree.dominates(body, cond));
+    assert(domTree.getPredecessors(cond).size() == 2);
+    assert(domTree.getFrontier(body) == std::vector<size_t>{cond});
+    assert(domTree.getFrontier(cond) == std::vector<size_t>{cond});
+
+    std::cout << "testDominators passed!" << std::endl;
+}
+
+void testPromoteLoop() {
+    MIRModule mirModule;
+    buildLoop(mirModule);
+    unsigned promoted = promoteAllocas(mirModule);
+    assert(promoted == 2);
+
+    const MIRFunction& func = *mirModule.getFunction("main");
+    assert(countKind(func, MIRInstructionKind::Alloca) == 0);
+    assert(countKind(func, MIRInstructionKind::Load) == 0);
+    assert(countKind(func, MIRInstructionKind::Store) == 0);
+    assert(countKind(func, MIRInstructionKind::Phi) == 2);
+
+    const auto& condInsts = func.getBlocks()[2]->getInstructions();
+    assert(condInsts[0]->getKind() == MIRInstructionKind::Phi);
+    assert(condInsts[1]->getKind() == MIRInstructionKind::Phi);
+    auto& phi = static_cast<const PhiInst&>(*condInsts[0]);
+    assert(phi.getIncomings().size() == 2);
+    assert(phi.getIncomings()[0].block == "entry" && phi.getIncomings()[1].block == "body");
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "mem2reg_loop");
+    assert(exitCode == 45);
+
+    std::cout << "testPromoteLoop passed!" << std::endl;
+}
+
+// fn main(): i32 { let x = 1; let y = 1; let u: i32; if (c) { x = 2; y = 2; } u; return x; }
+void testPromoteDiamond() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID x = f->createValue("%x", Type::getI32());
+    ValueID y = f->createValue("%y", Type::getI32());
+    ValueID u = f->createValue("%u", Type::getI32());
+    ValueID one = f->createTemp(), two = f->createTemp(), c = f->createTemp(), t = f->createTemp(), v = f->createTemp();
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<AllocaInst>(x, Type::getI32()));
+    entry->appendInstruction(std::make_unique<AllocaInst>(y, Type::getI32()));
+    entry->appendInstruction(std::make_unique<AllocaInst>(u, Type::getI32()));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(one, 1));
+    entry->appendInstruction(std::make_unique<StoreInst>(one, x));
+    entry->appendInstruction(std::make_unique<StoreInst>(one, y));
+    entry->appendInstruction(std::make_unique<ConstBoolInst>(c, true));
+    entry->appendInstruction(std::make_unique<CondBrInst>(c, "then", "merge"));
+
+    auto then = std::make_unique<BasicBlock>("then");
+    then->appendInstruction(std::make_unique<ConstIntInst>(two, 2));
+    then->appendInstruction(std::make_unique<StoreInst>(two, x));
+    then->appendInstruction(std::make_unique<StoreInst>(two, y));
+    then->appendInstruction(std::make_unique<BrInst>("merge"));
+
+    // u is read before anything is stored to it, so it stays in memory
+    auto merge = std::make_unique<BasicBlock>("merge");
+    merge->appendInstruction(std::make_unique<LoadInst>(v, u));
+    merge->appendInstruction(std::make_unique<LoadInst>(t, x));
+    merge->appendInstruction(std::make_unique<ReturnInst>(t));
+
+    f->appendBlock(std::move(entry));
+    f->appendBlock(std::move(then));
+    f->appendBlock(std::move(merge));
+    mirModule.appendFunction(std::move(func));
+
+    unsigned promoted = promoteAllocas(mirModule);
+    assert(promoted == 2);
+    const MIRFunction& result = *mirModule.getFunction("main");
+    assert(countKind(result, MIRInstructionKind::Alloca) == 1);
+    assert(countKind(result, MIRInstructionKind::Load) == 1);
+
+    // Nothing reads y after the merge, so only x needs a phi
+    const auto& mergeInsts = result.getBlocks()[2]->getInstructions();
+    assert(countKind(result, MIRInstructionKind::Phi) == 1);
+    auto& phi = static_cast<const PhiInst&>(*mergeInsts[0]);
+    assert(phi.getIncomings().size() == 2);
+    assert(static_cast<const ReturnInst&>(*mergeInsts.back()).getVal() == phi.getDest());
+    assert(result.getValueName(phi.getDest()) == "%x.1");
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "mem2reg_diamond");
+    assert(exitCode == 2);
+
+    std::cout << "testPromoteDiamond passed!" << std::endl;
+}
+
+// fn f(): i32 { let p = 1; let q = &p; let r: i64 = 1; return 0; }
+void testAddressTakenStays() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("f", Type::getI32());
+    auto* f = func.get();
+    ValueID p = f->createValue("%p", Type::getI32());
+    ValueID q = f->createValue("%q", PointerType::get(Type::getI32()));
+    ValueID r = f->createValue("%r", Type::getI64());
+    ValueID one = f->createTemp(), zero = f->createTemp();
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<AllocaInst>(p, Type::getI32()));
+    entry->appendInstruction(std::make_unique<AllocaInst>(q, PointerType::get(Type::getI32())));
+    entry->appendInstruction(std::make_unique<AllocaInst>(r, Type::getI64()));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(one, 1));
+    entry->appendInstruction(std::make_unique<StoreInst>(one, p));
+    entry->appendInstruction(std::make_unique<StoreInst>(p, q));
+    entry->appendInstruction(std::make_unique<StoreInst>(one, r));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    entry->appendInstruction(std::make_unique<ReturnInst>(zero));
+    f->appendBlock(std::move(entry));
+    mirModule.appendFunction(std::move(func));
+
+    // p has its address stored, q holds the alloca (typed i32 by codegen, not i32*),
+    // and r is stored an i32 constant codegen would not widen
+    unsigned promoted = promoteAllocas(mirModule);
+    assert(promoted == 0);
+    assert(countKind(*mirModule.getFunction("f"), MIRInstructionKind::Store) == 3);
+
+    std::cout << "testAddressTakenStays passed!" << std::endl;
+}
+
+int main() {
+    testDominators();
+    testPromoteLoop();
+    testPromoteDiamond();
+    testAddressTakenStays();
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include "MIR/Passes.h"
+#include "Backend/JIT.h"
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+using namespace chtholly;
+
+static size_t countKind(const MIRFunction& func, MIRInstructionKind kind) {
+    size_t count = 0;
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getKind() == kind) ++count;
+        }
+    }
+    return count;
+}
+
+static bool runPass(MIRModule& mirModule, std::unique_ptr<FunctionPass> pass) {
+    PassManager passManager;
+    passManager.addPass(std::move(pass));
+    return passManager.run(mirModule);
+}
+
+// The instruction defining `value` in a single-block function
+static const MIRInstruction* definition(const MIRFunction& func, ValueID value) {
+    for (const auto& block : func.getBlocks()) {
+        for (const auto& inst : block->getInstructions()) {
+            if (inst->getResult() == value) return inst.get();
+        }
+    }
+    return nullptr;
+}
+
+void testConstantFolding() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID six = f->createTemp(), seven = f->createTemp(), zero = f->createTemp();
+    ValueID product = f->createTemp(), diff = f->createTemp(), greater = f->createTemp(), negated = f->createTemp();
+    ValueID quotient = f->createTemp(), notGreater = f->createTemp();
+
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<ConstIntInst>(six, 6));
+    block->appendInstruction(std::make_unique<ConstIntInst>(seven, 7));
+    block->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    block->appendInstruction(std::make_unique<BinOpInst>(product, six, seven, TokenType::Star));
+    block->appendInstruction(std::make_unique<BinOpInst>(diff, product, six, TokenType::Minus));
+    block->appendInstruction(std::make_unique<BinOpInst>(greater, diff, seven, TokenType::Greater));
+    block->appendInstruction(std::make_unique<UnaryOpInst>(negated, diff, TokenType::Minus));
+    block->appendInstruction(std::make_unique<UnaryOpInst>(notGreater, greater, TokenType::Not));
+    block->appendInstruction(std::make_unique<BinOpInst>(quotient, six, zero, TokenType::Slash));
+    block->appendInstruction(std::make_unique<ReturnInst>(diff));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+
+    bool changed = runPass(mirModule, std::make_unique<ConstantFolding>());
+    assert(changed);
+    const MIRFunction& result = *mirModule.getFunction("main");
+    assert(static_cast<const ConstIntInst*>(definition(result, diff))->getValue() == 36);
+    assert(static_cast<const ConstIntInst*>(definition(result, negated))->getValue() == -36);
+    assert(static_cast<const ConstBoolInst*>(definition(result, greater))->getValue());
+    assert(!static_cast<const ConstBoolInst*>(definition(result, notGreater))->getValue());
+    // Division by zero is left for the program to hit
+    assert(definition(result, quotient)->getKind() == MIRInstructionKind::BinOp);
+
+    std::cout << "testConstantFolding passed!" << std::endl;
+}
+
+// fn main(): i32 { if (true) { x = 1 } else { x = 2 }; return x; } plus a block nothing branches to
+void testUnreachableBlocks() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID cond = f->createTemp(), one = f->createTemp(), two = f->createTemp(), x = f->createValue("%x", Type::getI32());
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<ConstBoolInst>(cond, true));
+    entry->appendInstruction(std::make_unique<CondBrInst>(cond, "then", "else"));
+    auto then = std::make_unique<BasicBlock>("then");
+    then->appendInstruction(std::make_unique<ConstIntInst>(one, 1));
+    then->appendInstruction(std::make_unique<BrInst>("merge"));
+    auto otherwise = std::make_unique<BasicBlock>("else");
+    otherwise->appendInstruction(std::make_unique<ConstIntInst>(two, 2));
+    otherwise->appendInstruction(std::make_unique<BrInst>("merge"));
+    auto orphan = std::make_unique<BasicBlock>("orphan");
+    orphan->appendInstruction(std::make_unique<BrInst>("merge"));
+    auto merge = std::make_unique<BasicBlock>("merge");
+    auto phi = std::make_unique<PhiInst>(x, Type::getI32());
+    phi->addIncoming("then", one);
+    phi->addIncoming("else", two);
+    phi->addIncoming("orphan", NoValue);
+    merge->appendInstruction(std::move(phi));
+    merge->appendInstruction(std::make_unique<ReturnInst>(x));
+
+    f->appendBlock(std::move(entry));
+    f->appendBlock(std::move(then));
+    f->appendBlock(std::move(otherwise));
+    f->appendBlock(std::move(orphan));
+    f->appendBlock(std::move(merge));
+    mirModule.appendFunction(std::move(func));
+
+    bool changed = runPass(mirModule, std::make_unique<UnreachableBlockElim>());
+    assert(changed);
+    const MIRFunction& result = *mirModule.getFunction("main");
+    assert(result.getBlocks().size() == 3);
+    assert(result.getBlocks()[0]->getInstructions().back()->getKind() == MIRInstructionKind::Br);
+    auto& merged = static_cast<const PhiInst&>(*result.getBlocks()[2]->getInstructions()[0]);
+    assert(merged.getIncomings().size() == 1 && merged.getIncomings()[0].block == "then");
+
+    // Nothing left to remove
+    assert(!runPass(mirModule, std::make_unique<UnreachableBlockElim>()));
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "unreachable_blocks");
+    assert(exitCode == 1);
+
+    std::cout << "testUnreachableBlocks passed!" << std::endl;
+}
+
+void testCopyPropagation() {
+    MIRModule mirModule;
+    auto callee = std::make_unique<MIRFunction>("touch", Type::getVoid());
+    callee->addParameter("p", PointerType::get(Type::getI32()));
+    mirModule.appendFunction(std::move(callee));
+
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID a = f->createValue("%a", Type::getI32());
+    ValueID b = f->createValue("%b", Type::getI64());
+    ValueID five = f->createTemp(), again = f->createTemp(), copy = f->createTemp();
+    ValueID first = f->createTemp(), second = f->createTemp(), third = f->createTemp(), wide = f->createTemp();
+    ValueID sum = f->createTemp(), total = f->createTemp();
+
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<AllocaInst>(a, Type::getI32()));
+    block->appendInstruction(std::make_unique<AllocaInst>(b, Type::getI64()));
+    block->appendInstruction(std::make_unique<ConstIntInst>(five, 5));
+    block->appendInstruction(std::make_unique<ConstIntInst>(again, 5));
+    block->appendInstruction(std::make_unique<UnaryOpInst>(copy, again, TokenType::Plus));
+    block->appendInstruction(std::make_unique<StoreInst>(copy, a));
+    block->appendInstruction(std::make_unique<StoreInst>(five, b));
+    block->appendInstruction(std::make_unique<LoadInst>(first, a));
+    block->appendInstruction(std::make_unique<LoadInst>(wide, b));
+    block->appendInstruction(std::make_unique<CallInst>(NoValue, "touch", std::vector<ValueID>{a}));
+    block->appendInstruction(std::make_unique<LoadInst>(second, a));
+    block->appendInstruction(std::make_unique<LoadInst>(third, a));
+    block->appendInstruction(std::make_unique<BinOpInst>(sum, first, second, TokenType::Plus));
+    block->appendInstruction(std::make_unique<BinOpInst>(total, sum, third, TokenType::Plus));
+    block->appendInstruction(std::make_unique<ReturnInst>(total));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+
+    bool changed = runPass(mirModule, std::make_unique<CopyPropagation>());
+    assert(changed);
+    const MIRFunction& result = *mirModule.getFunction("main");
+    auto& store = static_cast<const StoreInst&>(*definition(result, five)->getParent()->getInstructions()[5]);
+    auto& sumInst = static_cast<const BinOpInst&>(*definition(result, sum));
+    auto& totalInst = static_cast<const BinOpInst&>(*definition(result, total));
+    // The copy of a repeated constant becomes the first constant
+    assert(store.getSrc() == five);
+    // The first load sees the store; the call may write a, so the second loads again and the third reuses it
+    assert(sumInst.getLeft() == five && sumInst.getRight() == second);
+    assert(totalInst.getRight() == second);
+    // An i32 stored to an i64 slot is not what a load of it reads
+    assert(static_cast<const LoadInst&>(*definition(result, wide)).getSrc() == b);
+
+    std::cout << "testCopyPropagation passed!" << std::endl;
+}
+
+void testDeadCodeElimination() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID slot = f->createValue("%slot", Type::getI32());
+    ValueID kept = f->createValue("%kept", Type::getI32());
+    ValueID one = f->createTemp(), two = f->createTemp(), unused = f->createTemp(), chained = f->createTemp();
+    ValueID loaded = f->createTemp();
+
+    auto block = std::make_unique<BasicBlock>("entry");
+    block->appendInstruction(std::make_unique<AllocaInst>(slot, Type::getI32()));
+    block->appendInstruction(std::make_unique<AllocaInst>(kept, Type::getI32()));
+    block->appendInstruction(std::make_unique<ConstIntInst>(one, 1));
+    block->appendInstruction(std::make_unique<ConstIntInst>(two, 2));
+    block->appendInstruction(std::make_unique<BinOpInst>(unused, one, two, TokenType::Plus));
+    block->appendInstruction(std::make_unique<BinOpInst>(chained, unused, two, TokenType::Star));
+    block->appendInstruction(std::make_unique<StoreInst>(two, slot));
+    block->appendInstruction(std::make_unique<StoreInst>(one, kept));
+    block->appendInstruction(std::make_unique<LoadInst>(loaded, kept));
+    block->appendInstruction(std::make_unique<ReturnInst>(loaded));
+    func->appendBlock(std::move(block));
+    mirModule.appendFunction(std::move(func));
+
+    bool changed = runPass(mirModule, std::make_unique<DeadCodeElimination>());
+    assert(changed);
+    // Left: kept's alloca, the constant stored to it, the store, the load and the return
+    const MIRFunction& result = *mirModule.getFunction("main");
+    assert(result.getBlocks()[0]->getInstructions().size() == 5);
+    assert(countKind(result, MIRInstructionKind::BinOp) == 0);
+    assert(countKind(result, MIRInstructionKind::Alloca) == 1);
+    assert(!definition(result, slot) && !definition(result, two));
+    assert(!runPass(mirModule, std::make_unique<DeadCodeElimination>()));
+
+    std::cout << "testDeadCodeElimination passed!" << std::endl;
+}
+
+// fn main(): i32 { let s = 0; let i = 0; while (i < 4 * 2) { s = s + i; i = i + 1; } if (false) { s = 0; } return s; }
+void testDefaultPipeline() {
+    MIRModule mirModule;
+    auto func = std::make_unique<MIRFunction>("main", Type::getI32());
+    auto* f = func.get();
+    ValueID s = f->createValue("%s", Type::getI32());
+    ValueID i = f->createValue("%i", Type::getI32());
+    ValueID zero = f->createTemp(), four = f->createTemp(), two = f->createTemp(), limit = f->createTemp();
+    ValueID iv = f->createTemp(), less = f->createTemp(), sv = f->createTemp(), iv2 = f->createTemp();
+    ValueID sum = f->createTemp(), one = f->createTemp(), next = f->createTemp(), no = f->createTemp();
+    ValueID zero2 = f->createTemp(), result = f->createTemp();
+
+    auto entry = std::make_unique<BasicBlock>("entry");
+    entry->appendInstruction(std::make_unique<AllocaInst>(s, Type::getI32()));
+    entry->appendInstruction(std::make_unique<AllocaInst>(i, Type::getI32()));
+    entry->appendInstruction(std::make_unique<ConstIntInst>(zero, 0));
+    entry->appendInstruction(std::make_unique<StoreInst>(zero, s));
+    entry->appendInstruction(std::make_unique<StoreInst>(zero, i));
+    entry->appendInstruction(std::make_unique<BrInst>("cond"));
+
+    auto cond = std::make_unique<BasicBlock>("cond");
+    cond->appendInstruction(std::make_unique<LoadInst>(iv, i));
+    cond->appendInstruction(std::make_unique<ConstIntInst>(four, 4));
+    cond->appendInstruction(std::make_unique<ConstIntInst>(two, 2));
+    cond->appendInstruction(std::make_unique<BinOpInst>(limit, four, two, TokenType::Star));
+    cond->appendInstruction(std::make_unique<BinOpInst>(less, iv, limit, TokenType::Less));
+    cond->appendInstruction(std::make_unique<CondBrInst>(less, "body", "exit"));
+
+    auto body = std::make_unique<BasicBlock>("body");
+    body->appendInstruction(std::make_unique<LoadInst>(sv, s));
+    body->appendInstruction(std::make_unique<LoadInst>(iv2, i));
+    body->appendInstruction(std::make_unique<BinOpInst>(sum, sv, iv2, TokenType::Plus));
+    body->appendInstruction(std::make_unique<StoreInst>(sum, s));
+    body->appendInstruction(std::make_unique<ConstIntInst>(one, 1));
+    body->appendInstruction(std::make_unique<BinOpInst>(next, iv2, one, TokenType::Plus));
+    body->appendInstruction(std::make_unique<StoreInst>(next, i));
+    body->appendInstruction(std::make_unique<BrInst>("cond"));
+
+    auto exit = std::make_unique<BasicBlock>("exit");
+    exit->appendInstruction(std::make_unique<ConstBoolInst>(no, false));
+    exit->appendInstruction(std::make_unique<CondBrInst>(no, "reset", "done"));
+
+    auto reset = std::make_unique<BasicBlock>("reset");
+    reset->appendInstruction(std::make_unique<ConstIntInst>(zero2, 0));
+    reset->appendInstruction(std::make_unique<StoreInst>(zero2, s));
+    reset->appendInstruction(std::make_unique<BrInst>("done"));
+
+    auto done = std::make_unique<BasicBlock>("done");
+    done->appendInstruction(std::make_unique<LoadInst>(result, s));
+    done->appendInstruction(std::make_unique<ReturnInst>(result));
+
+    f->appendBlock(std::move(entry));
+    f->appendBlock(std::move(cond));
+    f->appendBlock(std::move(body));
+    f->appendBlock(std::move(exit));
+    f->appendBlock(std::move(reset));
+    f->appendBlock(std::move(done));
+    mirModule.appendFunction(std::move(func));
+
+    std::ostringstream dump;
+    PassManager passManager;
+    addDefaultPasses(passManager);
+    passManager.printAfter("const-fold");
+    passManager.setPrintStream(dump);
+    bool changed = passManager.run(mirModule);
+    assert(changed);
+    assert(dump.str().find("*** MIR after const-fold on main ***") != std::string::npos);
+    assert(dump.str().find("after dce") == std::string::npos);
+
+    const MIRFunction& optimized = *mirModule.getFunction("main");
+    assert(countKind(optimized, MIRInstructionKind::Alloca) == 0);
+    assert(countKind(optimized, MIRInstructionKind::Load) == 0);
+    // reset is gone, so the merge in done has a single incoming value and needs no phi
+    assert(optimized.getBlocks().size() == 5);
+    assert(countKind(optimized, MIRInstructionKind::Phi) == 2);
+    // 4 * 2 is folded; the constants left are 0, 8 and 1
+    assert(countKind(optimized, MIRInstructionKind::ConstInt) == 3);
+    assert(countKind(optimized, MIRInstructionKind::ConstBool) == 0);
+
+    CodeGenerator codeGen(mirModule);
+    codeGen.generate();
+    JIT jit;
+    int exitCode = jit.runMain(codeGen, "default_pipeline");
+    assert(exitCode == 28);
+
+    std::cout << "testDefaultPipeline passed!" << std::endl;
+}
+
+int main() {
+    testConstantFolding();
+    testUnreachableBlocks();
+    testCopyPropagation();
+    testDeadCodeElimination();
+    testDefaultPipeline();
+    return 0;
+}
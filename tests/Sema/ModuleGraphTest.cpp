@@ -0,0 +1,162 @@
+#include "Sema/ModuleGraph.h"
+#include "Sema/Sema.h"
+#include "Parser.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace chtholly;
+
+namespace {
+
+void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+size_t indexOfFunction(const std::vector<ASTNode*>& nodes, const std::string& name) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i]->getKind() == ASTNodeKind::FunctionDecl &&
+            static_cast<FunctionDecl*>(nodes[i])->getName() == name) {
+            return i;
+        }
+    }
+    return nodes.size();
+}
+
+} // namespace
+
+void testDiamondImports() {
+    // main -> left, right; left -> base; right -> base
+    writeFile("graph_base.cns", "pub fn one(): i32 { return 1; }\n");
+    writeFile("graph_left.cns", "import \"graph_base.cns\";\nuse graph_base::one;\npub fn two(): i32 { return one() + one(); }\n");
+    writeFile("graph_right.cns", "import \"graph_base.cns\";\nuse graph_base::one;\npub fn three(): i32 { return one() + 2; }\n");
+
+    std::string source =
+        "import \"graph_left.cns\";\n"
+        "import \"graph_right.cns\" as r;\n"
+        "use graph_left::two;\n"
+        "use r::three;\n"
+        "fn main(): i32 { return two() + three(); }\n";
+    Parser parser(source);
+    auto program = parser.parseProgram();
+
+    ModuleGraph graph(4);
+    graph.build(program);
+    assert(graph.getNumModules() == 3);
+    assert(graph.find("graph_base.cns")->symbols);
+    assert(graph.find("graph_right.cns")->name == "r");
+    assert(graph.find("graph_missing.cns") == nullptr);
+
+    Sema sema;
+    sema.adoptModules(graph);
+    for (auto& node : program) {
+        sema.analyze(node.get());
+    }
+    assert(sema.getModules().count("graph_left"));
+    assert(sema.getModules().count("r"));
+
+    // Each module's declarations are listed once, dependencies first, with mangled names
+    auto& nodes = sema.getModuleNodes();
+    size_t base = indexOfFunction(nodes, "graph_base_one");
+    size_t left = indexOfFunction(nodes, "graph_left_two");
+    size_t right = indexOfFunction(nodes, "r_three");
+    assert(base < left && base < right && right < nodes.size());
+
+    std::filesystem::remove("graph_base.cns");
+    std::filesystem::remove("graph_left.cns");
+    std::filesystem::remove("graph_right.cns");
+
+    std::cout << "testDiamondImports passed!" << std::endl;
+}
+
+void testGraphErrors() {
+    writeFile("graph_cycle_a.cns", "import \"graph_cycle_b.cns\";\n");
+    writeFile("graph_cycle_b.cns", "import \"graph_cycle_a.cns\";\n");
+    std::string cycle = "import \"graph_cycle_a.cns\";\n";
+    Parser cycleParser(cycle);
+    auto cycleProgram = cycleParser.parseProgram();
+    bool threw = false;
+    try {
+        ModuleGraph graph(2);
+        graph.build(cycleProgram);
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()).find("Import cycle") != std::string::npos;
+    }
+    assert(threw);
+
+    std::string missing = "import \"graph_nowhere.cns\";\n";
+    Parser missingParser(missing);
+    auto missingProgram = missingParser.parseProgram();
+    threw = false;
+    try {
+        ModuleGraph graph(2);
+        graph.build(missingProgram);
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()).find("Could not open imported file") != std::string::npos;
+    }
+    assert(threw);
+
+    std::filesystem::remove("graph_cycle_a.cns");
+    std::filesystem::remove("graph_cycle_b.cns");
+
+    std::cout << "testGraphErrors passed!" << std::endl;
+}
+
+void testModuleCacheReuse() {
+    writeFile("graph_base.cns", "pub fn one(): i32 { return 1; }\n");
+    writeFile("graph_left.cns", "import \"graph_base.cns\";\nuse graph_base::one;\npub fn two(): i32 { return one() + one(); }\n");
+
+    // Builds the way each --serve request does; true if the importer's function is there to lower
+    ModuleCache cache;
+    bool baseReused = false, leftReused = false;
+    auto build = [&](const std::string& source, const std::string& mangledTwo) {
+        Parser parser(source);
+        auto program = parser.parseProgram();
+        ModuleGraph graph(2);
+        graph.setModuleCache(&cache);
+        graph.build(program);
+        baseReused = graph.find("graph_base.cns")->cached != nullptr;
+        leftReused = graph.find("graph_left.cns")->cached != nullptr;
+
+        Sema sema;
+        sema.adoptModules(graph);
+        for (auto& node : program) {
+            sema.analyze(node.get());
+        }
+        return indexOfFunction(sema.getModuleNodes(), mangledTwo) < sema.getModuleNodes().size();
+    };
+
+    std::string source = "import \"graph_left.cns\";\nuse graph_left::two;\nfn main(): i32 { return two(); }\n";
+    bool lowered = build(source, "graph_left_two");
+    assert(lowered && !baseReused && !leftReused && cache.size() == 2);
+
+    // Nothing changed: both modules come from the cache, bodies included
+    lowered = build(source, "graph_left_two");
+    assert(lowered && baseReused && leftReused);
+
+    // A change to the base invalidates the base and everything importing it
+    writeFile("graph_base.cns", "pub fn one(): i32 { return 2; }\n");
+    lowered = build(source, "graph_left_two");
+    assert(lowered && !baseReused && !leftReused);
+    lowered = build(source, "graph_left_two");
+    assert(lowered && baseReused && leftReused);
+
+    // Imported under another name, a module is mangled differently and analyzed again
+    std::string aliased = "import \"graph_left.cns\" as l;\nuse l::two;\nfn main(): i32 { return two(); }\n";
+    lowered = build(aliased, "l_two");
+    assert(lowered && baseReused && !leftReused);
+
+    std::filesystem::remove("graph_base.cns");
+    std::filesystem::remove("graph_left.cns");
+
+    std::cout << "testModuleCacheReuse passed!" << std::endl;
+}
+
+int main() {
+    testDiamondImports();
+    testGraphErrors();
+    testModuleCacheReuse();
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "Sema/ModuleInterface.h"
+#include "Sema/ModuleGraph.h"
+#include "Sema/Sema.h"
+#include "AST/Declarations.h"
+#include "Parser.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace chtholly;
+
+namespace {
+
+void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+// Builds a graph for `source` with interfaces kept in `dir`, the way -fsyntax-only does
+bool analyzeWithCache(const std::string& source, const std::string& dir, bool& baseFromInterface, bool& midFromInterface) {
+    Parser parser(source);
+    auto program = parser.parseProgram();
+    ModuleGraph graph(2);
+    graph.setInterfaceDir(dir);
+    graph.setDeclarationsOnly(true);
+    graph.build(program);
+    baseFromInterface = graph.find("iface_base.cns")->interface.has_value();
+    midFromInterface = graph.find("iface_mid.cns")->interface.has_value();
+
+    Sema sema;
+    sema.adoptModules(graph);
+    try {
+        for (auto& node : program) {
+            sema.analyze(node.get());
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void testRoundTrip() {
+    std::string source =
+        "pub struct Point { let x: i32; let y: i32 }\n"
+        "pub enum Shape { Dot, Circle(i32) }\n"
+        "pub struct Pair[T] { let first: T; let second: T }\n"
+        "pub fn area(p: Point*): bool { return true; }\n"
+        "struct Hidden { let v: i32 }\n";
+    Parser parser(source);
+    auto program = parser.parseProgram();
+    Sema sema;
+    for (auto& node : program) {
+        sema.analyze(node.get());
+    }
+
+    auto interface = ModuleInterface::fromSymbolTable(42, sema.getSymbolTable());
+    assert(interface);
+    assert(interface->genericDecls.size() == 1);
+    std::string bytes = interface->serialize();
+
+    auto loaded = ModuleInterface::deserialize(bytes);
+    assert(loaded);
+    assert(loaded->sourceHash == 42);
+    assert(loaded->serialize() == bytes);
+
+    std::vector<std::unique_ptr<ASTNode>> decls;
+    auto table = loaded->toSymbolTable(decls);
+    assert(table->lookupType("Hidden") == nullptr);
+
+    auto point = std::static_pointer_cast<StructType>(table->lookupType("Point"));
+    assert(point->getFields().size() == 2 && point->getFields()[1].type->isI32());
+    auto shape = std::static_pointer_cast<EnumType>(table->lookupType("Shape"));
+    assert(shape->findVariant("Circle")->tupleTypes.size() == 1);
+
+    auto area = std::static_pointer_cast<FunctionType>(table->lookup("area")->type);
+    assert(area->getReturnType()->isBool());
+    assert(area->getParamTypes()[0]->toString() == "Point*");
+
+    auto* pair = table->lookupTypeDecl("Pair");
+    assert(pair && pair->getKind() == ASTNodeKind::StructDecl);
+    assert(static_cast<StructDecl*>(pair)->getGenericParams().size() == 1);
+    assert(decls.size() == 1);
+
+    std::cout << "testRoundTrip passed!" << std::endl;
+}
+
+void testMalformedInterfaces() {
+    ModuleInterface interface;
+    interface.sourceHash = 7;
+    interface.symbols.push_back({"f", FunctionType::get({Type::getI32()}, Type::getVoid())});
+    std::string bytes = interface.serialize();
+    assert(ModuleInterface::deserialize(bytes));
+
+    for (size_t size = 0; size < bytes.size(); ++size) {
+        assert(!ModuleInterface::deserialize(std::string_view(bytes).substr(0, size)));
+    }
+    std::string badMagic = bytes;
+    badMagic[0] = 'X';
+    assert(!ModuleInterface::deserialize(badMagic));
+    assert(!ModuleInterface::deserialize(bytes + "!"));
+    assert(!ModuleInterface::read("iface_missing.cnsi"));
+
+    std::cout << "testMalformedInterfaces passed!" << std::endl;
+}
+
+void testGraphReusesUnchangedImports() {
+    std::string dir = "iface_cache";
+    std::filesystem::remove_all(dir);
+    writeFile("iface_base.cns", "pub struct Point { let x: i32; let y: i32 }\n");
+    writeFile("iface_mid.cns", "import \"iface_base.cns\";\nuse iface_base::Point;\npub fn origin(): Point { return Point { x: 0, y: 0 }; }\n");
+    std::string source =
+        "import \"iface_mid.cns\";\n"
+        "use iface_mid::origin;\n"
+        "fn main(): i32 { let p = origin(); return p.x; }\n";
+
+    bool base = true, mid = true;
+    bool analyzed = analyzeWithCache(source, dir, base, mid);
+    assert(analyzed && !base && !mid);
+    assert(std::filesystem::exists(dir));
+
+    // Nothing changed: both imports come from their interfaces
+    analyzed = analyzeWithCache(source, dir, base, mid);
+    assert(analyzed && base && mid);
+
+    // A change to the base invalidates the base and everything importing it
+    writeFile("iface_base.cns", "pub struct Point { let x: i32; let y: i32 }\npub fn unit(): i32 { return 1; }\n");
+    analyzed = analyzeWithCache(source, dir, base, mid);
+    assert(analyzed && !base && !mid);
+    analyzed = analyzeWithCache(source, dir, base, mid);
+    assert(analyzed && base && mid);
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove("iface_base.cns");
+    std::filesystem::remove("iface_mid.cns");
+
+    std::cout << "testGraphReusesUnchangedImports passed!" << std::endl;
+}
+
+int main() {
+    testRoundTrip();
+    testMalformedInterfaces();
+    testGraphReusesUnchangedImports();
+    return 0;
+}